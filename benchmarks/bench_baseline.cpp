@@ -0,0 +1,186 @@
+// Замеры тех же операций на std::any, std::variant и std::shared_ptr
+// для сравнения с объектами, "коробками" и "верёвками"
+
+#include <dot/test.h>
+#include <any>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        const string long_text = "Строка длиннее внутреннего буфера объекта";
+
+        typedef std::variant<std::monostate, int, double, string> variant;
+    }
+
+// -- std::any против object --
+
+    DOT_BENCHMARK(any_construct_int)
+    {
+        int value = 12345;
+        while (loop.next())
+        {
+            std::any created(value);
+            test::benchmark::keep(created);
+        }
+    }
+
+    DOT_BENCHMARK(any_construct_string)
+    {
+        while (loop.next())
+        {
+            std::any created(long_text);
+            test::benchmark::keep(created);
+        }
+    }
+
+    DOT_BENCHMARK(any_copy_int)
+    {
+        const std::any source(12345);
+        while (loop.next())
+        {
+            std::any copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    // копия std::any копирует строку целиком, в отличие от объекта
+    DOT_BENCHMARK(any_copy_string)
+    {
+        const std::any source(long_text);
+        while (loop.next())
+        {
+            std::any copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(any_move_int)
+    {
+        std::any first(12345);
+        std::any second;
+        while (loop.next())
+        {
+            second = std::move(first);
+            first = std::move(second);
+            test::benchmark::keep(first);
+        }
+    }
+
+    DOT_BENCHMARK(any_reset_int)
+    {
+        std::any target;
+        while (loop.next())
+        {
+            target = 12345;
+            target.reset();
+            test::benchmark::keep(target);
+        }
+    }
+
+    DOT_BENCHMARK(any_cast_int)
+    {
+        const std::any source(12345);
+        while (loop.next())
+        {
+            test::benchmark::keep(&source);
+            test::benchmark::keep(*std::any_cast<int>(&source));
+        }
+    }
+
+    DOT_BENCHMARK(any_cast_other)
+    {
+        const std::any source(12345);
+        while (loop.next())
+        {
+            test::benchmark::keep(&source);
+            test::benchmark::keep(std::any_cast<double>(&source));
+        }
+    }
+
+    DOT_BENCHMARK(any_get_string)
+    {
+        const std::any source(long_text);
+        while (loop.next())
+        {
+            string copy = std::any_cast<const string&>(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+// -- std::variant против object --
+
+    DOT_BENCHMARK(variant_construct_int)
+    {
+        int value = 12345;
+        while (loop.next())
+        {
+            variant created(value);
+            test::benchmark::keep(created);
+        }
+    }
+
+    DOT_BENCHMARK(variant_copy_int)
+    {
+        const variant source(12345);
+        while (loop.next())
+        {
+            variant copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(variant_copy_string)
+    {
+        const variant source(long_text);
+        while (loop.next())
+        {
+            variant copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(variant_get_if_int)
+    {
+        const variant source(12345);
+        while (loop.next())
+        {
+            test::benchmark::keep(&source);
+            test::benchmark::keep(*std::get_if<int>(&source));
+        }
+    }
+
+// -- std::shared_ptr против rope --
+
+    DOT_BENCHMARK(shared_ptr_copy)
+    {
+        const std::shared_ptr<const string> source = std::make_shared<const string>(long_text);
+        while (loop.next())
+        {
+            std::shared_ptr<const string> copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    // копирование при записи вручную, как rope<T>::touch() общей "верёвки"
+    DOT_BENCHMARK(shared_ptr_copy_and_touch)
+    {
+        const std::shared_ptr<string> source = std::make_shared<string>(long_text);
+        while (loop.next())
+        {
+            std::shared_ptr<string> copy(source);
+            if (copy.use_count() > 1)
+                copy = std::make_shared<string>(*copy);
+            (*copy)[0] = 'C';
+            test::benchmark::keep(copy);
+        }
+    }
+}
+
+// Здесь должен быть Unicode
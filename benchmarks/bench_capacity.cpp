@@ -0,0 +1,151 @@
+// Замеры объектов разной ёмкости буфера: память на значение
+// и пропускная способность заполнения и чтения массива объектов
+
+#include <dot/test.h>
+#include <dot/box.h>
+#include <dot/rope.h>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        // 3 double и метка: значение геометрических данных
+        struct tagged_point
+        {
+            double x, y, z;
+            int64 tag;
+
+            bool operator == (const tagged_point& another) const noexcept
+            {
+                return x == another.x && y == another.y && z == another.z && tag == another.tag;
+            }
+
+            bool operator < (const tagged_point& another) const noexcept
+            {
+                return tag < another.tag;
+            }
+        };
+
+        // виды значений: ключ в одно int64 и точка в 32 байта
+        enum class workload
+        {
+            key,
+            point
+        };
+
+        const char* workload_name(workload kind)
+        {
+            return kind == workload::key ? "key" : "point";
+        }
+
+        // объектов в массиве на одну итерацию замера
+        constexpr std::size_t values_count = 1000;
+    }
+
+    template<> DOT_CLASS_ID(box<tagged_point>::cat)
+    template<> DOT_CLASS_ID(rope<tagged_point>::cow)
+
+    namespace
+    {
+        // замер одной клетки матрицы: ёмкость, вид значений и заполнение либо чтение;
+        // итерация замера проходит весь массив из values_count объектов
+        template <std::size_t capacity>
+        class capacity_benchmark : public test::benchmark
+        {
+        public:
+            typedef basic_object<capacity> object_type;
+
+            capacity_benchmark(workload kind, bool scan)
+                : my_kind(kind),
+                  my_scan(scan),
+                  my_name(string("object_capacity_") + std::to_string(capacity) + "_" + workload_name(kind) + (scan ? "_scan" : "_fill"))
+            {
+            }
+
+            virtual const char* name() const noexcept override
+            {
+                return my_name.c_str();
+            }
+
+            virtual void run(test::benchmark::loop& loop) override
+            {
+                std::vector<object_type> values;
+                values.reserve(values_count);
+                if (!my_scan)
+                {
+                    while (loop.next())
+                    {
+                        values.clear();
+                        fill(values);
+                        test::benchmark::keep(values.data());
+                    }
+                    return;
+                }
+                fill(values);
+                while (loop.next())
+                {
+                    int64 total = 0;
+                    for (const object_type& value : values)
+                        total += my_kind == workload::key ? value.template get_as<int64>() : value.template get_as<tagged_point>().tag;
+                    test::benchmark::keep(total);
+                }
+            }
+
+            // размер объекта, где лежит значение, и время на один объект
+            virtual void describe(const measurement& result, std::ostream& stream) const override
+            {
+                const bool boxed = my_kind == workload::key ? boxed_class<int64, capacity>::value
+                    : boxed_class<tagged_point, capacity>::value;
+                stream << ", объект " << sizeof(object_type) << " байт, значение "
+                    << (boxed ? "в буфере" : "по ссылке") << std::setprecision(2)
+                    << ", " << result.nanoseconds / values_count << " нс/объект";
+            }
+
+        private:
+            workload my_kind;
+            bool my_scan;
+            string my_name;
+
+            void fill(std::vector<object_type>& values) const
+            {
+                for (std::size_t index = 0; index < values_count; ++index)
+                {
+                    const int64 number = static_cast<int64>(index);
+                    if (my_kind == workload::key)
+                        values.emplace_back(number);
+                    else
+                        values.emplace_back(tagged_point{ 1.0, 2.0, 3.0, number });
+                }
+            }
+        };
+
+        template <std::size_t capacity>
+        std::deque<capacity_benchmark<capacity>>& matrix()
+        {
+            static std::deque<capacity_benchmark<capacity>> instances;
+            return instances;
+        }
+
+        template <std::size_t capacity>
+        bool register_capacity()
+        {
+            for (workload kind : { workload::key, workload::point })
+                for (bool scan : { false, true })
+                    matrix<capacity>().emplace_back(kind, scan);
+            return true;
+        }
+
+        // ёмкости от ключа в одно int64 до точки из 4 double с запасом
+        const bool matrix_registered = register_capacity<8>() && register_capacity<16>()
+            && register_capacity<32>() && register_capacity<48>();
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,16 @@
+// Запуск всех замеров производительности без ожидания пользователя
+
+#include <dot/test.h>
+#include <dot/allocations.h>
+
+// выделения памяти на операцию считаются через подменённый operator new
+DOT_TRACE_ALLOCATIONS_HOOK
+
+int main(int argc, char* argv[])
+{
+    dot::test::settings defaults;
+    defaults.benchmarks = true;
+    return dot::test::main(argc, argv, defaults);
+}
+
+// Здесь должен быть Unicode
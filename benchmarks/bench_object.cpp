@@ -0,0 +1,347 @@
+// Замеры основных операций объектов, "коробок" и "верёвок"
+
+#include <dot/test.h>
+#include <dot/box.h>
+#include <dot/rope.h>
+#include <dot/string.h>
+#include <dot/visit.h>
+#include <dot/registry.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        // строка длиннее внутреннего буфера объекта хранится в "верёвке"
+        const string long_text = "Строка длиннее внутреннего буфера объекта";
+
+        // смесь типов данных для обхода, строки в конце цепочки проверок
+        struct visit_mix
+        {
+            static constexpr std::size_t size = 5;
+            const object values[size] = { object(12345), object(2.5), object(true), object(7LL), object(long_text) };
+        };
+    }
+
+// -- объект --
+
+    DOT_BENCHMARK(object_construct_int)
+    {
+        int value = 12345;
+        while (loop.next())
+        {
+            object created(value);
+            test::benchmark::keep(created);
+        }
+    }
+
+    DOT_BENCHMARK(object_construct_string)
+    {
+        while (loop.next())
+        {
+            object created(long_text);
+            test::benchmark::keep(created);
+        }
+    }
+
+    DOT_BENCHMARK(object_copy_int)
+    {
+        const object source(12345);
+        while (loop.next())
+        {
+            object copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(object_copy_string)
+    {
+        const object source(long_text);
+        while (loop.next())
+        {
+            object copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(object_move_int)
+    {
+        object first(12345);
+        object second;
+        while (loop.next())
+        {
+            second = std::move(first);
+            first = std::move(second);
+            test::benchmark::keep(first);
+        }
+    }
+
+    DOT_BENCHMARK(object_move_string)
+    {
+        object first(long_text);
+        object second;
+        while (loop.next())
+        {
+            second = std::move(first);
+            first = std::move(second);
+            test::benchmark::keep(first);
+        }
+    }
+
+    // перевыделения вектора переносят объекты; итерация - вектор из тысячи объектов
+    DOT_BENCHMARK(object_vector_growth)
+    {
+        const object number(12345);
+        const object text(long_text);
+        while (loop.next())
+        {
+            std::vector<object> values;
+            for (int index = 0; index < 1000; ++index)
+                values.push_back(index % 4 ? number : text);
+            test::benchmark::keep(values.data());
+        }
+    }
+
+    DOT_BENCHMARK(object_reset_int)
+    {
+        object target;
+        while (loop.next())
+        {
+            target.set_as(12345);
+            target.reset();
+            test::benchmark::keep(target);
+        }
+    }
+
+// -- "коробки" и "верёвки" --
+
+    DOT_BENCHMARK(box_look)
+    {
+        const box<int> source(12345);
+        while (loop.next())
+            test::benchmark::keep(source.look());
+    }
+
+    DOT_BENCHMARK(box_touch)
+    {
+        box<int> target(0);
+        while (loop.next())
+        {
+            ++target.touch();
+            test::benchmark::keep(target);
+        }
+    }
+
+    DOT_BENCHMARK(rope_copy)
+    {
+        const rope<string> source(long_text);
+        while (loop.next())
+        {
+            rope<string> copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    // touch() общей "верёвки" копирует "толстые" данные
+    DOT_BENCHMARK(rope_copy_and_touch)
+    {
+        const rope<string> source(long_text);
+        while (loop.next())
+        {
+            rope<string> copy(source);
+            copy.touch()[0] = 'C';
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(rope_touch_unique)
+    {
+        rope<string> target(long_text);
+        while (loop.next())
+        {
+            ++target.touch()[0];
+            test::benchmark::keep(target);
+        }
+    }
+
+// -- проверка и приведение типа на разной глубине иерархии --
+
+    DOT_BENCHMARK(data_is_object_data)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.is<object::data>());
+        }
+    }
+
+    DOT_BENCHMARK(data_is_cat_based)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.is<box_based::cat_based>());
+        }
+    }
+
+    DOT_BENCHMARK(data_is_box_cat)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.is<box<int>::cat>());
+        }
+    }
+
+    DOT_BENCHMARK(data_is_other_cat)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.is<box<double>::cat>());
+        }
+    }
+
+    DOT_BENCHMARK(data_as_cat_based)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(&data.as<box_based::cat_based>());
+        }
+    }
+
+    DOT_BENCHMARK(data_as_box_cat)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.as<box<int>::cat>().look());
+        }
+    }
+
+    DOT_BENCHMARK(data_try_as_other_cat)
+    {
+        const object source(12345);
+        const object::data& data = source.get_data();
+        while (loop.next())
+        {
+            test::benchmark::keep(&data);
+            test::benchmark::keep(data.try_as<box<double>::cat>().ok());
+        }
+    }
+
+// -- обход по типу данных: цепочка is<...>() против таблицы переходов --
+
+    DOT_BENCHMARK(visit_if_chain)
+    {
+        const visit_mix mix;
+        std::size_t index = 0;
+        while (loop.next())
+        {
+            const object::data& data = mix.values[index].get_data();
+            std::size_t found = 0;
+            if (data.is<box<int>::cat>())
+                found = static_cast<const box<int>::cat&>(data).look();
+            else if (data.is<box<double>::cat>())
+                found = static_cast<std::size_t>(static_cast<const box<double>::cat&>(data).look());
+            else if (data.is<box<bool>::cat>())
+                found = static_cast<const box<bool>::cat&>(data).look();
+            else if (data.is<box<long long>::cat>())
+                found = static_cast<std::size_t>(static_cast<const box<long long>::cat&>(data).look());
+            else if (data.is<rope<string>::cow>())
+                found = static_cast<const rope<string>::cow&>(data).look().size();
+            test::benchmark::keep(found);
+            index = index + 1 < visit_mix::size ? index + 1 : 0;
+        }
+    }
+
+    DOT_BENCHMARK(visit_jump_table)
+    {
+        const visit_mix mix;
+        const auto visitor = overloaded
+        {
+            [](int value) { return static_cast<std::size_t>(value); },
+            [](double value) { return static_cast<std::size_t>(value); },
+            [](bool value) { return static_cast<std::size_t>(value); },
+            [](long long value) { return static_cast<std::size_t>(value); },
+            [](const string& value) { return value.size(); },
+            [](const object&) { return std::size_t(0); }
+        };
+        std::size_t index = 0;
+        while (loop.next())
+        {
+            test::benchmark::keep(visit(mix.values[index], visitor));
+            index = index + 1 < visit_mix::size ? index + 1 : 0;
+        }
+    }
+
+// -- реестр классов: плотный индекс против хеша имени --
+
+    DOT_BENCHMARK(registry_find_index)
+    {
+        const uint64 index = rope<string>::cow::id().index();
+        while (loop.next())
+        {
+            test::benchmark::keep(index);
+            test::benchmark::keep(class_registry::find(index));
+        }
+    }
+
+    DOT_BENCHMARK(registry_find_name)
+    {
+        const char* const name = "rope<string>::cow";
+        while (loop.next())
+        {
+            test::benchmark::keep(name);
+            test::benchmark::keep(class_registry::find(name));
+        }
+    }
+
+// -- строки --
+
+    DOT_BENCHMARK(string_set_as)
+    {
+        object target;
+        while (loop.next())
+        {
+            target.set_as(long_text);
+            test::benchmark::keep(target);
+        }
+    }
+
+    DOT_BENCHMARK(string_get_as)
+    {
+        const object source(long_text);
+        while (loop.next())
+        {
+            string copy = source.get_as<string>();
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(string_data_as_look)
+    {
+        const object source(long_text);
+        while (loop.next())
+            test::benchmark::keep(source.data_as<rope<string>::cow>().look().size());
+    }
+}
+
+// Здесь должен быть Unicode
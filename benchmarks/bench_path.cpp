@@ -0,0 +1,95 @@
+// Замеры выборки по пути против обхода дерева вручную
+
+#include <dot/test.h>
+#include <dot/path.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <string>
+#include <vector>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        // документ из тысячи заказов по десять позиций
+        object make_document()
+        {
+            array orders;
+            for (int order = 0; order < 1000; ++order)
+            {
+                array items;
+                for (int item = 0; item < 10; ++item)
+                {
+                    record position;
+                    position["sku"] = object(string("SKU-") + std::to_string(order * 10 + item));
+                    position["price"] = object(item * 3 + order % 7);
+                    items.push_back(object(std::move(position)));
+                }
+                record entry;
+                entry["id"] = object(order);
+                entry["items"] = object(std::move(items));
+                orders.push_back(object(std::move(entry)));
+            }
+            record root;
+            root["orders"] = object(std::move(orders));
+            return object(std::move(root));
+        }
+
+        const object& document()
+        {
+            static const object instance = make_document();
+            return instance;
+        }
+    }
+
+    DOT_BENCHMARK(path_select_skus)
+    {
+        const object& root = document();
+        const path skus("$.orders[*].items[*].sku");
+        std::vector<object> found;
+        while (loop.next())
+        {
+            found.clear();
+            skus.select(root, found);
+            test::benchmark::keep(found);
+        }
+    }
+
+    // тот же обход вручную через data_as без копирования узлов
+    DOT_BENCHMARK(path_manual_skus)
+    {
+        const object& root = document();
+        std::vector<object> found;
+        while (loop.next())
+        {
+            found.clear();
+            const record& fields = root.data_as<rope<record>::cow>().look();
+            const array& orders = fields.at("orders").data_as<rope<array>::cow>().look();
+            for (const object& order : orders)
+            {
+                const record& order_fields = order.data_as<rope<record>::cow>().look();
+                const array& items = order_fields.at("items").data_as<rope<array>::cow>().look();
+                for (const object& item : items)
+                    found.push_back(item.data_as<rope<record>::cow>().look().at("sku"));
+            }
+            test::benchmark::keep(found);
+        }
+    }
+
+    DOT_BENCHMARK(path_select_filtered)
+    {
+        const object& root = document();
+        const path expensive("$.orders[*].items[?(@.price > 25)].sku");
+        std::vector<object> found;
+        while (loop.next())
+        {
+            found.clear();
+            expensive.select(root, found);
+            test::benchmark::keep(found);
+        }
+    }
+}
+
+// Здесь должен быть Unicode
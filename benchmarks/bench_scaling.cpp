@@ -0,0 +1,291 @@
+// Замеры масштабирования "верёвок" по числу потоков:
+// общая "шея" против своих "верёвок" потоков с ложным разделением линий кэша и без
+
+#include <dot/test.h>
+#include <dot/rope.h>
+#include <dot/string.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        // операции над "верёвкой" в каждой итерации каждого потока
+        enum class mix
+        {
+            copy,   // копия и удаление: два атомарных изменения счётчика "шеи"
+            look,   // только чтение значения без записи в "шею"
+            touch   // копия с изменением: новая "шея" и копия значения
+        };
+
+        // какие "верёвки" получают потоки
+        enum class sharing
+        {
+            shared, // одна общая "шея" на все потоки
+            packed, // свои "шеи" потоков попарно в общих линиях кэша, ложное разделение
+            padded  // свои "шеи", созданные каждым потоком после отступа
+        };
+
+        const char* mix_name(mix operation)
+        {
+            switch (operation)
+            {
+            case mix::copy: return "copy";
+            case mix::look: return "look";
+            default: return "touch";
+            }
+        }
+
+        const char* sharing_name(sharing mode)
+        {
+            switch (mode)
+            {
+            case sharing::shared: return "shared";
+            case sharing::packed: return "packed";
+            default: return "padded";
+            }
+        }
+
+        constexpr std::size_t cache_line = 64;
+
+        // "верёвка" потока в своей линии кэша, чтобы делились только "шеи"
+        struct alignas(cache_line) thread_rope
+        {
+            rope<string> source;
+            std::unique_ptr<char[]> padding;
+        };
+
+        // пропускная способность одного потока для ускорения по числу потоков
+        struct single_thread
+        {
+            mix operation;
+            sharing mode;
+            double per_second;
+        };
+
+        std::vector<single_thread>& single_thread_results()
+        {
+            static std::vector<single_thread> results;
+            return results;
+        }
+
+        // замер одной клетки матрицы: вид операций, вид "верёвок" и число потоков;
+        // итерации замера - операции каждого потока, часы останавливаются после
+        // завершения всех потоков
+        class scaling : public test::benchmark
+        {
+        public:
+            scaling(mix operation, sharing mode, std::size_t threads)
+                : my_operation(operation),
+                  my_mode(mode),
+                  my_threads(threads),
+                  my_name(string("rope_scaling_") + mix_name(operation) + "_" + sharing_name(mode) + "_t" + std::to_string(threads))
+            {
+            }
+
+            virtual const char* name() const noexcept override
+            {
+                return my_name.c_str();
+            }
+
+            virtual void run(test::benchmark::loop& loop) override
+            {
+                std::vector<thread_rope> ropes(my_threads);
+                const rope<string> original(string("shared text"));
+                std::vector<rope<string>> candidates;
+                if (my_mode == sharing::shared)
+                    for (thread_rope& target : ropes)
+                        target.source = original;
+                else if (my_mode == sharing::packed)
+                    pack(ropes, candidates);
+
+                const std::uint64_t iterations = loop.iterations();
+                std::atomic<std::size_t> ready(0);
+                std::atomic<bool> started(false);
+                std::vector<std::thread> pool;
+                for (std::size_t index = 1; index < my_threads; ++index)
+                {
+                    pool.emplace_back([&, index]
+                    {
+                        prepare(ropes[index]);
+                        ++ready;
+                        while (!started.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+                        for (std::uint64_t step = 0; step < iterations; ++step)
+                            operate(ropes[index]);
+                    });
+                }
+                prepare(ropes[0]);
+                while (ready.load(std::memory_order_acquire) + 1 < my_threads)
+                    std::this_thread::yield();
+                my_shared_lines = shared_lines(ropes);
+
+                // первая итерация запускает потоки, последняя дожидается их завершения
+                std::uint64_t step = 0;
+                while (loop.next())
+                {
+                    if (!step)
+                        started.store(true, std::memory_order_release);
+                    operate(ropes[0]);
+                    if (++step == iterations)
+                        for (std::thread& worker : pool)
+                            worker.join();
+                }
+                started.store(true, std::memory_order_release);
+                for (std::thread& worker : pool)
+                    if (worker.joinable())
+                        worker.join();
+            }
+
+            // всего операций в секунду, ускорение от одного потока и общие ли линии кэша у "шей"
+            virtual void describe(const measurement& result, std::ostream& stream) const override
+            {
+                const double total = result.per_second * my_threads;
+                stream << std::setprecision(0) << ", всего " << total << " оп/с";
+                std::vector<single_thread>& singles = single_thread_results();
+                if (my_threads == 1)
+                    singles.push_back(single_thread{ my_operation, my_mode, total });
+                for (const single_thread& single : singles)
+                    if (single.operation == my_operation && single.mode == my_mode && single.per_second > 0)
+                        stream << std::setprecision(2) << ", ускорение " << total / single.per_second
+                            << "x (" << std::setprecision(0) << 100 * total / single.per_second / my_threads << "%)";
+                if (my_mode != sharing::shared && my_threads > 1)
+                    stream << (my_shared_lines ? ", шеи в общих линиях кэша" : ", шеи в разных линиях кэша");
+                if (my_threads > std::thread::hardware_concurrency())
+                    stream << ", потоков больше ядер";
+            }
+
+        private:
+            mix my_operation;
+            sharing my_mode;
+            std::size_t my_threads;
+            string my_name;
+            bool my_shared_lines = false;
+
+            // свои "шеи" отделяются от соседних отступом в несколько линий кэша
+            void prepare(thread_rope& target) const
+            {
+                if (my_mode != sharing::padded)
+                    return;
+                target.padding.reset(new char[4 * cache_line]);
+                target.source = rope<string>(string("private text"));
+            }
+
+            void operate(thread_rope& target) const
+            {
+                switch (my_operation)
+                {
+                case mix::copy:
+                {
+                    rope<string> copy(target.source);
+                    test::benchmark::keep(copy);
+                    break;
+                }
+                case mix::look:
+                    test::benchmark::keep(target.source.look().size());
+                    break;
+                default:
+                {
+                    rope<string> copy(target.source);
+                    copy.touch()[0] = 'T';
+                    test::benchmark::keep(copy);
+                    break;
+                }
+                }
+            }
+
+            // значение лежит в "шее" сразу за счётчиком, по нему находится линия кэша счётчика
+            static std::uintptr_t counter_line(const rope<string>& source) noexcept
+            {
+                const std::uintptr_t value = reinterpret_cast<std::uintptr_t>(&source.look());
+                return (value - sizeof(std::atomic<uint64>)) / cache_line;
+            }
+
+            static bool shared_lines(const std::vector<thread_rope>& ropes)
+            {
+                std::vector<std::uintptr_t> lines;
+                for (const thread_rope& target : ropes)
+                {
+                    const std::uintptr_t line = counter_line(target.source);
+                    if (std::find(lines.begin(), lines.end(), line) != lines.end())
+                        return true;
+                    lines.push_back(line);
+                }
+                return false;
+            }
+
+            // "шеи" размещает malloc, поэтому соседство в памяти не гарантирует общих линий;
+            // из созданных подряд "шей" потокам достаются те, чьи счётчики делят линии,
+            // а если таких нет (учёт выделений добавляет заголовок к блоку), то просто соседние
+            static void pack(std::vector<thread_rope>& ropes, std::vector<rope<string>>& candidates)
+            {
+                candidates.reserve(8 * ropes.size());
+                for (std::size_t index = 0; index < 8 * ropes.size(); ++index)
+                    candidates.emplace_back(string("private text"));
+                std::vector<bool> taken(candidates.size());
+                std::size_t next = 0;
+                for (std::size_t first = 0; first < candidates.size() && next < ropes.size(); ++first)
+                {
+                    if (taken[first])
+                        continue;
+                    for (std::size_t second = first + 1; second < candidates.size() && next + 1 < ropes.size(); ++second)
+                    {
+                        if (!taken[second] && counter_line(candidates[first]) == counter_line(candidates[second]))
+                        {
+                            taken[first] = taken[second] = true;
+                            ropes[next++].source = candidates[first];
+                            ropes[next++].source = candidates[second];
+                            break;
+                        }
+                    }
+                }
+                for (std::size_t index = 0; next < ropes.size(); ++index)
+                    if (!taken[index])
+                        ropes[next++].source = candidates[index];
+            }
+        };
+
+        // число потоков матрицы: степени двойки до числа ядер и само число ядер,
+        // не меньше четырёх, чтобы ложное разделение было видно и на малых машинах
+        std::vector<std::size_t> thread_counts()
+        {
+            const std::size_t cores = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+            const std::size_t limit = std::max<std::size_t>(cores, 4);
+            std::vector<std::size_t> counts;
+            for (std::size_t count = 1; count <= limit; count *= 2)
+                counts.push_back(count);
+            if (counts.back() != limit)
+                counts.push_back(limit);
+            return counts;
+        }
+
+        std::deque<scaling>& matrix()
+        {
+            static std::deque<scaling> instances;
+            return instances;
+        }
+
+        // замеры матрицы регистрируются при загрузке программы в порядке для кривых:
+        // вид операций, вид "верёвок", затем число потоков
+        const bool matrix_registered = []
+        {
+            for (mix operation : { mix::copy, mix::look, mix::touch })
+                for (sharing mode : { sharing::shared, sharing::packed, sharing::padded })
+                    for (std::size_t threads : thread_counts())
+                        matrix().emplace_back(operation, mode, threads);
+            return true;
+        }();
+    }
+}
+
+// Здесь должен быть Unicode
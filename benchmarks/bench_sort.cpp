@@ -0,0 +1,76 @@
+// Замеры сортировки объектов по ключам против std::sort
+
+#include <dot/test.h>
+#include <dot/sort.h>
+#include <dot/box.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace dot
+{
+    namespace
+    {
+        // сто тысяч перемешанных целых и дробных, в каждой итерации
+        // сортируется свежая копия, её цена входит в замер
+        const std::vector<object>& shuffled()
+        {
+            static const std::vector<object> instance = []
+            {
+                std::vector<object> values;
+                std::mt19937 random(42);
+                for (int index = 0; index < 100000; ++index)
+                {
+                    const int value = static_cast<int>(random() % 1000000);
+                    if (index % 4)
+                        values.emplace_back(value);
+                    else
+                        values.emplace_back(value + 0.5);
+                }
+                return values;
+            }();
+            return instance;
+        }
+    }
+
+    DOT_BENCHMARK(sort_std_100k)
+    {
+        while (loop.next())
+        {
+            std::vector<object> values = shuffled();
+            std::sort(values.begin(), values.end());
+            test::benchmark::keep(values);
+        }
+    }
+
+    DOT_BENCHMARK(sort_dot_100k_one_thread)
+    {
+        while (loop.next())
+        {
+            std::vector<object> values = shuffled();
+            sort(values, 1);
+            test::benchmark::keep(values);
+        }
+    }
+
+    DOT_BENCHMARK(sort_dot_100k_all_threads)
+    {
+        while (loop.next())
+        {
+            std::vector<object> values = shuffled();
+            sort(values);
+            test::benchmark::keep(values);
+        }
+    }
+
+    DOT_BENCHMARK(sort_copy_100k)
+    {
+        while (loop.next())
+        {
+            std::vector<object> values = shuffled();
+            test::benchmark::keep(values);
+        }
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,130 @@
+// Замеры трассировки скоупов, исключений и неудачных приведений типа
+
+#include <dot/test.h>
+#include <dot/box.h>
+#include <dot/fail.h>
+
+namespace dot
+{
+    namespace
+    {
+        // вызов с отметкой DOT_TRACE_CALL на уровне трассировки сборки
+#if defined(_MSC_VER)
+        __declspec(noinline)
+#else
+        __attribute__((noinline))
+#endif
+        int traced_call(int value)
+        {
+            DOT_TRACE_CALL
+            return value + 1;
+        }
+
+        // исключение на заданной глубине скоупов, бэктрейс снимается при создании
+        int throw_at_depth(int depth)
+        {
+            trace::scope level("throw_at_depth", DOT_TRACE_FILE, __LINE__);
+            if (depth > 1)
+                return throw_at_depth(depth - 1);
+            throw fail::error("Замер исключения.");
+        }
+
+        int catch_at_depth(int depth)
+        {
+            try
+            {
+                return throw_at_depth(depth);
+            }
+            catch (const fail::error& caught)
+            {
+                return caught.what()[0];
+            }
+        }
+    }
+
+// -- скоупы трассировки --
+
+    DOT_BENCHMARK(trace_scope_push_pop)
+    {
+        while (loop.next())
+        {
+            trace::scope pushed("trace_scope_push_pop", DOT_TRACE_FILE, __LINE__);
+            test::benchmark::keep(pushed);
+        }
+    }
+
+    // восемь вложенных скоупов на операцию
+    DOT_BENCHMARK(trace_scope_nested_8)
+    {
+        while (loop.next())
+        {
+            trace::scope first("nested", DOT_TRACE_FILE, 1);
+            trace::scope second("nested", DOT_TRACE_FILE, 2);
+            trace::scope third("nested", DOT_TRACE_FILE, 3);
+            trace::scope fourth("nested", DOT_TRACE_FILE, 4);
+            trace::scope fifth("nested", DOT_TRACE_FILE, 5);
+            trace::scope sixth("nested", DOT_TRACE_FILE, 6);
+            trace::scope seventh("nested", DOT_TRACE_FILE, 7);
+            trace::scope eighth("nested", DOT_TRACE_FILE, 8);
+            test::benchmark::keep(eighth);
+        }
+    }
+
+    // цена DOT_TRACE_CALL зависит от DOT_TRACE_LEVEL сборки bench_dot
+    DOT_BENCHMARK(trace_call)
+    {
+        int value = 0;
+        while (loop.next())
+            value = traced_call(value);
+        test::benchmark::keep(value);
+    }
+
+// -- исключения и неудачные приведения --
+
+    DOT_BENCHMARK(fail_throw_catch_depth_1)
+    {
+        int sum = 0;
+        while (loop.next())
+            sum += catch_at_depth(1);
+        test::benchmark::keep(sum);
+    }
+
+    // снимок стека не копирует скоупы, но раскрутка идёт через 32 вызова,
+    // а скоупы, удержанные снимком исключения, выделяются заново при следующем входе
+    DOT_BENCHMARK(fail_throw_catch_depth_32)
+    {
+        int sum = 0;
+        while (loop.next())
+            sum += catch_at_depth(32);
+        test::benchmark::keep(sum);
+    }
+
+    DOT_BENCHMARK(typecast_failure_caught)
+    {
+        const object number(42);
+        int sum = 0;
+        while (loop.next())
+        {
+            try
+            {
+                sum += static_cast<int>(number.data_as<box<double>::cat>().look());
+            }
+            catch (const fail::bad_typecast&)
+            {
+                ++sum;
+            }
+        }
+        test::benchmark::keep(sum);
+    }
+
+    DOT_BENCHMARK(typecast_failure_result)
+    {
+        const object number(42);
+        int sum = 0;
+        while (loop.next())
+            sum += number.try_get_as<double>().ok() ? 0 : 1;
+        test::benchmark::keep(sum);
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,83 @@
+// Учёт выделений памяти по скоупам трассировки
+// через подменённые глобальные operator new и operator delete
+
+#pragma once
+
+#include <dot/trace.h>
+#include <dot/path.h>
+#include <atomic>
+#include <new>
+
+namespace dot
+{
+    // trace::allocations при включённом учёте относит каждое выделение памяти
+    // через operator new к самому вложенному скоупу трассировки текущего потока
+    // и копит по месту скоупа число выделений, их байты и ещё не освобождённые байты;
+    // перед блоком памяти хранится заголовок с местом и размером, поэтому
+    // освобождение в любом потоке уменьшает живые байты скоупа, выделившего блок;
+    // operator new и operator delete подменяются только по желанию программы
+    // макросом DOT_TRACE_ALLOCATIONS_HOOK в одном из её файлов
+    class DOT_PUBLIC trace::allocations
+    {
+    public:
+        allocations() = delete;
+
+        // включение и выключение учёта, накопленные данные сохраняются
+        static void start() noexcept;
+        static void stop() noexcept;
+        static bool tracking() noexcept;
+
+        // true если operator new подменён и выделения проходят через учёт
+        static bool hooked() noexcept;
+
+        // число выделений текущего потока через подменённый operator new,
+        // считается всегда, даже без включённого учёта
+        static std::uint64_t thread_count() noexcept;
+
+        // обнуление числа выделений и байтов, живые байты сохраняются,
+        // ведь блоки выделенные до обнуления ещё будут освобождены
+        static void reset() noexcept;
+
+        // таблица скоупов по убыванию выделенных байтов
+        static void dump();
+        static void dump(std::ostream& stream);
+
+        // учёт в виде массива записей с полями name, file, line, count, bytes,
+        // per_second - выделений в секунду учёта и live - живых байтов
+        static array report();
+
+        // выделение и освобождение для подменённых operator new и operator delete
+        static void* allocate(std::size_t size);
+        static void* allocate(std::size_t size, const std::nothrow_t&) noexcept;
+        static void release(void* memory) noexcept;
+
+        // место выделений вне скоупов трассировки
+        static constexpr const char* outside = "[вне скоупов]";
+
+    private:
+        // проверяется при каждом выделении, учёт выключен по умолчанию
+        static std::atomic<bool> my_tracking;
+    };
+}
+
+// подмена глобальных operator new и operator delete для учёта выделений,
+// ставится в один файл программы вне пространств имён;
+// в Windows каждый модуль использует свои operator new, поэтому подмена
+// в программе не видит выделений внутри dot.dll и макрос ничего не делает
+#ifdef _WIN32
+#define DOT_TRACE_ALLOCATIONS_HOOK
+#else
+#define DOT_TRACE_ALLOCATIONS_HOOK \
+    void* operator new(std::size_t size) { return dot::trace::allocations::allocate(size); } \
+    void* operator new[](std::size_t size) { return dot::trace::allocations::allocate(size); } \
+    void* operator new(std::size_t size, const std::nothrow_t& tag) noexcept { return dot::trace::allocations::allocate(size, tag); } \
+    void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return dot::trace::allocations::allocate(size, tag); } \
+    void operator delete(void* memory) noexcept { dot::trace::allocations::release(memory); } \
+    void operator delete[](void* memory) noexcept { dot::trace::allocations::release(memory); } \
+    void operator delete(void* memory, std::size_t) noexcept { dot::trace::allocations::release(memory); } \
+    void operator delete[](void* memory, std::size_t) noexcept { dot::trace::allocations::release(memory); } \
+    void operator delete(void* memory, const std::nothrow_t&) noexcept { dot::trace::allocations::release(memory); } \
+    void operator delete[](void* memory, const std::nothrow_t&) noexcept { dot::trace::allocations::release(memory); }
+#endif
+
+// Здесь должен быть Unicode
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <dot/object.h>
+#include <cmath>
 #include <utility>
 #include <new>
 
@@ -51,6 +52,10 @@ namespace dot
 
         DOT_HIERARCHIC(box_based);
 
+        // создаётся по умолчанию, только если по умолчанию создаётся значение
+        typedef box hint_owner;
+        static constexpr bool default_constructible = std::is_default_constructible_v<slim>;
+
         class cat;
 
     private:
@@ -58,18 +63,26 @@ namespace dot
     };
 
     // сравнение произвольного типа слева с объектами-"коробками"
-    template <typename left, typename right> bool operator == (const left& x, const box<right>& y);
-    template <typename left, typename right> bool operator != (const left& x, const box<right>& y);
-    template <typename left, typename right> bool operator <= (const left& x, const box<right>& y);
-    template <typename left, typename right> bool operator >= (const left& x, const box<right>& y);
-    template <typename left, typename right> bool operator <  (const left& x, const box<right>& y);
-    template <typename left, typename right> bool operator >  (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator == (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator != (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator <= (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator >= (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator <  (const left& x, const box<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator >  (const left& x, const box<right>& y);
 
     // базовый класс для любых данных-"кошек" в "коробках"
     class DOT_PUBLIC box_based::cat_based : public object::data
     {
     public:
         DOT_HIERARCHIC(object::data);
+
+        // порядок чисел встроенных типов по значению независимо от типа:
+        // -1, 0 либо 1, с NaN 2; false если одни из данных не число
+        static bool compare_numbers(const object::data& left, const object::data& right, int& order) noexcept;
+
+        // точный порядок int64 либо uint64 и дробного без округления целого: -1, 0 либо 1, с NaN 2
+        template <class integer_type>
+        static int compare_exact(integer_type integer, double floating) noexcept;
     };
 
     // данные-"кошка" любого объекта-"коробки"
@@ -88,6 +101,12 @@ namespace dot
 
         DOT_HIERARCHIC(box_based::cat_based);
 
+        // "кошка" тривиального значения копируется и переносится побайтно
+        typedef cat hint_owner;
+        static constexpr bool trivially_copyable = std::is_trivially_copyable_v<slim>;
+        static constexpr bool trivially_relocatable = std::is_trivially_copyable_v<slim>;
+        static constexpr bool default_constructible = std::is_default_constructible_v<slim>;
+
     protected:
         // копирование и перемещение значения в буфер другого объекта
         virtual object::data* copy_to(void* buffer) const noexcept override;
@@ -101,12 +120,36 @@ namespace dot
         virtual bool equals(const object::data& another) const noexcept override;
         virtual bool less(const object::data& another) const noexcept override;
 
+        // значение по метке типа, только у данных ровно этого класса
+        virtual const void* find_value(const void* tag) const noexcept override;
+
     private:
         slim my_value;
     };
 
     // -- шаблонные методы --
 
+    template <class integer_type>
+    int box_based::cat_based::compare_exact(integer_type integer, double floating) noexcept
+    {
+        static_assert(std::is_same_v<integer_type, int64> || std::is_same_v<integer_type, uint64>,
+            "Exact comparison takes integers widened to int64 or uint64.");
+        // границы диапазона целого типа точно представимы в double
+        constexpr double upper = std::is_signed_v<integer_type> ? 9223372036854775808.0 : 18446744073709551616.0;
+        constexpr double lower = std::is_signed_v<integer_type> ? -9223372036854775808.0 : 0.0;
+        if (floating != floating)
+            return 2;
+        if (floating >= upper)
+            return -1;
+        if (floating < lower)
+            return 1;
+        const double whole = std::trunc(floating);
+        const integer_type part = static_cast<integer_type>(whole);
+        if (integer != part)
+            return integer < part ? -1 : 1;
+        return floating > whole ? -1 : floating < whole ? 1 : 0;
+    }
+
     template <class slim>
     box<slim>::box(const object& another)
         : my_cat(initialize<box<slim>::cat>(
@@ -203,7 +246,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to compare box_based with non comparable type.");
+            static_assert(!sizeof(other), "Unable to compare box_based with non comparable type.");
         }
     }
 
@@ -242,7 +285,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to order box_based with non orderable type.");
+            static_assert(!sizeof(other), "Unable to order box_based with non orderable type.");
         }
     }
 
@@ -260,41 +303,41 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to order box_based with non orderable type.");
+            static_assert(!sizeof(other), "Unable to order box_based with non orderable type.");
         }
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator == (const left& x, const box<right>& y)
     {
         return y == x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator != (const left& x, const box<right>& y)
     {
         return y != x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator <= (const left& x, const box<right>& y)
     {
         return y >= x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator >= (const left& x, const box<right>& y)
     {
         return y <= x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator < (const left& x, const box<right>& y)
     {
         return y > x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator > (const left& x, const box<right>& y)
     {
         return y < x;
@@ -372,8 +415,17 @@ namespace dot
         {
             if (another.is<cat>())
                 return look() == another.as<cat>().look();
-            else
-                return base::equals(another);
+            // то же значение в другом виде данных, например из объекта другой ёмкости
+            else if (const slim* value = another.value_as<slim>())
+                return look() == *value;
+            // числа других встроенных типов сравниваются по значению
+            if constexpr (std::is_arithmetic_v<slim> && !std::is_same_v<slim, bool>)
+            {
+                int order = 0;
+                if (compare_numbers(*this, another, order))
+                    return order == 0;
+            }
+            return base::equals(another);
         }
         else
         {
@@ -388,8 +440,17 @@ namespace dot
         {
             if (another.is<cat>())
                 return look() < another.as<cat>().look();
-            else
-                return base::equals(another);
+            // то же значение в другом виде данных, например из объекта другой ёмкости
+            else if (const slim* value = another.value_as<slim>())
+                return look() < *value;
+            // числа других встроенных типов сравниваются по значению
+            if constexpr (std::is_arithmetic_v<slim> && !std::is_same_v<slim, bool>)
+            {
+                int order = 0;
+                if (compare_numbers(*this, another, order))
+                    return order < 0;
+            }
+            return base::equals(another);
         }
         else
         {
@@ -397,6 +458,12 @@ namespace dot
         }
     }
 
+    template <class slim>
+    const void* box<slim>::cat::find_value(const void* tag) const noexcept
+    {
+        return tag == &value_tag<slim> && my_id() == id() ? &my_value : nullptr;
+    }
+
     // -- идентификаторы встроенных типов внутри объектов-"коробок" --
 
     template<> DOT_PUBLIC const class_id& box<long long>::id() noexcept;
@@ -0,0 +1,62 @@
+// Аппаратные счётчики процессора вокруг участка кода:
+// такты, инструкции, промахи кэша и ошибки предсказания переходов
+
+#pragma once
+
+#include <dot/trace.h>
+#include <cstdint>
+
+namespace dot
+{
+    // trace::counters открывает группу счётчиков perf_event_open текущего потока
+    // только пользовательского режима, чтобы работать без прав администратора;
+    // группа включается и читается целиком, поэтому значения согласованы,
+    // а при мультиплексировании счётчиков ядром пересчитываются на полное время;
+    // в системах без perf_event_open, при запрете в perf_event_paranoid
+    // или в виртуальной машине без счётчиков available() возвращает false,
+    // а отдельные недоступные счётчики в values остаются отрицательными
+    class DOT_PUBLIC trace::counters
+    {
+    public:
+        // значения счётчиков, отрицательные для недоступных
+        class values
+        {
+        public:
+            std::int64_t cycles = -1;
+            std::int64_t instructions = -1;
+            std::int64_t cache_misses = -1;
+            std::int64_t branch_misses = -1;
+
+            // инструкций за такт, отрицательно без тактов или инструкций
+            double ipc() const noexcept;
+
+            values& operator += (const values& another) noexcept;
+        };
+
+        // открытие счётчиков для текущего потока, считать можно только в нём
+        counters() noexcept;
+        ~counters() noexcept;
+
+        counters(const counters&) = delete;
+        counters& operator = (const counters&) = delete;
+
+        bool available() const noexcept;
+
+        // обнуление и запуск счётчиков
+        void start() noexcept;
+
+        // остановка счётчиков и их значения от последнего start()
+        values stop() noexcept;
+
+        // открываются ли счётчики в этом процессе, проверяется один раз
+        static bool supported() noexcept;
+
+    private:
+        static constexpr int kinds = 4;
+
+        int my_files[kinds];
+        std::uint64_t my_ids[kinds];
+    };
+}
+
+// Здесь должен быть Unicode
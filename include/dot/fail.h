@@ -5,6 +5,7 @@
 #include <dot/trace.h>
 #include <dot/rope.h>
 #include <exception>
+#include <atomic>
 
 namespace dot
 {
@@ -22,6 +23,7 @@ namespace dot
         class unreadable_data;
         class non_comparable;
         class non_orderable;
+        class bad_path;
     };
 
     // информация об исключении и бэктрейс
@@ -56,6 +58,11 @@ namespace dot
         virtual const char* label() const noexcept;
 
         DOT_HIERARCHIC(rope<fail::info>);
+
+    protected:
+        // ошибка с общей пустой информацией без выделения памяти,
+        // наследник строит сообщение и бэктрейс при первом обращении
+        error() noexcept;
     };
 
 #pragma warning(pop)
@@ -64,13 +71,34 @@ namespace dot
     DOT_PUBLIC std::istream& operator >> (std::istream& stream, fail::error& destination);
 
     // ошибка приведения типа данных объекта к определённому типу
+    // создаётся без выделения памяти: хранит ссылки на идентификаторы классов
+    // и снимок стека, а сообщение и бэктрейс строит при первом обращении,
+    // поэтому дёшево обходится проверка типа через as<T>() в try/catch;
+    // идентификаторы должны жить дольше исключения, как статические id() классов
     class DOT_PUBLIC fail::bad_typecast : public fail::error
     {
     public:
         explicit bad_typecast(const class_id& to_type, const class_id& from_type) noexcept;
+        bad_typecast(const bad_typecast& another) noexcept;
+
+        virtual const char* what() const noexcept override;
+        virtual const trace::stack& backtrace() const noexcept override;
         virtual const char* label() const noexcept override;
 
+        const class_id& to_type() const noexcept;
+        const class_id& from_type() const noexcept;
+
         DOT_HIERARCHIC(fail::error);
+
+    private:
+        const class_id* my_to_type;
+        const class_id* my_from_type;
+        trace::stack::snapshot my_snapshot;
+
+        // информация об ошибке ещё не построена, строится или готова
+        mutable std::atomic<int> my_state;
+
+        void materialize() const noexcept;
     };
 
     // ссылка на данные объекта не содержащего данные
@@ -113,6 +141,16 @@ namespace dot
         DOT_HIERARCHIC(fail::error);
     };
 
+    // выражение пути выборки объектов содержит ошибку
+    class DOT_PUBLIC fail::bad_path : public fail::error
+    {
+    public:
+        explicit bad_path(const char* message) noexcept;
+        virtual const char* label() const noexcept override;
+
+        DOT_HIERARCHIC(fail::error);
+    };
+
     // идентификаторы данных об исключении
     template<> DOT_PUBLIC const class_id& rope<fail::info>::id() noexcept;
     template<> DOT_PUBLIC const class_id& rope<fail::info>::cow::id() noexcept;
@@ -5,16 +5,103 @@
 #pragma once
 
 #include <dot/type.h>
+#include <cstring>
 #include <utility>
 
 namespace dot
 {
-    // объект может хранить произвольные данные
-    class DOT_PUBLIC object : public hierarchic
+    class object_data;
+
+    // -- выбор хранения значения в объекте --
+
+    // значения, которые объект хранит по общей ссылке при любой ёмкости буфера:
+    // строки и контейнеры, чьи данные не лежат в самом значении; признак уточняется
+    // рядом с объявлением типа, так как у такого типа есть только rope<...>::cow
+    template <class value_type>
+    struct rope_only_class : std::false_type { };
+
+    template <class char_type, class traits_type, class allocator_type>
+    struct rope_only_class<std::basic_string<char_type, traits_type, allocator_type>> : std::true_type { };
+
+    // символы строк, которые объект хранит как стандартные строки
+    template <class char_type>
+    struct character_class : std::bool_constant<
+        std::is_same_v<char_type, char> || std::is_same_v<char_type, wchar_t> ||
+        std::is_same_v<char_type, char16_t> || std::is_same_v<char_type, char32_t>> { };
+
+    // тип значения в данных объекта: строка в стиле C хранится как std::basic_string
+    template <class value_type, typename meta_type = void>
+    struct object_value
+    {
+        typedef value_type type;
+    };
+
+    template <class char_type>
+    struct object_value<const char_type*, std::enable_if_t<character_class<char_type>::value>>
+    {
+        typedef std::basic_string<char_type, std::char_traits<char_type>, std::allocator<char_type>> type;
+    };
+
+    template <class char_type, std::size_t length>
+    struct object_value<char_type[length], std::enable_if_t<character_class<char_type>::value>>
+        : object_value<const char_type*>
+    {
+    };
+
+    // значение хранится в буфере объекта ёмкостью capacity байт, иначе по общей ссылке
+    template <class value_type, std::size_t capacity>
+    struct boxed_class : std::bool_constant<
+        sizeof(value_type) <= capacity && !rope_only_class<value_type>::value> { };
+
+    // тип данных объекта ёмкостью capacity для значения, как его выбирает set_as()
+    template <class value_type, std::size_t capacity, bool = boxed_class<value_type, capacity>::value>
+    struct object_data_class
+    {
+        typedef typename box<value_type>::cat type;
+    };
+
+    template <class value_type, std::size_t capacity>
+    struct object_data_class<value_type, capacity, false>
+    {
+        typedef typename rope<value_type>::cow type;
+    };
+
+    // объект любой ёмкости либо его наследник
+    template <std::size_t capacity>
+    std::true_type basic_object_test(const basic_object<capacity>*);
+    std::false_type basic_object_test(const void*);
+
+    template <class class_type>
+    struct basic_object_class : decltype(basic_object_test(std::declval<class_type*>())) { };
+
+    // как копируются, переносятся и удаляются данные в буфере: побайтно
+    // без виртуальных вызовов либо методами copy_to, move_to и деструктором данных;
+    // деструктор нужен видам от relocatable и дальше
+    enum class object_data_kind : uint8
+    {
+        none,        // данных нет
+        trivial,     // копирование и перенос побайтные, удалять нечего
+        relocatable, // перенос побайтный, копирование и удаление виртуальные
+        general      // всё через виртуальные методы данных
+    };
+
+    // метка типа значения без RTTI: адрес переменной различает типы во всей программе
+    template <class value_type>
+    inline constexpr char value_tag = 0;
+
+    // объект может хранить произвольные данные, значения до capacity байт
+    // лежат во внутреннем буфере, большие хранятся по общей ссылке;
+    // классы данных общие для всех ёмкостей, поэтому данные копируются
+    // между объектами разной ёмкости: в буфер цели, а если он мал, то в кучу
+    template <std::size_t capacity>
+    class basic_object : public hierarchic
     {
     public:
-        object() = default;
-        virtual ~object() noexcept;
+        static_assert(capacity >= sizeof(void*),
+            "Object data buffer must hold at least a pointer for the data stored by reference.");
+
+        basic_object() = default;
+        virtual ~basic_object() noexcept;
 
         // сброс и отсутствие данных
         virtual void reset() noexcept;
@@ -22,20 +109,37 @@ namespace dot
         virtual bool is_not_null() const noexcept;
 
         // копирование данных из другого объекта
-        object(const object& another);
-        object& operator = (const object& another);
+        basic_object(const basic_object& another);
+        basic_object& operator = (const basic_object& another);
 
         // перенос данных из другого объекта
-        object(object&& temporary) noexcept;
-        object& operator = (object&& temporary) noexcept;
+        basic_object(basic_object&& temporary) noexcept;
+        basic_object& operator = (basic_object&& temporary) noexcept;
+
+        // копирование и перенос данных из объекта другой ёмкости,
+        // данные больше буфера цели хранятся в куче как heap_data
+        template <std::size_t other_capacity>
+        explicit basic_object(const basic_object<other_capacity>& another);
+
+        template <std::size_t other_capacity>
+        explicit basic_object(basic_object<other_capacity>&& temporary);
+
+        template <std::size_t other_capacity>
+        basic_object& operator = (const basic_object<other_capacity>& another);
+
+        template <std::size_t other_capacity>
+        basic_object& operator = (basic_object<other_capacity>&& temporary);
 
         // создание объекта по произвольному типу
-        template <class other>
-        explicit object(other&& another);
+        template <class other, typename = std::enable_if_t<
+            !basic_object_class<std::decay_t<other>>::value>>
+        explicit basic_object(other&& another);
 
-        // создание данных объекта по произвольному типу
-        template <class other>
-        object& operator = (other&& another);
+        // создание данных объекта по произвольному типу,
+        // объекты и их наследники копируются и переносятся как объекты
+        template <class other, typename = std::enable_if_t<
+            !basic_object_class<std::decay_t<other>>::value>>
+        basic_object& operator = (other&& another);
 
         // преобразование к произвольному типу
         template <class other>
@@ -49,16 +153,20 @@ namespace dot
         template <class other>
         other get_as() const;
 
+        // приведение данных объекта без исключения, неудача в результате
+        template <class other>
+        result<other> try_get_as() const;
+
         // сравнения объектов
-        bool operator == (const object& another) const;
-        bool operator != (const object& another) const;
-        bool operator <= (const object& another) const;
-        bool operator >= (const object& another) const;
-        bool operator <  (const object& another) const;
-        bool operator >  (const object& another) const;
+        bool operator == (const basic_object& another) const;
+        bool operator != (const basic_object& another) const;
+        bool operator <= (const basic_object& another) const;
+        bool operator >= (const basic_object& another) const;
+        bool operator <  (const basic_object& another) const;
+        bool operator >  (const basic_object& another) const;
 
-        // базовый класс для любых данных объекта
-        class data;
+        // базовый класс для любых данных объекта, общий для всех ёмкостей
+        typedef object_data data;
 
         // получение ссылки на данные объекта
         const data& get_data() const;
@@ -67,11 +175,17 @@ namespace dot
         template <typename data_type>
         const data_type& data_as() const;
 
+        // те же доступы без исключений, годятся и для сборки без исключений
+        result<const data&> try_get_data() const noexcept;
+
+        template <typename data_type>
+        result<const data_type&> try_data_as() const noexcept;
+
         // базовый класс иерархии
         DOT_HIERARCHIC(hierarchic);
 
-        // данных достаточно для хранения 2х int64 либо 4х float
-        static constexpr size_t data_type_max = 2 * sizeof(int64);
+        // наибольший размер значения в буфере и размер буфера под данные с ним
+        static constexpr size_t data_type_max = capacity;
         static constexpr size_t data_buffer_size = data_type_max + sizeof(void*);
 
     protected:
@@ -80,35 +194,51 @@ namespace dot
         derived* initialize(arguments&&... args);
 
         // служебные методы для копирования и переноса данных
-        void copy_to(object& target) const&;
-        void move_to(object& target) &&;
+        void copy_to(basic_object& target) const&;
+        void move_to(basic_object& target) &&;
 
     private:
-        // указатель на данные
-        data* my_data = nullptr;
+        template <std::size_t>
+        friend class basic_object;
+
+        typedef object_data_kind data_kind;
+
+        data_kind my_kind = data_kind::none;
+
+        // внутренний буфер для хранения данных, данные всегда лежат в его начале
+        alignas(void*) byte my_buffer[data_buffer_size] = {};
 
-        // внутренний буфер для хранения данных
-        byte my_buffer[data_buffer_size] = {};
+        // данные в буфере, только при my_kind отличном от none
+        data* stored_data() noexcept;
+        const data* stored_data() const noexcept;
 
-        // работа с потоками ввода-вывода
-        friend DOT_PUBLIC std::ostream& operator << (std::ostream& stream, const object& source);
-        friend DOT_PUBLIC std::istream& operator >> (std::istream& stream, object& destination);
+        // копирование и перенос данных объекта другой ёмкости
+        template <std::size_t other_capacity>
+        void copy_from(const basic_object<other_capacity>& source);
+
+        template <std::size_t other_capacity>
+        void move_from(basic_object<other_capacity>&& source);
+
+        // данные объекта другой ёмкости без обёртки heap_data, их размер и вид
+        template <std::size_t other_capacity>
+        static const data* unwrapped(const basic_object<other_capacity>& source,
+            std::size_t& size, data_kind& kind) noexcept;
     };
 
     // базовый класс для любых данных объекта
-    class DOT_PUBLIC object::data : public hierarchic
+    class DOT_PUBLIC object_data : public hierarchic
     {
     public:
-        data() noexcept = default;
-        virtual ~data() noexcept;
+        object_data() noexcept = default;
+        virtual ~object_data() noexcept;
 
         // сравнение данных объекта
-        bool operator == (const data& another) const;
-        bool operator != (const data& another) const;
-        bool operator <= (const data& another) const;
-        bool operator >= (const data& another) const;
-        bool operator <  (const data& another) const;
-        bool operator >  (const data& another) const;
+        bool operator == (const object_data& another) const;
+        bool operator != (const object_data& another) const;
+        bool operator <= (const object_data& another) const;
+        bool operator >= (const object_data& another) const;
+        bool operator <  (const object_data& another) const;
+        bool operator >  (const object_data& another) const;
 
         // базовый класс иерархии
         DOT_HIERARCHIC(hierarchic);
@@ -116,101 +246,564 @@ namespace dot
         // константа для null объекта без данных
         static const char* const null_string;
 
+        // вывод данных в поток, для пустого объекта выводится null_string
+        static std::ostream& print(std::ostream& stream, const object_data* source);
+
+        // значение, если данные ровно box<value_type>::cat либо rope<value_type>::cow,
+        // иначе nullptr; объект другой ёмкости мог сохранить значение не в том виде,
+        // который выбрал бы set_as() этого объекта
+        template <class value_type>
+        const value_type* value_as() const noexcept
+        {
+            return static_cast<const value_type*>(find_value(&value_tag<value_type>));
+        }
+
     protected:
         // копирование и перенос данных в буфер другого объекта
-        virtual data* copy_to(void* buffer) const noexcept = 0;
-        virtual data* move_to(void* buffer) noexcept = 0;
+        virtual object_data* copy_to(void* buffer) const noexcept = 0;
+        virtual object_data* move_to(void* buffer) noexcept = 0;
 
         // работа с потоками ввода и вывода
         virtual void write(std::ostream& stream) const;
         virtual void read(std::istream& stream);
 
         // работа со сравнениями типов хранящихся в данных
-        virtual bool equals(const data& another) const noexcept;
-        virtual bool less(const data& another) const noexcept;
+        virtual bool equals(const object_data& another) const noexcept;
+        virtual bool less(const object_data& another) const noexcept;
+
+        // адрес значения с меткой типа tag, у данных без значения nullptr
+        virtual const void* find_value(const void* tag) const noexcept;
 
         // доступ к данным
-        friend class object;
+        template <std::size_t>
+        friend class basic_object;
+
+        friend class heap_data;
 
         // ввод и вывод в стандартные потоки
-        friend DOT_PUBLIC std::ostream& operator << (std::ostream& stream, const object::data& source);
-        friend DOT_PUBLIC std::istream& operator >> (std::istream& stream, object::data& destination);
+        friend DOT_PUBLIC std::ostream& operator << (std::ostream& stream, const object_data& source);
+        friend DOT_PUBLIC std::istream& operator >> (std::istream& stream, object_data& destination);
     };
 
+    // данные объекта другой ёмкости, не поместившиеся в буфер цели: в буфере
+    // лежит лишь указатель на общую копию данных в куче; значение доступно через
+    // get_as() и visit(), а копия в объект с достаточным буфером снова ложится в буфер
+    class DOT_PUBLIC heap_data : public object_data
+    {
+    public:
+        // копирование либо перенос данных размером size в кучу
+        heap_data(const object_data& source, std::size_t size, object_data_kind kind);
+        heap_data(object_data&& source, std::size_t size, object_data_kind kind);
+
+        // копия делит тот же блок в куче и не выделяет память
+        heap_data(const heap_data& another) noexcept;
+        heap_data(heap_data&& temporary) noexcept;
+        heap_data& operator = (const heap_data&) = delete;
+        virtual ~heap_data() noexcept;
+
+        // данные в куче, их размер и вид
+        const object_data& stored() const noexcept;
+        std::size_t stored_size() const noexcept;
+        object_data_kind stored_kind() const noexcept;
+
+        DOT_HIERARCHIC(object_data);
+
+        // побайтный перенос указателя не трогает данные в куче
+        typedef heap_data hint_owner;
+        static constexpr bool trivially_relocatable = true;
+
+    protected:
+        virtual object_data* copy_to(void* buffer) const noexcept override;
+        virtual object_data* move_to(void* buffer) noexcept override;
+
+        virtual void write(std::ostream& stream) const override;
+        virtual void read(std::istream& stream) override;
+
+        // данные в куче сравниваются так же, как в буфере
+        virtual bool equals(const object_data& another) const noexcept override;
+        virtual bool less(const object_data& another) const noexcept override;
+
+        virtual const void* find_value(const void* tag) const noexcept override;
+
+    private:
+        // заголовок блока в куче с размером и видом данных, данные лежат следом
+        struct block;
+        block* my_block;
+    };
+
+    // работа объектов с потоками ввода-вывода
+    template <std::size_t capacity>
+    std::ostream& operator << (std::ostream& stream, const basic_object<capacity>& source);
+
+    template <std::size_t capacity>
+    std::istream& operator >> (std::istream& stream, basic_object<capacity>& destination);
+
+    // имя класса объекта ёмкостью capacity для его идентификатора
+    template <std::size_t capacity>
+    class basic_object_name
+    {
+    public:
+        static constexpr std::size_t digits() noexcept
+        {
+            std::size_t count = 1;
+            for (std::size_t rest = capacity; rest >= 10; rest /= 10)
+                ++count;
+            return count;
+        }
+
+        constexpr basic_object_name() noexcept
+        {
+            constexpr char prefix[] = "basic_object<";
+            std::size_t length = 0;
+            for (; prefix[length]; ++length)
+                text[length] = prefix[length];
+            std::size_t rest = capacity;
+            for (std::size_t digit = digits(); digit; --digit, rest /= 10)
+                text[length + digit - 1] = static_cast<char>('0' + rest % 10);
+            text[length + digits()] = '>';
+        }
+
+        char text[sizeof("basic_object<>") + digits()] = {};
+    };
+
+    // объект по умолчанию называется просто object
+    template <>
+    DOT_PUBLIC const class_id& object::id() noexcept;
+
+    // объект по умолчанию собирается в библиотеке, остальные ёмкости в программе
+    extern template class DOT_PUBLIC basic_object<16>;
+
     // -- шаблонные методы --
 
-    template <class other>
-    object::object(other&& another)
-        : my_data(nullptr)
+    template <std::size_t capacity>
+    basic_object<capacity>::~basic_object() noexcept
+    {
+        // очистка перед удалением
+        reset();
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    basic_object<capacity>::basic_object(const basic_object<other_capacity>& another)
+    {
+        copy_from(another);
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    basic_object<capacity>::basic_object(basic_object<other_capacity>&& temporary)
+    {
+        move_from(std::move(temporary));
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    basic_object<capacity>& basic_object<capacity>::operator = (const basic_object<other_capacity>& another)
+    {
+        copy_from(another);
+        return *this;
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    basic_object<capacity>& basic_object<capacity>::operator = (basic_object<other_capacity>&& temporary)
+    {
+        move_from(std::move(temporary));
+        return *this;
+    }
+
+    template <std::size_t capacity>
+    template <class other, typename>
+    basic_object<capacity>::basic_object(other&& another)
     {
         set_as(std::forward<other>(another));
     }
 
-    template <class other>
-    object& object::operator = (other&& another)
+    template <std::size_t capacity>
+    template <class other, typename>
+    basic_object<capacity>& basic_object<capacity>::operator = (other&& another)
     {
         set_as(std::forward<other>(another));
         return *this;
     }
 
+    template <std::size_t capacity>
     template <class other>
-    object::operator other() const
+    basic_object<capacity>::operator other() const
     {
         return get_as<other>();
     }
 
+    template <std::size_t capacity>
     template <class other>
-    void object::set_as(other&& another)
+    void basic_object<capacity>::set_as(other&& another)
     {
+        // строки в стиле C становятся стандартными строками, остальное хранится как есть
         using source_type = std::remove_const_t<std::remove_reference_t<other>>;
-        if constexpr (sizeof(source_type) <= data_type_max)
-        {
-            // данные поместятся во внутренний буфер
-            initialize<typename box<source_type>::cat>(std::forward<other>(another));
-        }
-        else
-        {
-            // данные придётся хранить в динамически выделенной памяти
-            initialize<typename rope<source_type>::cow>(std::forward<other>(another));
-        }
+        using value_type = typename object_value<source_type>::type;
+        // данные поместятся во внутренний буфер либо будут храниться в динамически выделенной памяти
+        initialize<typename object_data_class<value_type, capacity>::type>(std::forward<other>(another));
     }
 
+    template <std::size_t capacity>
     template <class other>
-    other object::get_as() const
+    other basic_object<capacity>::get_as() const
     {
         using target_type = std::remove_const_t<std::remove_reference_t<other>>;
-        if constexpr (sizeof(target_type) <= data_type_max)
-        {
-            // доступ к данным по значению в буфере
-            return data_as<typename box<target_type>::cat>().look();
-        }
+        using value_type = typename object_value<target_type>::type;
+        using data_type = typename object_data_class<value_type, capacity>::type;
+        // значение в буфере копируется, а по ссылке отдаётся без копирования;
+        // данные из объекта другой ёмкости могут хранить значение в другом виде
+        const data& source = get_data();
+        const value_type* value = source.template is<data_type>()
+            ? &static_cast<const data_type&>(source).look() : source.template value_as<value_type>();
+        if (!value)
+            result_error(result_code::bad_typecast, &data_type::id(), &source.my_id()).raise();
+        if constexpr (std::is_same_v<value_type, target_type>)
+            return *value;
         else
-        {
-            // доступ к данным по ссылке не приведёт к копированию
-            return data_as<typename rope<target_type>::cow>().look();
-        }
+            return value->c_str();
     }
 
+    template <std::size_t capacity>
     template <typename data_type>
-    const data_type& object::data_as() const
+    const data_type& basic_object<capacity>::data_as() const
     {
         // приведение к типу данных наследника
-        return get_data().as<data_type>();
+        return get_data().template as<data_type>();
+    }
+
+    template <std::size_t capacity>
+    template <class other>
+    result<other> basic_object<capacity>::try_get_as() const
+    {
+        using target_type = std::remove_const_t<std::remove_reference_t<other>>;
+        using value_type = typename object_value<target_type>::type;
+        using data_type = typename object_data_class<value_type, capacity>::type;
+        const result<const data&> source = try_get_data();
+        if (!source)
+            return source.error();
+        const value_type* value = (*source).template is<data_type>()
+            ? &static_cast<const data_type&>(*source).look() : (*source).template value_as<value_type>();
+        if (!value)
+            return result_error(result_code::bad_typecast, &data_type::id(), &(*source).my_id());
+        if constexpr (std::is_same_v<value_type, target_type>)
+            return *value;
+        else
+            return value->c_str();
+    }
+
+    template <std::size_t capacity>
+    template <typename data_type>
+    result<const data_type&> basic_object<capacity>::try_data_as() const noexcept
+    {
+        const result<const data&> source = try_get_data();
+        if (!source)
+            return source.error();
+        return (*source).template try_as<data_type>();
     }
 
+    template <std::size_t capacity>
     template <typename derived, typename... arguments>
-    derived* object::initialize(arguments&&... args)
+    derived* basic_object<capacity>::initialize(arguments&&... args)
     {
         // проверка на размер типа данных для помещения в буфер
         static_assert(sizeof(derived) <= data_buffer_size,
             "Size of derived data type is too big for object data internal buffer.");
-        // ссылка на данные нужного типа
-        derived* result;
         reset();
         // инициализация данных в буфере объекта произвольным набором аргументов
-        my_data = result = new(my_buffer) derived(std::forward<arguments>(args)...);
+        derived* result = new(my_buffer) derived(std::forward<arguments>(args)...);
+        // побайтные копирование и перенос данные заявляют признаками класса
+        my_kind = trivially_copyable_class<derived>::value ? data_kind::trivial
+            : trivially_relocatable_class<derived>::value ? data_kind::relocatable
+            : data_kind::general;
         return result;
     }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator == (const basic_object& another) const
+    {
+        return this == &another || (is_null() && another.is_null()) ||
+            (is_not_null() && another.is_not_null() && stored_data()->equals(*another.stored_data()));
+    }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator != (const basic_object& another) const
+    {
+        return !(*this == another);
+    }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator <= (const basic_object& another) const
+    {
+        return !(another < *this);
+    }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator >= (const basic_object& another) const
+    {
+        return !(*this < another);
+    }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator < (const basic_object& another) const
+    {
+        return (is_null() && another.is_not_null()) ||
+            (is_not_null() && another.is_not_null() && stored_data()->less(*another.stored_data()));
+    }
+
+    template <std::size_t capacity>
+    bool basic_object<capacity>::operator > (const basic_object& another) const
+    {
+        return another < *this;
+    }
+
+    // размер берётся из сведений о классе данных, без них из размера буфера источника;
+    // данные из кучи копируются как сами данные, чтобы снова лечь в буфер, если он велик
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    const object_data* basic_object<capacity>::unwrapped(const basic_object<other_capacity>& source,
+        std::size_t& size, data_kind& kind) noexcept
+    {
+        const data* stored = source.stored_data();
+        const class_id& stored_id = stored->my_id();
+        if (stored_id == heap_data::id())
+        {
+            const heap_data& heap = static_cast<const heap_data&>(*stored);
+            size = heap.stored_size();
+            kind = heap.stored_kind();
+            return &heap.stored();
+        }
+        size = stored_id.info().size ? stored_id.info().size : source.data_buffer_size;
+        kind = source.my_kind;
+        return stored;
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    void basic_object<capacity>::copy_from(const basic_object<other_capacity>& source)
+    {
+        static_assert(sizeof(heap_data) <= data_buffer_size,
+            "Object data buffer must hold the pointer to data in the heap.");
+        reset();
+        if (source.my_kind == data_kind::none)
+            return;
+        std::size_t size = 0;
+        data_kind kind = data_kind::none;
+        const data* stored = unwrapped(source, size, kind);
+        if (size > data_buffer_size)
+        {
+            // данные из кучи остаются в том же блоке, остальные копируются в кучу
+            if (stored == source.stored_data())
+                new(my_buffer) heap_data(*stored, size, kind);
+            else
+                source.stored_data()->copy_to(my_buffer);
+            my_kind = data_kind::relocatable;
+            return;
+        }
+        if (kind == data_kind::trivial)
+            std::memcpy(my_buffer, stored, size);
+        else
+            stored->copy_to(my_buffer);
+        my_kind = kind;
+    }
+
+    template <std::size_t capacity>
+    template <std::size_t other_capacity>
+    void basic_object<capacity>::move_from(basic_object<other_capacity>&& source)
+    {
+        reset();
+        if (source.my_kind == data_kind::none)
+            return;
+        std::size_t size = 0;
+        data_kind kind = data_kind::none;
+        data* stored = const_cast<data*>(unwrapped(source, size, kind));
+        if (stored != source.stored_data())
+        {
+            // данные из кучи ложатся в буфер копией, иначе переносится сам указатель на кучу
+            if (size <= data_buffer_size)
+            {
+                copy_from(source);
+                source.reset();
+                return;
+            }
+            std::memcpy(my_buffer, source.my_buffer, sizeof(heap_data));
+            my_kind = data_kind::relocatable;
+            source.my_kind = data_kind::none;
+            return;
+        }
+        if (size > data_buffer_size)
+        {
+            new(my_buffer) heap_data(std::move(*stored), size, kind);
+            my_kind = data_kind::relocatable;
+        }
+        else if (kind == data_kind::general)
+        {
+            stored->move_to(my_buffer);
+            my_kind = kind;
+            return;
+        }
+        else
+        {
+            std::memcpy(my_buffer, source.my_buffer, size);
+            my_kind = kind;
+        }
+        // побайтно перенесённые данные принадлежат цели, тривиальные остаются и в источнике
+        if (kind == data_kind::relocatable)
+            source.my_kind = data_kind::none;
+    }
+
+    template <std::size_t capacity>
+    std::ostream& operator << (std::ostream& stream, const basic_object<capacity>& source)
+    {
+        return object_data::print(stream, source.is_not_null() ? &source.get_data() : nullptr);
+    }
+
+    template <std::size_t capacity>
+    std::istream& operator >> (std::istream& stream, basic_object<capacity>& /*destination*/)
+    {
+        // TODO: initialize data by incoming byte stream
+        return stream;
+    }
+
+    template <std::size_t capacity>
+    const class_id& basic_object<capacity>::id() noexcept
+    {
+        static constexpr basic_object_name<capacity> name{};
+        static const class_id object_id(name.text, class_info::of<basic_object>());
+        return object_id;
+    }
+
+    // -- короткие частые методы --
+
+    template <std::size_t capacity>
+    DOT_HOT object_data* basic_object<capacity>::stored_data() noexcept
+    {
+        return std::launder(reinterpret_cast<data*>(my_buffer));
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT const object_data* basic_object<capacity>::stored_data() const noexcept
+    {
+        return std::launder(reinterpret_cast<const data*>(my_buffer));
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT void basic_object<capacity>::reset() noexcept
+    {
+        // явный вызов деструктора после placement new, у тривиальных данных он пуст
+        if (my_kind >= data_kind::relocatable)
+            stored_data()->~data();
+        my_kind = data_kind::none;
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT bool basic_object<capacity>::is_null() const noexcept
+    {
+        return my_kind == data_kind::none;
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT bool basic_object<capacity>::is_not_null() const noexcept
+    {
+        return my_kind != data_kind::none;
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT const object_data& basic_object<capacity>::get_data() const
+    {
+        if (my_kind == data_kind::none)
+            result_error(result_code::null_reference, &data::id()).raise();
+        return *stored_data();
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT result<const object_data&> basic_object<capacity>::try_get_data() const noexcept
+    {
+        if (my_kind == data_kind::none)
+            return result_error(result_code::null_reference, &data::id());
+        return *stored_data();
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT basic_object<capacity>::basic_object(const basic_object& another)
+    {
+        another.copy_to(*this);
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT basic_object<capacity>& basic_object<capacity>::operator = (const basic_object& another)
+    {
+        another.copy_to(*this);
+        return *this;
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT basic_object<capacity>::basic_object(basic_object&& temporary) noexcept
+    {
+        std::move(temporary).move_to(*this);
+    }
+
+    template <std::size_t capacity>
+    DOT_HOT basic_object<capacity>& basic_object<capacity>::operator = (basic_object&& temporary) noexcept
+    {
+        std::move(temporary).move_to(*this);
+        return *this;
+    }
+
+    // тривиальные данные полиморфны, но их побайтная копия вместе с указателем
+    // на таблицу виртуальных методов равноценна копии конструктором
+    template <std::size_t capacity>
+    DOT_HOT void basic_object<capacity>::copy_to(basic_object& target) const&
+    {
+        if (this == &target)
+            return;
+        target.reset();
+        if (my_kind == data_kind::trivial)
+            std::memcpy(target.my_buffer, my_buffer, sizeof(my_buffer));
+        else if (my_kind != data_kind::none)
+            stored_data()->copy_to(target.my_buffer);
+        target.my_kind = my_kind;
+    }
+
+    // перенесённые побайтно данные принадлежат цели, источник остаётся пустым
+    // без вызова деструктора; тривиальные данные остаются и в источнике
+    template <std::size_t capacity>
+    DOT_HOT void basic_object<capacity>::move_to(basic_object& target) &&
+    {
+        if (this == &target)
+            return;
+        target.reset();
+        if (my_kind == data_kind::trivial)
+            std::memcpy(target.my_buffer, my_buffer, sizeof(my_buffer));
+        else if (my_kind == data_kind::relocatable)
+        {
+            std::memcpy(target.my_buffer, my_buffer, sizeof(my_buffer));
+            target.my_kind = my_kind;
+            my_kind = data_kind::none;
+            return;
+        }
+        else if (my_kind != data_kind::none)
+            stored_data()->move_to(target.my_buffer);
+        target.my_kind = my_kind;
+    }
+
+#if defined(DOT_INLINE_HOT) || defined(DOT_OBJECT_SOURCE)
+
+    template <>
+    DOT_HOT const class_id& object::id() noexcept
+    {
+        static const class_id object_id("object", class_info::of<object>());
+        return object_id;
+    }
+
+    DOT_HOT const class_id& object_data::id() noexcept
+    {
+        static const class_id object_data_id("object::data", class_info::of<object_data>());
+        return object_data_id;
+    }
+
+#endif
 }
 
 // Здесь должен быть Unicode
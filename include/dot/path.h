@@ -0,0 +1,81 @@
+// Выборка данных из дерева вложенных объектов по пути
+// вида "orders[*].items[*].sku" компилируемому один раз
+// результат выборки ссылается на данные без копирования
+
+#pragma once
+
+#include <dot/rope.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace dot
+{
+    // узлы дерева объектов: массив и запись с именованными полями
+    // хранятся в объекте через rope<T> и копируются без копирования данных
+    typedef std::vector<object> array;
+    typedef std::map<std::string, object> record;
+
+    // массив и запись хранятся по общей ссылке в объекте любой ёмкости
+    template <>
+    struct rope_only_class<array> : std::true_type { };
+
+    template <>
+    struct rope_only_class<record> : std::true_type { };
+
+    // скомпилированный путь выборки вложенных объектов
+    // поддерживает синтаксис близкий к JSONPath:
+    //   $.orders[*].items[0].sku   поля записей и индексы массивов
+    //   .*  [*]                    все вложенные элементы
+    //   [-1]  [1:3]  [::2]         индексы с конца и диапазоны
+    //   ['имя поля']               поле записи по имени в кавычках
+    //   [?(@.price > 10)]          фильтр элементов по условию
+    class DOT_PUBLIC path
+    {
+    public:
+        // компиляция выражения пути, при ошибке синтаксиса fail::bad_path
+        explicit path(const char* expression);
+        explicit path(const std::string& expression);
+        ~path() noexcept;
+
+        path(const path& another);
+        path& operator = (const path& another);
+
+        // перенесённый путь пуст: ничего не выбирает, выражение ""
+        path(path&& temporary) noexcept;
+        path& operator = (path&& temporary) noexcept;
+
+        // выборка всех совпадений, объекты разделяют данные с исходным деревом
+        std::vector<object> select(const object& root) const;
+
+        // выборка с добавлением в существующий буфер для его переиспользования
+        void select(const object& root, std::vector<object>& result) const;
+
+        // первое совпадение либо null объект если совпадений нет
+        object first(const object& root) const;
+
+        // есть ли хотя бы одно совпадение
+        bool matches(const object& root) const;
+
+        // исходное выражение пути
+        const char* expression() const noexcept;
+
+        // шаг пути после компиляции
+        class step;
+
+    private:
+        class instance;
+
+        instance* my_instance;
+    };
+
+    DOT_PUBLIC std::ostream& operator << (std::ostream& stream, const path& source);
+
+    // идентификаторы узлов дерева объектов
+    template<> DOT_PUBLIC const class_id& rope<array>::id() noexcept;
+    template<> DOT_PUBLIC const class_id& rope<array>::cow::id() noexcept;
+    template<> DOT_PUBLIC const class_id& rope<record>::id() noexcept;
+    template<> DOT_PUBLIC const class_id& rope<record>::cow::id() noexcept;
+}
+
+// Здесь должен быть Unicode
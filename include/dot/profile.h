@@ -0,0 +1,62 @@
+// Сводный профиль времени по скоупам трассировки
+// число вызовов, полное и собственное время каждого скоупа
+// и гистограммы задержек для перцентилей
+
+#pragma once
+
+#include <dot/trace.h>
+#include <dot/path.h>
+#include <atomic>
+
+namespace dot
+{
+    // trace::profile при включённом профилировании получает от каждого trace::scope
+    // время входа и выхода и копит по месту скоупа (имя, файл, строка)
+    // число вызовов, полное время и собственное время без вложенных скоупов;
+    // а также гистограмму длительностей с логарифмическими корзинами,
+    // каждая из которых делится ещё на 32 линейные, так что перцентили
+    // точны до 3%; каждый поток пишет только в свою таблицу без блокировок,
+    // а таблицы потоков сводятся вместе при чтении профиля
+    class DOT_PUBLIC trace::profile
+    {
+    public:
+        profile() = delete;
+
+        // включение и выключение сбора, накопленные данные сохраняются
+        static void start() noexcept;
+        static void stop() noexcept;
+        static bool profiling() noexcept;
+
+        // обнуление накопленного профиля всех потоков
+        static void reset();
+
+        // таблица скоупов по убыванию собственного времени
+        static void dump();
+        static void dump(std::ostream& stream);
+
+        // профиль в виде массива записей с полями name, file, line, count,
+        // inclusive, exclusive, p50, p90, p99, p999 и max, время в наносекундах
+        static array report();
+
+        // перцентили длительности скоупов с этим именем по всем потокам и местам:
+        // запись с полями count, p50, p90, p99, p999 и max либо null если вызовов не было
+        static object latency(const char* name);
+
+        // обработчик превышения бюджета скоупом, вызывается в потоке скоупа
+        // до его удаления из стека, так что бэктрейс включает сам скоуп
+        typedef void (*budget_handler)(const stack& backtrace, std::uint64_t elapsed, std::uint64_t budget);
+        static void set_budget_handler(budget_handler handler) noexcept;
+
+    private:
+        // проверяется скоупами на входе и выходе, сбор выключен по умолчанию
+        static std::atomic<bool> my_profiling;
+
+        static void begin(const char* name, const char* file, int line, std::uint64_t budget = 0) noexcept;
+        static void end() noexcept;
+
+        friend class scope;
+        friend class sampled_scope;
+    };
+}
+
+// Здесь должен быть Unicode
@@ -21,10 +21,36 @@
 #   define DOT_PUBLIC __declspec(dllimport)
 #endif
 
+// короткие частые методы определены в заголовках под DOT_HOT:
+// в сборке с DOT_INLINE_HOT они встраиваются в код программы,
+// иначе заголовок отдаёт определения только исходнику библиотеки;
+// в Windows только вместе с DOT_STATIC, так как статические идентификаторы
+// классов во встроенных методах иначе продублировались бы в каждом модуле
+#ifdef DOT_INLINE_HOT
+#   define DOT_HOT inline
+#else
+#   define DOT_HOT
+#endif
+
+// редкая ветвь частого метода не встраивается, чтобы сам метод оставался коротким
+#if defined(_MSC_VER)
+#   define DOT_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__)
+#   define DOT_NOINLINE __attribute__((noinline))
+#else
+#   define DOT_NOINLINE
+#endif
+
+#include <cstddef>
+
 namespace dot
 {
-    // базовый объект
-    class object;
+    // базовый объект с буфером на capacity байт данных
+    template <std::size_t capacity>
+    class basic_object;
+
+    // объект по умолчанию вмещает в буфер 2 int64 либо 4 float
+    typedef basic_object<16> object;
 
     // базовый класс для всех box
     class box_based;
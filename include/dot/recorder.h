@@ -0,0 +1,51 @@
+// Запись времени входа и выхода скоупов трассировки
+// в формате Chrome Trace Event для просмотра в chrome://tracing и Perfetto
+
+#pragma once
+
+#include <dot/trace.h>
+#include <atomic>
+
+namespace dot
+{
+    // trace::recorder при включённой записи получает от каждого trace::scope
+    // метки времени входа и выхода в кольцевой буфер своего потока без блокировок,
+    // а фоновый поток периодически выгружает события из буферов в файл;
+    // время берётся из монотонных часов std::chrono::steady_clock
+    class DOT_PUBLIC trace::recorder
+    {
+    public:
+        recorder() = delete;
+
+        // начало записи в файл, предыдущая запись завершается
+        // capacity задаёт размер буфера в событиях для потоков, ещё не писавших события,
+        // и округляется до степени 2
+        // при переполнении буфера события теряются и учитываются в dropped()
+        static void start(const char* path, std::size_t capacity = 1 << 16);
+
+        // завершение записи с выгрузкой всех оставшихся событий
+        static void stop();
+
+        // принудительная выгрузка накопленных событий в файл
+        static void flush();
+
+        static bool recording() noexcept;
+
+        // число событий потерянных из-за переполнения буферов с начала записи
+        static std::size_t dropped() noexcept;
+
+    private:
+        class session;
+
+        // проверяется скоупами на входе и выходе, запись выключена по умолчанию
+        static std::atomic<bool> my_recording;
+
+        static void begin(const char* name, const char* file, int line) noexcept;
+        static void end() noexcept;
+
+        friend class scope;
+        friend class sampled_scope;
+    };
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,49 @@
+// Реестр классов иерархии: от индекса или имени класса
+// к его сведениям, фабрике и кодеку данных
+
+#pragma once
+
+#include <dot/type.h>
+
+namespace dot
+{
+    // class_registry заполняется конструктором class_id: классы с DOT_REGISTER_CLASS
+    // регистрируются при загрузке модуля, остальные при первом вызове id();
+    // поиск по плотному индексу идёт без блокировок за O(1),
+    // поиск по имени хешем под блокировкой, при повторе имени остаётся первый класс
+    class DOT_PUBLIC class_registry
+    {
+    public:
+        // двоичная запись и чтение данных класса, задаются отдельно от DOT_CLASS_ID
+        class codec
+        {
+        public:
+            void (*write)(const hierarchic& source, std::ostream& stream) = nullptr;
+            void (*read)(std::istream& stream, hierarchic& target) = nullptr;
+        };
+
+        // идентификатор по индексу либо имени, пусто для неизвестного класса
+        static const class_id* find(uint64 index) noexcept;
+        static const class_id* find(const char* name) noexcept;
+
+        // наибольший выданный индекс класса, индексы начинаются с единицы
+        static uint64 last_index() noexcept;
+
+        // является ли ancestor самим классом derived либо его предком,
+        // проверка идёт по сведениям из DOT_HIERARCHIC без виртуальных вызовов
+        static bool derives(const class_id& derived, const class_id& ancestor) noexcept;
+
+        // кодек класса, пусто пока не задан; заданный кодек живёт до выхода из программы,
+        // поэтому найденный ранее указатель годен и после замены либо снятия кодека
+        static void set_codec(const class_id& identifier, const codec& value);
+        static void remove_codec(const class_id& identifier) noexcept;
+        static const codec* find_codec(const class_id& identifier) noexcept;
+
+    private:
+        friend class class_id;
+
+        static void add(const class_id& identifier) noexcept;
+    };
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,153 @@
+// Результат операции без исключений: значение либо код ошибки
+// с описанием, которое строится только по запросу
+
+#pragma once
+
+#include <dot/public.h>
+#include <dot/stdfwd.h>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace dot
+{
+    class class_id;
+
+    // код неудачи операции, возвращающей dot::result
+    enum class result_code
+    {
+        ok,
+        null_reference,
+        bad_typecast
+    };
+
+    // описание неудачи: код и идентификаторы классов приведения,
+    // не выделяет памяти, а текст сообщения строится только в detail()
+    class DOT_PUBLIC result_error
+    {
+    public:
+        result_error() noexcept = default;
+        explicit result_error(result_code code, const class_id* to_type = nullptr, const class_id* from_type = nullptr) noexcept;
+
+        result_code code() const noexcept;
+
+        // идентификаторы классов для неудачного приведения типа, иначе пусты
+        const class_id* to_type() const noexcept;
+        const class_id* from_type() const noexcept;
+
+        // текст сообщения, тот же что и у соответствующего исключения
+        std::string detail() const;
+
+        // генерация исключения dot::fail, соответствующего коду
+        [[noreturn]] void raise() const;
+
+    private:
+        result_code my_code = result_code::ok;
+        const class_id* my_to_type = nullptr;
+        const class_id* my_from_type = nullptr;
+    };
+
+    // dot::result хранит либо значение, либо описание неудачи;
+    // результат-ссылка хранит указатель на значение без копирования;
+    // заголовок не генерирует исключений и годится для сборки без них,
+    // исключение бросается только из value() при неудаче
+    template <typename value_type>
+    class result
+    {
+    public:
+        result(value_type value) noexcept(std::is_nothrow_move_constructible_v<value_type>);
+        result(const result_error& error) noexcept;
+
+        bool ok() const noexcept;
+        explicit operator bool() const noexcept;
+
+        result_code code() const noexcept;
+        const result_error& error() const noexcept;
+
+        // значение либо исключение dot::fail при неудаче,
+        // в сборке без исключений неудачу нужно проверять заранее
+        value_type value() const;
+
+        // значение либо переданная замена при неудаче
+        value_type value_or(value_type fallback) const noexcept(std::is_nothrow_copy_constructible_v<value_type>);
+
+        // значение без проверки, только для результата с ok()
+        using reference = std::conditional_t<std::is_reference_v<value_type>, value_type, const value_type&>;
+        reference operator * () const noexcept;
+
+    private:
+        static constexpr bool is_reference = std::is_reference_v<value_type>;
+        using stored_type = std::conditional_t<is_reference, std::remove_reference_t<value_type>*, value_type>;
+
+        std::optional<stored_type> my_value;
+        result_error my_error;
+    };
+
+// -- шаблонные методы --
+
+    template <typename value_type>
+    result<value_type>::result(value_type value) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+    {
+        if constexpr (is_reference)
+            my_value.emplace(&value);
+        else
+            my_value.emplace(std::move(value));
+    }
+
+    template <typename value_type>
+    result<value_type>::result(const result_error& error) noexcept
+        : my_error(error)
+    {
+    }
+
+    template <typename value_type>
+    bool result<value_type>::ok() const noexcept
+    {
+        return my_value.has_value();
+    }
+
+    template <typename value_type>
+    result<value_type>::operator bool() const noexcept
+    {
+        return my_value.has_value();
+    }
+
+    template <typename value_type>
+    result_code result<value_type>::code() const noexcept
+    {
+        return my_error.code();
+    }
+
+    template <typename value_type>
+    const result_error& result<value_type>::error() const noexcept
+    {
+        return my_error;
+    }
+
+    template <typename value_type>
+    value_type result<value_type>::value() const
+    {
+        if (!my_value.has_value())
+            my_error.raise();
+        return **this;
+    }
+
+    template <typename value_type>
+    value_type result<value_type>::value_or(value_type fallback) const noexcept(std::is_nothrow_copy_constructible_v<value_type>)
+    {
+        if (!my_value.has_value())
+            return fallback;
+        return **this;
+    }
+
+    template <typename value_type>
+    typename result<value_type>::reference result<value_type>::operator * () const noexcept
+    {
+        if constexpr (is_reference)
+            return **my_value;
+        else
+            return *my_value;
+    }
+}
+
+// Здесь должен быть Unicode
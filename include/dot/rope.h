@@ -83,6 +83,10 @@ namespace dot
 
         DOT_HIERARCHIC(rope_based);
 
+        // создаётся по умолчанию, только если по умолчанию создаётся значение
+        typedef rope hint_owner;
+        static constexpr bool default_constructible = std::is_default_constructible_v<fat>;
+
         class cow;
 
     private:
@@ -90,12 +94,12 @@ namespace dot
     };
 
     // сравнения произвольных типов слева с объектами-"верёвками"
-    template <typename left, typename right> bool operator == (const left& x, const rope<right>& y);
-    template <typename left, typename right> bool operator != (const left& x, const rope<right>& y);
-    template <typename left, typename right> bool operator <= (const left& x, const rope<right>& y);
-    template <typename left, typename right> bool operator >= (const left& x, const rope<right>& y);
-    template <typename left, typename right> bool operator <  (const left& x, const rope<right>& y);
-    template <typename left, typename right> bool operator >  (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator == (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator != (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator <= (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator >= (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator <  (const left& x, const rope<right>& y);
+    template <typename left, typename right, typename = std::enable_if_t<!std::is_base_of_v<object, left>>> bool operator >  (const left& x, const rope<right>& y);
 
     // базовый тип для всех данных-"коров"
     class DOT_PUBLIC rope_based::cow_based : public object::data
@@ -139,6 +143,12 @@ namespace dot
 
         DOT_HIERARCHIC(rope_based::cow_based);
 
+        typedef cow hint_owner;
+        static constexpr bool default_constructible = std::is_default_constructible_v<fat>;
+
+        // "корова" хранит лишь указатель на "шею": побайтный перенос не меняет счётчик ссылок
+        static constexpr bool trivially_relocatable = true;
+
     protected:
         // копирование и перенос ссылки в буфер другого объекта
         virtual object::data* copy_to(void* buffer) const noexcept override;
@@ -152,6 +162,9 @@ namespace dot
         virtual bool equals(const object::data& another) const noexcept override;
         virtual bool less(const object::data& another) const noexcept override;
 
+        // значение по метке типа, только у данных ровно этого класса
+        virtual const void* find_value(const void* tag) const noexcept override;
+
     private:
         // вспомогательная структура "шея" "коровы"
         // хранит счётчик ссылок и значение толстого типа
@@ -185,6 +198,9 @@ namespace dot
         };
 
         neck* my_neck;
+
+        // своя копия значения общей "шеи" для изменения
+        DOT_NOINLINE void separate();
     };
 
 // -- шаблонные методы --
@@ -293,7 +309,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to compare rope_based of non comparable types.");
+            static_assert(!sizeof(other), "Unable to compare rope_based of non comparable types.");
         }
     }
 
@@ -328,7 +344,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to order rope_based of non orderable types.");
+            static_assert(!sizeof(other), "Unable to order rope_based of non orderable types.");
         }
     }
 
@@ -353,7 +369,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to compare rope_based with non comparable type.");
+            static_assert(!sizeof(other), "Unable to compare rope_based with non comparable type.");
         }
     }
 
@@ -392,7 +408,7 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to order rope_based with non orderable type.");
+            static_assert(!sizeof(other), "Unable to order rope_based with non orderable type.");
         }
     }
 
@@ -410,41 +426,41 @@ namespace dot
         }
         else
         {
-            static_assert(false, "Unable to order rope_based with non orderable type.");
+            static_assert(!sizeof(other), "Unable to order rope_based with non orderable type.");
         }
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator == (const left& x, const rope<right>& y)
     {
         return y == x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator != (const left& x, const rope<right>& y)
     {
         return y != x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator <= (const left& x, const rope<right>& y)
     {
         return y >= x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator >= (const left& x, const rope<right>& y)
     {
         return y <= x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator < (const left& x, const rope<right>& y)
     {
         return y > x;
     }
 
-    template <typename left, typename right>
+    template <typename left, typename right, typename>
     bool operator > (const left& x, const rope<right>& y)
     {
         return y < x;
@@ -551,15 +567,20 @@ namespace dot
     template <class fat>
     fat& rope<fat>::cow::touch()
     {
+        // проверка остаётся короткой для встраивания, копия вынесена отдельно
         if (my_neck->bound > 1)
-        {
-            neck* old_block = my_neck;
-            my_neck = new neck(my_neck->value);
-            old_block->remove_rope();
-        }
+            separate();
         return my_neck->value;
     }
 
+    template <class fat>
+    void rope<fat>::cow::separate()
+    {
+        neck* old_block = my_neck;
+        my_neck = new neck(my_neck->value);
+        old_block->remove_rope();
+    }
+
     template <class fat>
     bool rope<fat>::cow::equals(const object::data& another) const noexcept
     {
@@ -567,6 +588,9 @@ namespace dot
         {
             if (another.is<cow>())
                 return look() == another.as<cow>().look();
+            // то же значение в другом виде данных, например из объекта другой ёмкости
+            else if (const fat* value = another.value_as<fat>())
+                return look() == *value;
             else
                 return base::equals(another);
         }
@@ -583,6 +607,9 @@ namespace dot
         {
             if (another.is<cow>())
                 return look() < another.as<cow>().look();
+            // то же значение в другом виде данных, например из объекта другой ёмкости
+            else if (const fat* value = another.value_as<fat>())
+                return look() < *value;
             else
                 return base::less(another);
         }
@@ -591,6 +618,12 @@ namespace dot
             return base::less(another);
         }
     }
+
+    template <class fat>
+    const void* rope<fat>::cow::find_value(const void* tag) const noexcept
+    {
+        return tag == &value_tag<fat> && my_id() == id() ? &look() : nullptr;
+    }
 }
 
 // Здесь должен быть Unicode
@@ -0,0 +1,60 @@
+// Выборочный профиль по сигналу таймера процессорного времени
+// в формате свёрнутых стеков для построения flame graph
+
+#pragma once
+
+#include <dot/trace.h>
+#include <chrono>
+#include <atomic>
+
+namespace dot
+{
+    // trace::sampler по сигналу SIGPROF таймера процессорного времени процесса
+    // читает стек трассировки прерванного потока прямо в обработчике сигнала:
+    // без блокировок и выделения памяти, в заранее выделенный буфер выборок;
+    // фоновый поток сводит выборки по одинаковым стекам, а dump выводит их
+    // строками "корень;вызов;вершина число" для flamegraph.pl и speedscope;
+    // в отличие от perf не нужны ни указатели кадров, ни отладочная информация,
+    // зато в стеке только скоупы трассировки, выборки вне скоупов
+    // сводятся в отдельный стек с именем trace::sampler::outside
+    class DOT_PUBLIC trace::sampler
+    {
+    public:
+        sampler() = delete;
+
+        // начало сбора выборок с заданным периодом процессорного времени,
+        // capacity задаёт число выборок в буфере и округляется до степени 2,
+        // при переполнении буфера выборки теряются и учитываются в dropped();
+        // поддерживается только в POSIX системах, иначе бросается fail::error
+        static void start(std::chrono::microseconds interval = std::chrono::milliseconds(1),
+            std::size_t capacity = 1 << 12);
+
+        // остановка таймера со сведением оставшихся выборок, накопленное сохраняется
+        static void stop();
+
+        static bool sampling() noexcept;
+
+        // обнуление накопленных выборок
+        static void reset();
+
+        // свёрнутые стеки от корня к вершине с числом выборок в каждом
+        static void dump(std::ostream& stream);
+
+        // число сведённых выборок и потерянных из-за переполнения буфера
+        static std::size_t samples() noexcept;
+        static std::size_t dropped() noexcept;
+
+        // глубина стека в выборке, более глубокие кадры отбрасываются со стороны вершины
+        static constexpr std::size_t depth = 64;
+
+        // имя стека выборок потоков вне скоупов трассировки
+        static constexpr const char* outside = "[вне скоупов]";
+
+    private:
+        class session;
+
+        static std::atomic<bool> my_sampling;
+    };
+}
+
+// Здесь должен быть Unicode
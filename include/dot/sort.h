@@ -0,0 +1,30 @@
+// Сортировка массивов объектов по нормализованным ключам
+// ключи сравниваются побайтно без виртуальных вызовов
+// а сама сортировка выполняется параллельно на всех ядрах
+
+#pragma once
+
+#include <dot/object.h>
+#include <string>
+#include <vector>
+
+namespace dot
+{
+    // нормализованный ключ сортировки объекта: ранг типа и значение
+    // закодированное так что побайтное сравнение ключей даёт порядок
+    //   null < bool < числа < string < wstring < u16string < u32string < прочие
+    // целые и дробные любых типов упорядочены между собой по значению, равные числа
+    // разных типов дают один ключ, как и в сравнении объектов,
+    // для прочих типов ключ содержит только ранг и порядок задаёт object::operator <
+    DOT_PUBLIC std::string sort_key(const object& value);
+
+    // ранг прочих типов без нормализованного кодирования значения
+    constexpr byte sort_key_unordered = 0xFF;
+
+    // сортировка объектов по нормализованным ключам в threads потоков
+    // при threads == 0 используются все доступные ядра процессора
+    // равные объекты сохраняют исходный порядок
+    DOT_PUBLIC void sort(std::vector<object>& objects, uint threads = 0);
+}
+
+// Здесь должен быть Unicode
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#ifdef _MSC_VER
+
 namespace std
 {
     typedef decltype(nullptr) nullptr_t;
@@ -34,4 +36,13 @@ namespace std
     typedef basic_istream<wchar_t, char_traits<wchar_t>> wistream;
 }
 
+#else
+
+// libstdc++ и libc++ объявляют строки во вложенных inline-пространствах имён,
+// поэтому объявления берутся из <iosfwd>, где уже есть строки и потоки
+#include <iosfwd>
+#include <cstddef>
+
+#endif
+
 // Здесь должен быть Unicode
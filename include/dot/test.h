@@ -5,7 +5,13 @@
 #pragma once
 
 #include <dot/fail.h>
+#include <dot/counters.h>
+#include <dot/allocations.h>
 #include <iosfwd>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
 
 namespace dot
 {
@@ -48,8 +54,21 @@ namespace dot
         // абстракция для текстового вывода
         class output;
 
-        // запуск всех написанных наборов тестов
+        // замер производительности вида DOT_BENCHMARK(name)
+        class benchmark;
+
+        // настройки запуска: число потоков и повторов наборов, замеры
+        class settings;
+
+        // запуск всех написанных наборов тестов, а по настройкам и замеров;
+        // false если есть сбои наборов или регрессии замеров
         static void run() noexcept;
+        static bool run(const settings& options) noexcept;
+
+        // функция main тестовой программы: разбор аргументов, запуск и код возврата,
+        // defaults задают настройки до разбора аргументов, например замеры для bench_dot
+        static int main(int argc, const char* const argv[]);
+        static int main(int argc, const char* const argv[], const settings& defaults);
 
         // вспомогательный метод для читаемости создания проверок
         template <typename fail_type, typename argument_type>
@@ -83,19 +102,201 @@ namespace dot
         suite() noexcept;
         virtual const char* name() const noexcept = 0;
         virtual void run() = 0;
+
+        // набор меняет общее состояние процесса и запускается в пуле один
+        virtual bool exclusive() const noexcept;
     };
 
+    // test::settings задаёт запуск наборов тестов в пуле потоков;
+    // вывод наборов всегда идёт в порядке их объявления, как и без пула,
+    // а повтор каждого набора помогает поймать редкие гонки потоков
+    class DOT_PUBLIC test::settings
+    {
+    public:
+        // число потоков, 0 - по числу процессоров, 1 - последовательный запуск
+        std::size_t jobs = 1;
+
+        // сколько раз запускается каждый набор тестов
+        std::size_t repeat = 1;
+
+        // сколько самых медленных наборов вывести после запуска
+        std::size_t slowest = 5;
+
+        // запуск замеров DOT_BENCHMARK после наборов тестов
+        bool benchmarks = false;
+
+        // время каждого замера, делится поровну на samples повторов
+        std::chrono::milliseconds bench_time = std::chrono::milliseconds(200);
+        std::size_t bench_samples = 10;
+
+        // файл базовых результатов для сравнения и файл для сохранения замеров
+        const char* baseline = nullptr;
+        const char* save_baseline = nullptr;
+
+        // допустимое замедление самого быстрого повтора относительно базы в процентах
+        double threshold = 10;
+
+        // аппаратные счётчики вокруг наборов и замеров, если они доступны
+        bool counters = false;
+
+        // отбор наборов и замеров по имени: шаблон с * и ? либо часть имени,
+        // несколько шаблонов через запятую
+        const char* filter = nullptr;
+
+        // перемешанный порядок запусков наборов, seed 0 выбирается по часам и выводится
+        bool shuffle = false;
+        unsigned seed = 0;
+
+        // каждый отобранный набор подряд loop раз в потоке запуска без вывода прогонов,
+        // например для perf record -- test_dot --filter name --loop 10000
+        std::size_t loop = 0;
+
+        // файл отчёта JSON о наборах и замерах
+        const char* report = nullptr;
+
+        // только вывод имён наборов и замеров, справка, ожидание Enter после запуска
+        bool list = false;
+        bool help = false;
+        bool pause = false;
+
+        // false если среди аргументов были неизвестные или без значения
+        bool valid = true;
+
+        // разбор аргументов командной строки --jobs N, --repeat N, --slowest N,
+        // --bench, --bench-time MS, --baseline FILE, --save-baseline FILE, --threshold P,
+        // --counters, --filter PATTERN, --shuffle, --seed N, --loop N, --json FILE,
+        // --list, --help, --pause; defaults задают значения до разбора
+        static settings parse(int argc, const char* const argv[]);
+        static settings parse(int argc, const char* const argv[], const settings& defaults);
+
+        // подходит ли имя набора или замера под filter
+        bool selects(const char* name) const noexcept;
+
+        // описание аргументов командной строки
+        static void usage(std::ostream& stream);
+    };
+
+    // test::benchmark описывается макросом DOT_BENCHMARK рядом с наборами тестов;
+    // число итераций подбирается так, чтобы повтор замера длился заданное время,
+    // а по повторам считаются среднее время операции и его разброс
+    class DOT_PUBLIC test::benchmark
+    {
+    public:
+        benchmark() noexcept;
+        virtual const char* name() const noexcept = 0;
+
+        // итерации замера, время идёт от первого до последнего вызова next()
+        class loop;
+        virtual void run(loop& iterations) = 0;
+
+        // результат замера, allocations отрицательно без подмены operator new;
+        // fastest - время операции в самом быстром повторе, меньше всего
+        // зависит от помех соседних процессов и сравнивается с базой;
+        // счётчики на операцию отрицательны, если они не собирались или недоступны
+        class measurement
+        {
+        public:
+            const char* name = nullptr;
+            std::uint64_t iterations = 0;
+            double nanoseconds = 0;
+            double deviation = 0;
+            double fastest = 0;
+            double per_second = 0;
+            double allocations = -1;
+            double cycles = -1;
+            double instructions = -1;
+            double cache_misses = -1;
+            double branch_misses = -1;
+        };
+
+        // калибровка числа итераций и samples повторов по slice времени,
+        // с counters повторы собирают аппаратные счётчики текущего потока
+        measurement measure(std::chrono::nanoseconds slice, std::size_t samples, bool counters = false);
+
+        // дополнение строки вывода замера, например итоговой пропускной способностью
+        virtual void describe(const measurement& result, std::ostream& stream) const;
+
+        // все отобранные замеры с выводом и сравнением с базой, возвращает число регрессий,
+        // результаты замеров добавляются в results, если он передан
+        static std::size_t run_all(const settings& options, std::vector<measurement>* results = nullptr);
+
+        // имена всех замеров в порядке объявления
+        static std::vector<const char*> names();
+
+        // барьер, после которого оптимизатор считает значение использованным
+        template <typename value_type>
+        static void keep(value_type&& value) noexcept;
+
+    private:
+        static void escape(const volatile void* pointer) noexcept;
+    };
+
+    // test::benchmark::loop считает итерации без обращений к часам,
+    // часы и счётчики читаются только в начале и конце цикла,
+    // аппаратные счётчики запускаются до часов и останавливаются после них
+    class DOT_PUBLIC test::benchmark::loop
+    {
+    public:
+        explicit loop(std::uint64_t iterations, trace::counters* group = nullptr) noexcept;
+
+        // цикл замера вида while (loop.next()) { ... }
+        bool next() noexcept
+        {
+            if (my_left)
+            {
+                --my_left;
+                return true;
+            }
+            return turn();
+        }
+
+        std::uint64_t iterations() const noexcept;
+        std::uint64_t elapsed() const noexcept;
+        std::uint64_t allocations() const noexcept;
+        const trace::counters::values& counters() const noexcept;
+
+    private:
+        std::uint64_t my_left = 0;
+        std::uint64_t my_iterations;
+        std::uint64_t my_start = 0;
+        std::uint64_t my_elapsed = 0;
+        std::uint64_t my_allocations = 0;
+        int my_stage = 0;
+        trace::counters* my_group;
+        trace::counters::values my_counters;
+
+        bool turn() noexcept;
+    };
+
+    template <typename value_type>
+    void test::benchmark::keep(value_type&& value) noexcept
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        escape(&reinterpret_cast<const volatile char&>(value));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
 // макрос DOT_TEST_SUITE создаёт читаемый код метода набора тестовых проверок
 // внутри можно описать обычное тело метода с DOT_CHECK/DOT_ENSURE/DOT_ASSERT
 // dot::test::run() сам найдёт все описанные DOT_TEST_SUITE наборы тестов
 // а выявленные ошибки получат читаемый бэктрейс вплоть до начала набора
-#define DOT_TEST_SUITE(suite_name) \
+#define DOT_TEST_SUITE(suite_name) DOT_TEST_SUITE_CLASS(suite_name, false)
+
+// макрос DOT_TEST_SUITE_EXCLUSIVE для наборов, которые включают общие для процесса
+// сеансы трассировки и не могут идти в пуле одновременно с другими наборами
+#define DOT_TEST_SUITE_EXCLUSIVE(suite_name) DOT_TEST_SUITE_CLASS(suite_name, true)
+
+#define DOT_TEST_SUITE_CLASS(suite_name, is_exclusive) \
 class test_suite_##suite_name : public test::suite \
 { \
 public: \
     virtual const char* name() const noexcept override { return #suite_name; } \
+    virtual bool exclusive() const noexcept override { return is_exclusive; } \
     virtual void run() override { \
-        trace::scope run_scope(#suite_name, __FILE__, __LINE__); \
+        DOT_TRACE_SCOPE(run_scope, #suite_name) \
         body(); \
     } \
 private: \
@@ -103,6 +304,28 @@ private: \
 } g_##suite_name; \
 void test_suite_##suite_name::body()
 
+// макрос DOT_TEST_MAIN создаёт функцию main тестовой программы в одном из её файлов,
+// аргументы командной строки разбирает test::settings::parse
+#define DOT_TEST_MAIN \
+int main(int argc, char* argv[]) \
+{ \
+    return dot::test::main(argc, argv); \
+}
+
+// макрос DOT_BENCHMARK создаёт замер с телом вида обычного метода с параметром loop,
+// подготовка до цикла while (loop.next()) не попадает во время замера, например
+// DOT_BENCHMARK(object_copy) { object x(1); while (loop.next()) test::benchmark::keep(object(x)); }
+#define DOT_BENCHMARK(benchmark_name) \
+class test_benchmark_##benchmark_name : public test::benchmark \
+{ \
+public: \
+    virtual const char* name() const noexcept override { return #benchmark_name; } \
+    virtual void run(test::benchmark::loop& loop) override { body(loop); } \
+private: \
+    void body(test::benchmark::loop& loop); \
+} g_benchmark_##benchmark_name; \
+void test_benchmark_##benchmark_name::body(test::benchmark::loop& loop)
+
     // любая проверка в наборе тестов это экземпляры test::check
     // неявно использующиеся в макросах DOT_CHECK/DOT_ENSURE/DOT_ASSERT
     // использует методы и перегруженные операторы либо исключения
@@ -140,13 +363,21 @@ void test_suite_##suite_name::body()
         // проверка на исключение определённого класса в функции-операнде
         template <typename exception_type> void expect_exception() const;
 
+        // проверка числа выделений памяти через operator new в функции-операнде,
+        // считаются выделения только текущего потока
+        void allocates(std::uint64_t expected) const;
+
     private:
         // ссылка на операнд для проверки
         argument_type&& my_argument;
     };
 
 // создаёт по месту проверки метку дла бэктрейса
-#define DOT_SCOPE(name) trace::scope(name, __FILE__, __LINE__)
+#if DOT_TRACE_LEVEL > DOT_TRACE_LEVEL_OFF
+#define DOT_SCOPE(name) trace::scope(name, DOT_TRACE_FILE, __LINE__)
+#else
+#define DOT_SCOPE(name) static_cast<void>(name)
+#endif
 
 // DOT_CHECK созаёт единичную проверку в теле набора тестов
 // вида DOT_CHECK(x) == y; или DOT_CHECK(z).is<object>();
@@ -163,15 +394,27 @@ void test_suite_##suite_name::body()
 // пример: DOT_CHECK_EXPECT_EXCEPTION(std::exception, x = y);
 #define DOT_CHECK_EXPECT_EXCEPTION(exception_class, operation) DOT_CHECK([&]() { operation; }).expect_exception<exception_class>()
 
+// DOT_CHECK_NO_ALLOCATION проверяет что единичная операция не выделяет память,
+// а DOT_CHECK_ALLOCATIONS что она выделяет память ровно указанное число раз
+// пример: DOT_CHECK_NO_ALLOCATION(x.look()); или DOT_CHECK_ALLOCATIONS(y.touch(), 1);
+// выделения видны только при подмене operator new макросом DOT_TRACE_ALLOCATIONS_HOOK
+// в тестовой программе, без неё такие проверки проваливаются, а в Windows пропускаются
+#define DOT_CHECK_NO_ALLOCATION(operation) DOT_CHECK([&]() { operation; }).allocates(0)
+#define DOT_CHECK_ALLOCATIONS(operation, count) DOT_CHECK([&]() { operation; }).allocates(count)
+
 // DOT_ENSURE те же макросы что и для DOT_CHECK, но прерывают весь набор тестов
 #define DOT_ENSURE(argument) DOT_SCOPE("Блокирующее условие"), test::make_check<test::suite_fail>(argument)
 #define DOT_ENSURE_NO_EXCEPTION(operation) DOT_ENSURE([&]() { operation; }).no_exception()
 #define DOT_ENSURE_EXPECT_EXCEPTION(exception_class, operation) DOT_ENSURE([&]() { operation; }).expect_exception<exception_class>()
+#define DOT_ENSURE_NO_ALLOCATION(operation) DOT_ENSURE([&]() { operation; }).allocates(0)
+#define DOT_ENSURE_ALLOCATIONS(operation, count) DOT_ENSURE([&]() { operation; }).allocates(count)
 
 // DOT_ASSERT те же макросы что и для DOT_CHECK, но прерывают весь запуск тестов
 #define DOT_ASSERT(argument) DOT_SCOPE("Критическая проверка"), test::make_check<test::run_fail>(argument)
 #define DOT_ASSERT_NO_EXCEPTION(operation) DOT_ASSERT([&]() { operation; }).no_exception()
 #define DOT_ASSERT_EXPECT_EXCEPTION(exception_class, operation) DOT_ASSERT([&]() { operation; }).expect_exception<exception_class>()
+#define DOT_ASSERT_NO_ALLOCATION(operation) DOT_ASSERT([&]() { operation; }).allocates(0)
+#define DOT_ASSERT_ALLOCATIONS(operation, count) DOT_ASSERT([&]() { operation; }).allocates(count)
 
     // test::check_fail генерирует исключение прерывающее только текущую проверку
     // с сообщением об ошибке и бэктрейсе с дальнейшим выполнением набора тестов
@@ -345,7 +588,7 @@ void test_suite_##suite_name::body()
     {
         test::ensure<fail_type>(
             [=]() -> bool {
-                return static_cast<const object&>(my_argument).is_null();
+                return my_argument.is_null();
             },
             DOT_TEST_OUTPUT_ANY " is null",
             std::forward<argument_type>(my_argument)
@@ -357,7 +600,7 @@ void test_suite_##suite_name::body()
     {
         test::ensure<fail_type>(
             [=]() -> bool {
-                return static_cast<const object&>(my_argument).is_not_null();
+                return my_argument.is_not_null();
             },
             DOT_TEST_OUTPUT_ANY " is not null",
             std::forward<argument_type>(my_argument)
@@ -540,6 +783,32 @@ void test_suite_##suite_name::body()
             exception_type::id().name());
         handle_fail<fail_type>(out.message());
     }
+
+    template <typename fail_type, typename argument_type>
+    void test::check<fail_type, argument_type>::allocates(std::uint64_t expected) const
+    {
+        if (!trace::allocations::hooked())
+        {
+#ifdef _WIN32
+            // в Windows подмена operator new не видит выделений внутри dot.dll,
+            // поэтому операция выполняется без проверки числа выделений
+            my_argument();
+#else
+            handle_fail<fail_type>("Выделения памяти не видны: operator new не подменён макросом DOT_TRACE_ALLOCATIONS_HOOK.");
+#endif
+            return;
+        }
+        const std::uint64_t before = trace::allocations::thread_count();
+        my_argument();
+        const std::uint64_t actual = trace::allocations::thread_count() - before;
+        if (actual != expected)
+        {
+            test::output out;
+            out.print("Ожидается выделений памяти: " DOT_TEST_OUTPUT_ANY ", но выделено: " DOT_TEST_OUTPUT_ANY,
+                expected, actual);
+            handle_fail<fail_type>(out.message());
+        }
+    }
 }
 
 // Здесь должен быть Unicode
@@ -4,6 +4,31 @@
 
 #include <dot/public.h>
 #include <dot/stdfwd.h>
+#include <type_traits>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// путь до каталога тестов, всё что до него отрезается от имени файла
+#ifdef _WIN32
+#define DOT_TESTS_PATH "\\dot\\tests\\"
+#else
+#define DOT_TESTS_PATH "/dot/tests/"
+#endif
+
+// уровни трассировки задаются на всю сборку определением DOT_TRACE_LEVEL
+// OFF     - скоупы не компилируются вовсе, бэктрейсы ошибок пусты
+// ERRORS  - только скоупы мест проверок DOT_SCOPE и DOT_TRACE_SCOPE
+// SAMPLED - вызовы DOT_TRACE_CALL записываются в 1 из N корневых скоупов потока
+// FULL    - записываются все скоупы, уровень по умолчанию
+#define DOT_TRACE_LEVEL_OFF     0
+#define DOT_TRACE_LEVEL_ERRORS  1
+#define DOT_TRACE_LEVEL_SAMPLED 2
+#define DOT_TRACE_LEVEL_FULL    3
+
+#ifndef DOT_TRACE_LEVEL
+#define DOT_TRACE_LEVEL DOT_TRACE_LEVEL_FULL
+#endif
 
 namespace dot
 {
@@ -13,20 +38,58 @@ namespace dot
         trace() = delete;
 
         class scope;
+        class sampled_scope;
         class stack;
+        class recorder;
+        class profile;
+        class sampler;
+        class watchdog;
+        class allocations;
+        class counters;
+
+        // наносекунды монотонных часов для замеров времени скоупов
+        static std::uint64_t now() noexcept;
+
+        // записывается первый и далее каждый period-й корневой скоуп потока, по умолчанию 1 из 100
+        // при period == 1 записываются все, при period == 0 ни один
+        static void set_sampling(std::size_t period) noexcept;
+        static std::size_t get_sampling() noexcept;
+
+        // смещение имени файла от каталога тестов для отрезания пути
+        // вычисляется на этапе компиляции в макросе DOT_TRACE_FILE
+        static constexpr std::size_t file_offset(const char* file) noexcept;
     };
 
     // trace::scope запоминает имя/файл/строку в trace::stack
     // на время жизни объекта и удаляет их при удалении скоупа
+    // хранятся только указатели, поэтому имя и файл должны жить
+    // дольше скоупа, обычно это литералы __FUNCTION__ и __FILE__
     class DOT_PUBLIC trace::scope
     {
     public:
         scope(const char* name, const char* file, int line) noexcept;
+
+        // скоуп с бюджетом времени: при включённом профиле его превышение
+        // передаётся обработчику trace::profile вместе с бэктрейсом
+        scope(const char* name, const char* file, int line, std::chrono::nanoseconds budget) noexcept;
+
         virtual ~scope() noexcept;
     };
 
+    // trace::sampled_scope записывается в стек только если корневой скоуп
+    // потока, открытый при пустом стеке, попал в выборку 1 из N,
+    // иначе ни он, ни вложенные в него выборочные скоупы не записываются
+    class DOT_PUBLIC trace::sampled_scope
+    {
+    public:
+        sampled_scope(const char* name, const char* file, int line) noexcept;
+        ~sampled_scope() noexcept;
+    };
+
     // trace::stack представляет собой стек из объектов test::scope
     // чтобы в каждый момент времени мы могли получить бэктрейс ошибки
+    // кадры стека образуют неизменяемый список с общим хвостом,
+    // поэтому копия стека лишь ссылается на вершину и не зависит от глубины
     class DOT_PUBLIC trace::stack
     {
     public:
@@ -42,6 +105,11 @@ namespace dot
         stack(const stack& another, const char* message) noexcept;
         stack(stack&& temporary, const char* message) noexcept;
 
+        class snapshot;
+
+        // стек по ссылке на кадры, снятой без выделения памяти
+        explicit stack(const snapshot& source) noexcept;
+
         void push(const char* name, const char* file, int line) noexcept;
         void pop() noexcept;
 
@@ -51,6 +119,13 @@ namespace dot
 
         bool empty() const noexcept;
         bool not_empty() const noexcept;
+        std::size_t depth() const noexcept;
+
+        class iterator;
+
+        // обход кадров от вершины стека к началу без его изменения
+        iterator begin() const noexcept;
+        iterator end() const noexcept;
 
         void set_message(const char* message) noexcept;
         const char* get_message() const noexcept;
@@ -58,17 +133,143 @@ namespace dot
 
         static stack& thread_stack() noexcept;
 
+        // глубина стека потока без выделения памяти, более глубокие
+        // скоупы учитываются при удалении, но не попадают в бэктрейс
+        static constexpr std::size_t capacity = 256;
+
     private:
-        class entry;
+        class frame;
         class instance;
 
         instance* my_instance;
+
+        explicit stack(instance* source) noexcept;
+
+        // вершина стека текущего потока без ленивой инициализации,
+        // безопасна для вызова из обработчика сигнала в этом же потоке
+        static iterator signal_top() noexcept;
+
+        // кадр стека другого потока, прочитанный без остановки потока
+        struct observed
+        {
+            const char* name;
+            const char* file;
+            int line;
+
+            // номер входа в скоуп, различает повторные входы на той же глубине
+            std::size_t serial;
+        };
+
+        // обход стеков всех живых потоков с кадрами от корня к вершине,
+        // потоки-владельцы не блокируются, при гонке с ними чтение повторяется
+        typedef void (*observer)(void* context, std::size_t thread, const observed* frames, std::size_t depth);
+        static void observe(observer action, void* context);
+
+        // скоупы работают с данными стека потока напрямую
+        friend class scope;
+        friend class sampled_scope;
+        friend class sampler;
+        friend class watchdog;
+        friend class allocations;
+    };
+
+    // trace::stack::snapshot ссылается на вершину стека потока в момент создания
+    // без выделения памяти, лишь увеличивая счётчик ссылок кадра;
+    // пока снимок жив, кадры не изменяются, а trace::stack строится из него по требованию
+    class DOT_PUBLIC trace::stack::snapshot
+    {
+    public:
+        snapshot() noexcept;
+        ~snapshot() noexcept;
+
+        snapshot(const snapshot& another) noexcept;
+        snapshot& operator = (const snapshot& another) noexcept;
+
+    private:
+        frame* my_top;
+        std::size_t my_depth;
+
+        friend class stack;
+    };
+
+    // итератор по кадрам стека, копия итератора не продлевает жизнь кадров,
+    // поэтому стек должен жить дольше обхода
+    class DOT_PUBLIC trace::stack::iterator
+    {
+    public:
+        explicit iterator(const frame* position = nullptr) noexcept;
+
+        const char* name() const noexcept;
+        const char* file() const noexcept;
+        int line() const noexcept;
+
+        const iterator& operator * () const noexcept;
+        iterator& operator ++ () noexcept;
+
+        bool operator == (const iterator& another) const noexcept;
+        bool operator != (const iterator& another) const noexcept;
+
+    private:
+        const frame* my_frame;
     };
 
     DOT_PUBLIC std::ostream& operator << (std::ostream& stream, const trace::stack& source);
     DOT_PUBLIC std::istream& operator >> (std::istream& stream, trace::stack& destination);
+
+    inline std::uint64_t trace::now() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    constexpr std::size_t trace::file_offset(const char* file) noexcept
+    {
+        constexpr const char* tests_path = DOT_TESTS_PATH;
+        for (std::size_t offset = 0; file[offset]; ++offset)
+        {
+            std::size_t length = 0;
+            while (tests_path[length] && file[offset + length] == tests_path[length])
+                ++length;
+            if (!tests_path[length])
+                return offset;
+        }
+        return 0;
+    }
 }
 
-#define DOT_TRACE_CALL trace::scope call_scope(__FUNCTION__, __FILE__, __LINE__);
+// thread_local без обращения к __tls_get_addr внутри динамической библиотеки
+// только для переменных самой библиотеки, работающих на каждом скоупе
+#if defined(__GNUC__) && !defined(_WIN32)
+#define DOT_FAST_THREAD_LOCAL __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define DOT_FAST_THREAD_LOCAL thread_local
+#endif
+
+// имя текущего файла без пути до каталога тестов, без вычислений при выполнении
+#define DOT_TRACE_FILE (__FILE__ + std::integral_constant<std::size_t, dot::trace::file_offset(__FILE__)>::value)
+
+// DOT_TRACE_CALL отмечает вызов функции в бэктрейсе до конца блока
+#if DOT_TRACE_LEVEL >= DOT_TRACE_LEVEL_FULL
+#define DOT_TRACE_CALL trace::scope call_scope(__FUNCTION__, DOT_TRACE_FILE, __LINE__);
+#elif DOT_TRACE_LEVEL == DOT_TRACE_LEVEL_SAMPLED
+#define DOT_TRACE_CALL trace::sampled_scope call_scope(__FUNCTION__, DOT_TRACE_FILE, __LINE__);
+#else
+#define DOT_TRACE_CALL
+#endif
+
+// DOT_TRACE_BUDGET отмечает вызов функции с бюджетом времени, например
+// DOT_TRACE_BUDGET(std::chrono::milliseconds(5)), записывается всегда кроме OFF и ERRORS
+#if DOT_TRACE_LEVEL >= DOT_TRACE_LEVEL_SAMPLED
+#define DOT_TRACE_BUDGET(budget) trace::scope call_scope(__FUNCTION__, DOT_TRACE_FILE, __LINE__, budget);
+#else
+#define DOT_TRACE_BUDGET(budget)
+#endif
+
+// DOT_TRACE_SCOPE отмечает место проверки ошибок, записывается всегда кроме уровня OFF
+#if DOT_TRACE_LEVEL > DOT_TRACE_LEVEL_OFF
+#define DOT_TRACE_SCOPE(variable, name) trace::scope variable(name, DOT_TRACE_FILE, __LINE__);
+#else
+#define DOT_TRACE_SCOPE(variable, name)
+#endif
 
 // Здесь должен быть Unicode
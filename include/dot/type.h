@@ -6,8 +6,11 @@
 
 #include <dot/public.h>
 #include <dot/stdfwd.h>
+#include <dot/result.h>
 #include <type_traits>
 #include <cstdint>
+#include <cstddef>
+#include <new>
 
 namespace dot
 {
@@ -32,16 +35,50 @@ namespace dot
     typedef uint8 byte;
     typedef int8 sbyte;
 
+    class class_id;
+    class hierarchic;
+
+    // сведения о классе для реестра классов, DOT_CLASS_ID собирает их по самому классу
+    class class_info
+    {
+    public:
+        // создание экземпляра по умолчанию в буфере размера size с выравниванием alignment
+        typedef hierarchic* (*factory)(void* buffer);
+
+        std::size_t size = 0;
+        std::size_t alignment = 0;
+
+        // полиморфные классы по правилам языка не копируются побайтно,
+        // поэтому данные с тривиальным значением заявляют это сами
+        // статическими признаками trivially_copyable и trivially_relocatable
+        bool trivially_copyable = false;
+        bool trivially_relocatable = false;
+        bool abstract = false;
+
+        // идентификатор непосредственного предка, пусто у корня иерархии
+        const class_id& (*base)() noexcept = nullptr;
+
+        // пусто у абстрактных классов и классов без конструктора по умолчанию
+        factory create = nullptr;
+
+        template <class class_type>
+        static class_info of() noexcept;
+    };
+
     // класс для идентификации иерархического типа
     class DOT_PUBLIC class_id
     {
     public:
         explicit class_id(const char* const name) noexcept;
+        class_id(const char* const name, const class_info& info) noexcept;
 
         // имя и уникальный индекс класса
         const char* const name() const noexcept;
         const uint64 index() const noexcept;
 
+        // сведения о классе, у идентификатора по одному имени они пусты
+        const class_info& info() const noexcept;
+
         // сравнение двух идентификаторов
         bool operator == (const class_id& another) const noexcept;
         bool operator != (const class_id& another) const noexcept;
@@ -49,13 +86,46 @@ namespace dot
     private:
         const char* const my_name;
         const uint64 my_index;
+        const class_info my_info;
     };
 
     // запись идентификатора в поток вывода
     DOT_PUBLIC std::ostream& operator << (std::ostream& output, const class_id& identifier);
 
+#if defined(DOT_INLINE_HOT) || defined(DOT_TYPE_SOURCE)
+
+    // -- короткие частые методы --
+
+    DOT_HOT const char* const class_id::name() const noexcept
+    {
+        return my_name;
+    }
+
+    DOT_HOT const uint64 class_id::index() const noexcept
+    {
+        return my_index;
+    }
+
+    DOT_HOT const class_info& class_id::info() const noexcept
+    {
+        return my_info;
+    }
+
+    DOT_HOT bool class_id::operator == (const class_id& another) const noexcept
+    {
+        return my_index == another.my_index;
+    }
+
+    DOT_HOT bool class_id::operator != (const class_id& another) const noexcept
+    {
+        return my_index != another.my_index;
+    }
+
+#endif
+
     // invalid_typecast() генерирует исключение приведения типов
-    DOT_PUBLIC void invalid_typecast(const char* to_class, const char* from_class);
+    // по существующим идентификаторам без выделения памяти
+    [[noreturn]] DOT_PUBLIC void invalid_typecast(const class_id& to_class, const class_id& from_class);
 
     // базовый класс для иерархии объектов и данных
     class DOT_PUBLIC hierarchic
@@ -92,7 +162,7 @@ namespace dot
         const derived_type& as() const
         {
             if (!is<derived_type>())
-                invalid_typecast(derived_type::id().name(), my_id().name());
+                invalid_typecast(derived_type::id(), my_id());
             return static_cast<const derived_type&>(*this);
         }
 
@@ -102,6 +172,23 @@ namespace dot
             return const_cast<derived_type&>(
                 static_cast<const hierarchic*>(this)->as<derived_type>());
         }
+
+        // приведение к типу без исключения, неудача возвращается в результате
+        template <typename derived_type>
+        result<const derived_type&> try_as() const noexcept
+        {
+            if (!is<derived_type>())
+                return result_error(result_code::bad_typecast, &derived_type::id(), &my_id());
+            return static_cast<const derived_type&>(*this);
+        }
+
+        template <typename derived_type>
+        result<derived_type&> try_as() noexcept
+        {
+            if (!is<derived_type>())
+                return result_error(result_code::bad_typecast, &derived_type::id(), &my_id());
+            return static_cast<derived_type&>(*this);
+        }
     };
 
     // -- проверка наследования не зависящая от RTTI --
@@ -146,14 +233,90 @@ namespace dot
     } \
     static const class_id& id() noexcept
 
-// генерация тела метода идентификатора класса в иерархии
+    // -- сведения о классе по самому классу --
+
+    // статические признаки класса действуют только для класса, объявившего их
+    // вместе с typedef на себя hint_owner: наследник получает признаки предка
+    // по правилам языка, но без своего hint_owner они для него не в счёт
+    template <class class_type, typename meta_type = void>
+    struct owns_hints : std::false_type { };
+
+    template <class class_type>
+    struct owns_hints<class_type, std::enable_if_t<
+        std::is_same_v<typename class_type::hint_owner, class_type>>> : std::true_type { };
+
+    template <class class_type, typename meta_type = void>
+    struct trivially_copyable_class : std::is_trivially_copyable<class_type> { };
+
+    template <class class_type>
+    struct trivially_copyable_class<class_type, std::enable_if_t<owns_hints<class_type>::value &&
+        std::is_same_v<decltype(class_type::trivially_copyable), const bool>>>
+        : std::bool_constant<class_type::trivially_copyable> { };
+
+    template <class class_type, typename meta_type = void>
+    struct trivially_relocatable_class : trivially_copyable_class<class_type> { };
+
+    template <class class_type>
+    struct trivially_relocatable_class<class_type, std::enable_if_t<owns_hints<class_type>::value &&
+        std::is_same_v<decltype(class_type::trivially_relocatable), const bool>>>
+        : std::bool_constant<class_type::trivially_relocatable> { };
+
+    // шаблонный конструктор с любыми аргументами объявляет конструктор по умолчанию
+    // и для значения без него, такие классы уточняют признак default_constructible
+    template <class class_type, typename meta_type = void>
+    struct default_constructible_class : std::bool_constant<
+        !std::is_abstract_v<class_type> && std::is_default_constructible_v<class_type>> { };
+
+    template <class class_type>
+    struct default_constructible_class<class_type, std::enable_if_t<owns_hints<class_type>::value &&
+        std::is_same_v<decltype(class_type::default_constructible), const bool>>>
+        : std::bool_constant<class_type::default_constructible> { };
+
+    template <class class_type>
+    class_info class_info::of() noexcept
+    {
+        class_info result;
+        result.size = sizeof(class_type);
+        result.alignment = alignof(class_type);
+        result.trivially_copyable = trivially_copyable_class<class_type>::value;
+        result.trivially_relocatable = trivially_relocatable_class<class_type>::value;
+        result.abstract = std::is_abstract_v<class_type>;
+        if constexpr (!std::is_same_v<typename class_type::base, hierarchic>)
+            result.base = &class_type::base::id;
+        // признак только запрещает фабрику, но не добавляет её классу без конструктора по умолчанию
+        if constexpr (default_constructible_class<class_type>::value && std::is_default_constructible_v<class_type>)
+        {
+            result.create = [](void* buffer) -> hierarchic*
+            {
+                return new(buffer) class_type();
+            };
+        }
+        return result;
+    }
+
+// склейка имён в макросах после подстановки аргументов
+#define DOT_JOIN(left, right) DOT_JOIN_NOW(left, right)
+#define DOT_JOIN_NOW(left, right) left##right
+
+// генерация тела метода идентификатора класса в иерархии,
+// класс попадает в реестр классов при первом вызове id()
 #define DOT_CLASS_ID(class_name) \
     const class_id& class_name::id() noexcept \
     { \
-        static const class_id identifier(#class_name); \
+        static const class_id identifier(#class_name, class_info::of<class_name>()); \
         return identifier; \
     }
 
+// регистрация класса при загрузке модуля, чтобы реестр находил его по имени
+// до первого вызова id(); только в области пространства имён, так как макрос
+// объявляет переменную безымянного пространства имён; порядок регистрации
+// между файлами не задан, но реестр и идентификатор создаются при первом обращении
+#define DOT_REGISTER_CLASS(class_name) \
+    namespace \
+    { \
+        const bool DOT_JOIN(class_registered_, __COUNTER__) = (class_name::id(), true); \
+    }
+
     // шаблон для проверки можно ли тип записывать в поток вывода
     template <typename test_type, typename meta_type = void>
     struct writable_type : std::false_type { };
@@ -187,7 +350,7 @@ namespace dot
     struct comparable_types : std::false_type { };
 
     template <typename left_type, typename right_type>
-    struct comparable_types<typename left_type, typename right_type,
+    struct comparable_types<left_type, right_type,
         std::enable_if_t<std::is_convertible_v<
             decltype(std::declval<left_type>() == std::declval<right_type>()),
             bool
@@ -0,0 +1,184 @@
+// Обход данных объекта по их типу одним переходом по таблице
+// вместо цепочки проверок is<...>() с виртуальным обходом иерархии
+
+#pragma once
+
+#include <dot/object.h>
+#include <dot/box.h>
+#include <dot/rope.h>
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+namespace dot
+{
+    // набор лямбд с общим оператором вызова:
+    // visit(x, overloaded{ [](int v) {...}, [](const std::string& s) {...}, [](const object&) {...} })
+    template <class... visitors>
+    struct overloaded : visitors...
+    {
+        using visitors::operator()...;
+    };
+
+    template <class... visitors>
+    overloaded(visitors...) -> overloaded<visitors...>;
+
+    // таблица переходов от индекса класса данных к номеру варианта, 0 для запасного;
+    // индексы классов выдаются подряд при первом обращении к id(), поэтому таблица
+    // строится при первом обходе и покрывает отрезок от меньшего индекса до большего
+    class visit_table
+    {
+    public:
+        explicit visit_table(std::initializer_list<uint64> indices)
+        {
+            if (!indices.size())
+                return;
+            my_first = std::min(indices);
+            my_size = std::max(indices) - my_first + 1;
+            my_slots.reset(new uint8[my_size]());
+            uint8 slot = 0;
+            for (uint64 index : indices)
+            {
+                // при повторе типа побеждает первый вариант, как в цепочке проверок
+                uint8& target = my_slots[index - my_first];
+                ++slot;
+                if (!target)
+                    target = slot;
+            }
+        }
+
+        // индекс меньше первого переполняется в большое смещение и уходит в запасной вариант
+        std::size_t slot(uint64 index) const noexcept
+        {
+            const uint64 offset = index - my_first;
+            return offset < my_size ? my_slots[offset] : 0;
+        }
+
+    private:
+        uint64 my_first = 0;
+        uint64 my_size = 0;
+        std::unique_ptr<uint8[]> my_slots;
+    };
+
+    // список типов вариантов обхода
+    template <class... types>
+    struct visit_types
+    {
+    };
+
+    // тип параметра обычной лямбды, у шаблонной лямбды он не выводится
+    template <class visitor_type, class result_type, class parameter_type>
+    parameter_type visit_parameter(result_type (visitor_type::*)(parameter_type) const);
+
+    template <class visitor_type, class result_type, class parameter_type>
+    parameter_type visit_parameter(result_type (visitor_type::*)(parameter_type));
+
+    template <class visitor_type, class result_type, class parameter_type>
+    parameter_type visit_parameter(result_type (visitor_type::*)(parameter_type) const noexcept);
+
+    template <class visitor_type, class result_type, class parameter_type>
+    parameter_type visit_parameter(result_type (visitor_type::*)(parameter_type) noexcept);
+
+    // отбор вариантов из параметров лямбд: запасной вариант с объектом не в счёт
+    template <class found, class... rest>
+    struct visit_alternatives
+    {
+        typedef found type;
+    };
+
+    template <class... found, class next, class... rest>
+    struct visit_alternatives<visit_types<found...>, next, rest...>
+        : visit_alternatives<std::conditional_t<basic_object_class<next>::value,
+            visit_types<found...>, visit_types<found..., next>>, rest...>
+    {
+    };
+
+    template <class visitor_type>
+    struct visit_deduced : visit_alternatives<visit_types<>,
+        std::decay_t<decltype(visit_parameter(&visitor_type::operator()))>>
+    {
+    };
+
+    template <class... visitors>
+    struct visit_deduced<overloaded<visitors...>> : visit_alternatives<visit_types<>,
+        std::decay_t<decltype(visit_parameter(&visitors::operator()))>...>
+    {
+    };
+
+    // таблица общая для всех обходов объектов той же ёмкости с тем же списком вариантов
+    template <std::size_t capacity, class... alternatives>
+    const visit_table& visit_slots()
+    {
+        static const visit_table table({ object_data_class<alternatives, capacity>::type::id().index()... });
+        return table;
+    }
+
+    // вызов варианта: номер в таблице уже гарантирует тип данных
+    template <class result_type, class visitor_type, std::size_t capacity, class alternative>
+    result_type visit_alternative(const basic_object<capacity>& source, visitor_type& visitor)
+    {
+        return visitor(static_cast<const typename object_data_class<alternative, capacity>::type&>(source.get_data()).look());
+    }
+
+    // запасной вариант получает сам объект: пустой либо с данными не из списка;
+    // данные из объекта другой ёмкости могут хранить значение варианта в другом виде
+    template <class result_type, class visitor_type, std::size_t capacity>
+    result_type visit_fallback(const basic_object<capacity>& source, visitor_type& visitor, visit_types<>)
+    {
+        return visitor(source);
+    }
+
+    template <class result_type, class visitor_type, std::size_t capacity, class alternative, class... rest>
+    result_type visit_fallback(const basic_object<capacity>& source, visitor_type& visitor, visit_types<alternative, rest...>)
+    {
+        if (const alternative* value = source.is_null() ? nullptr : source.get_data().template value_as<alternative>())
+            return visitor(*value);
+        return visit_fallback<result_type>(source, visitor, visit_types<rest...>());
+    }
+
+    template <class result_type, class visitor_type, std::size_t capacity, class... alternatives>
+    result_type visit_other(const basic_object<capacity>& source, visitor_type& visitor)
+    {
+        return visit_fallback<result_type>(source, visitor, visit_types<alternatives...>());
+    }
+
+    template <class visitor_type, std::size_t capacity, class... alternatives>
+    decltype(auto) visit_by_table(const basic_object<capacity>& source, visitor_type& visitor, visit_types<alternatives...>)
+    {
+        typedef basic_object<capacity> object_type;
+        static_assert(sizeof...(alternatives) < 256, "Too many alternatives for dot::visit() jump table.");
+        static_assert(std::is_invocable_v<visitor_type&, const object_type&>,
+            "Visitor of dot::visit() needs a fallback overload taking the visited object.");
+
+        typedef std::common_type_t<std::invoke_result_t<visitor_type&, const object_type&>,
+            std::invoke_result_t<visitor_type&, const alternatives&>...> result_type;
+        typedef result_type (*handler)(const object_type&, visitor_type&);
+        static constexpr handler handlers[] =
+        {
+            &visit_other<result_type, visitor_type, capacity, alternatives...>,
+            &visit_alternative<result_type, visitor_type, capacity, alternatives>...
+        };
+
+        const std::size_t slot = source.is_null() ? 0
+            : visit_slots<capacity, alternatives...>().slot(source.get_data().my_id().index());
+        return handlers[slot](source, visitor);
+    }
+
+    // обход данных объекта: вызывается вариант для точного типа значения в объекте,
+    // иначе запасной вариант с самим объектом; варианты перечисляются явно,
+    // visit<int, double, std::string>(x, visitor), либо выводятся из параметров лямбд
+    // в overloaded; наследники данных вариантов попадают в запасной вариант;
+    // значения в данных, которые выбрал бы set_as() объекта, находятся одним переходом,
+    // значения из объекта другой ёмкости в другом виде ищутся перед запасным вариантом
+    template <class... alternatives, std::size_t capacity, class visitor_type>
+    decltype(auto) visit(const basic_object<capacity>& source, visitor_type&& visitor)
+    {
+        if constexpr (sizeof...(alternatives) != 0)
+            return visit_by_table(source, visitor, visit_types<alternatives...>());
+        else
+            return visit_by_table(source, visitor, typename visit_deduced<std::decay_t<visitor_type>>::type());
+    }
+}
+
+// Здесь должен быть Unicode
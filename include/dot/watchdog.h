@@ -0,0 +1,39 @@
+// Сторож зависаний: поиск скоупов трассировки, открытых дольше порога
+
+#pragma once
+
+#include <dot/trace.h>
+#include <chrono>
+#include <atomic>
+
+namespace dot
+{
+    // trace::watchdog в фоновом потоке периодически читает стеки трассировки
+    // всех потоков, не останавливая их, и замечает скоупы, открытые дольше порога;
+    // для каждого такого скоупа один раз вызывается обработчик с бэктрейсом потока;
+    // время скоупа отсчитывается от первого чтения его сторожем,
+    // поэтому может быть занижено не больше чем на период опроса, четверть порога
+    class DOT_PUBLIC trace::watchdog
+    {
+    public:
+        watchdog() = delete;
+
+        // обработчик зависания вызывается в потоке сторожа,
+        // thread - номер потока в порядке создания его стека трассировки
+        typedef void (*stall_handler)(std::size_t thread, const stack& backtrace, std::uint64_t elapsed);
+
+        // запуск сторожа с порогом, прежний сторож останавливается;
+        // без обработчика бэктрейс зависшего потока выводится в std::cerr
+        static void start(std::chrono::milliseconds threshold, stall_handler handler = nullptr);
+        static void stop();
+
+        static bool watching() noexcept;
+
+    private:
+        class session;
+
+        static std::atomic<bool> my_watching;
+    };
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,288 @@
+// Учёт выделений памяти по скоупам трассировки
+// через подменённые глобальные operator new и operator delete
+
+#include <dot/allocations.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+
+namespace dot
+{
+    std::atomic<bool> trace::allocations::my_tracking(false);
+
+    namespace
+    {
+        // место выделений не удаляется до конца программы,
+        // ведь на него ссылаются заголовки ещё не освобождённых блоков
+        struct site
+        {
+            const char* name;
+            const char* file;
+            int line;
+            std::atomic<uint64> count;
+            std::atomic<uint64> bytes;
+            std::atomic<long long> live;
+        };
+
+        // заголовок перед блоком памяти сохраняет выравнивание блока
+        struct alignas(alignof(std::max_align_t)) header
+        {
+            site* owner;
+            std::size_t size;
+        };
+
+        // мест не больше site_capacity, поиск без блокировок, добавление под мьютексом;
+        // при заполнении таблицы на три четверти новые места сводятся в одно
+        constexpr std::size_t site_capacity = 4096;
+        std::atomic<site*> sites[site_capacity];
+        std::size_t site_count = 0;
+        std::mutex sites_mutex;
+        site overflow_site{ "[прочие скоупы]", "", 0, {}, {}, {} };
+
+        // время учёта для числа выделений в секунду
+        std::atomic<uint64> tracked_time(0);
+        std::atomic<uint64> tracking_since(0);
+        std::atomic<bool> hook_called(false);
+
+        // выделения потока для замеров, без атомарных операций
+        DOT_FAST_THREAD_LOCAL std::uint64_t thread_allocations = 0;
+
+        inline std::size_t site_hash(const char* name, const char* file, int line) noexcept
+        {
+            const uint64 mixed = (reinterpret_cast<std::uintptr_t>(name) * 31
+                + reinterpret_cast<std::uintptr_t>(file)) * 31 + static_cast<uint64>(line);
+            return static_cast<std::size_t>((mixed * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        inline bool same_site(const site* target, const char* name, const char* file, int line) noexcept
+        {
+            return target->name == name && target->file == file && target->line == line;
+        }
+
+        // место создаётся через malloc, чтобы не вызывать учёт изнутри учёта
+        site* insert_site(std::size_t slot, const char* name, const char* file, int line) noexcept
+        {
+            std::lock_guard<std::mutex> lock(sites_mutex);
+            for (;; slot = (slot + 1) & (site_capacity - 1))
+            {
+                site* target = sites[slot].load(std::memory_order_acquire);
+                if (!target)
+                    break;
+                if (same_site(target, name, file, line))
+                    return target;
+            }
+            if (site_count >= site_capacity / 4 * 3)
+                return &overflow_site;
+            void* memory = std::malloc(sizeof(site));
+            if (!memory)
+                return &overflow_site;
+            site* target = new (memory) site{ name, file, line, {}, {}, {} };
+            sites[slot].store(target, std::memory_order_release);
+            ++site_count;
+            return target;
+        }
+
+        site* find_site(const char* name, const char* file, int line) noexcept
+        {
+            std::size_t slot = site_hash(name, file, line) & (site_capacity - 1);
+            for (;; slot = (slot + 1) & (site_capacity - 1))
+            {
+                site* target = sites[slot].load(std::memory_order_acquire);
+                if (!target)
+                    return insert_site(slot, name, file, line);
+                if (same_site(target, name, file, line))
+                    return target;
+            }
+        }
+
+        struct site_state
+        {
+            const site* target;
+            uint64 count;
+            uint64 bytes;
+            long long live;
+        };
+
+        // места с выделениями по убыванию байтов, список собирается до вывода,
+        // ведь вывод сам выделяет память и может добавлять места
+        std::vector<site_state> sorted_sites()
+        {
+            std::vector<const site*> targets;
+            for (const std::atomic<site*>& slot : sites)
+                if (const site* target = slot.load(std::memory_order_acquire))
+                    targets.push_back(target);
+            targets.push_back(&overflow_site);
+            std::vector<site_state> result;
+            for (const site* target : targets)
+            {
+                const site_state state{ target,
+                    target->count.load(std::memory_order_relaxed),
+                    target->bytes.load(std::memory_order_relaxed),
+                    target->live.load(std::memory_order_relaxed) };
+                if (state.count || state.live)
+                    result.push_back(state);
+            }
+            std::sort(result.begin(), result.end(),
+                [](const site_state& left, const site_state& right) { return left.bytes > right.bytes; });
+            return result;
+        }
+
+        // секунды учёта с последнего обнуления, включая идущий учёт
+        double tracked_seconds() noexcept
+        {
+            uint64 elapsed = tracked_time.load(std::memory_order_relaxed);
+            if (trace::allocations::tracking())
+                elapsed += trace::now() - tracking_since.load(std::memory_order_relaxed);
+            return elapsed / 1e9;
+        }
+    }
+
+    void trace::allocations::start() noexcept
+    {
+        if (!my_tracking.load(std::memory_order_relaxed))
+        {
+            tracking_since.store(trace::now(), std::memory_order_relaxed);
+            my_tracking.store(true, std::memory_order_release);
+        }
+    }
+
+    void trace::allocations::stop() noexcept
+    {
+        if (my_tracking.exchange(false, std::memory_order_acq_rel))
+            tracked_time.fetch_add(trace::now() - tracking_since.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    bool trace::allocations::tracking() noexcept
+    {
+        return my_tracking.load(std::memory_order_acquire);
+    }
+
+    bool trace::allocations::hooked() noexcept
+    {
+        return hook_called.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t trace::allocations::thread_count() noexcept
+    {
+        return thread_allocations;
+    }
+
+    void trace::allocations::reset() noexcept
+    {
+        for (std::atomic<site*>& slot : sites)
+        {
+            if (site* target = slot.load(std::memory_order_acquire))
+            {
+                target->count.store(0, std::memory_order_relaxed);
+                target->bytes.store(0, std::memory_order_relaxed);
+            }
+        }
+        overflow_site.count.store(0, std::memory_order_relaxed);
+        overflow_site.bytes.store(0, std::memory_order_relaxed);
+        tracked_time.store(0, std::memory_order_relaxed);
+        tracking_since.store(trace::now(), std::memory_order_relaxed);
+    }
+
+    void trace::allocations::dump()
+    {
+        dump(std::cout);
+    }
+
+    void trace::allocations::dump(std::ostream& stream)
+    {
+        const std::vector<site_state> states = sorted_sites();
+        const double seconds = tracked_seconds();
+        const std::ios::fmtflags flags = stream.flags();
+        const std::streamsize precision = stream.precision();
+        stream << " -- Выделения памяти по скоупам\n"
+               << "  выделения        байты        в секунду   живые байты   скоуп\n"
+               << std::fixed << std::setprecision(1);
+        for (const site_state& state : states)
+        {
+            stream << std::setw(12) << state.count
+                << std::setw(14) << state.bytes
+                << std::setw(16) << (seconds > 0 ? state.count / seconds : 0.0)
+                << std::setw(14) << state.live << "   "
+                << state.target->name << " в "
+                << state.target->file << '('
+                << state.target->line << ")\n";
+        }
+        stream.flags(flags);
+        stream.precision(precision);
+    }
+
+    array trace::allocations::report()
+    {
+        const std::vector<site_state> states = sorted_sites();
+        const double seconds = tracked_seconds();
+        array result;
+        for (const site_state& state : states)
+        {
+            record row;
+            row["name"] = object(state.target->name);
+            row["file"] = object(state.target->file);
+            row["line"] = object(state.target->line);
+            row["count"] = object(static_cast<long long>(state.count));
+            row["bytes"] = object(static_cast<long long>(state.bytes));
+            row["per_second"] = object(seconds > 0 ? state.count / seconds : 0.0);
+            row["live"] = object(state.live);
+            result.push_back(object(std::move(row)));
+        }
+        return result;
+    }
+
+    void* trace::allocations::allocate(std::size_t size)
+    {
+        for (;;)
+        {
+            if (void* memory = allocate(size, std::nothrow))
+                return memory;
+            // как и стандартный operator new, даём обработчику освободить память
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* trace::allocations::allocate(std::size_t size, const std::nothrow_t&) noexcept
+    {
+        header* block = static_cast<header*>(std::malloc(sizeof(header) + size));
+        if (!block)
+            return nullptr;
+        if (!hook_called.load(std::memory_order_relaxed))
+            hook_called.store(true, std::memory_order_relaxed);
+        ++thread_allocations;
+        site* owner = nullptr;
+        if (my_tracking.load(std::memory_order_relaxed))
+        {
+            const stack::iterator top = stack::signal_top();
+            owner = top != stack::iterator() ? find_site(top.name(), top.file(), top.line()) : find_site(outside, "", 0);
+            owner->count.fetch_add(1, std::memory_order_relaxed);
+            owner->bytes.fetch_add(size, std::memory_order_relaxed);
+            owner->live.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+        }
+        block->owner = owner;
+        block->size = size;
+        return block + 1;
+    }
+
+    void trace::allocations::release(void* memory) noexcept
+    {
+        if (!memory)
+            return;
+        header* block = static_cast<header*>(memory) - 1;
+        if (block->owner)
+            block->owner->live.fetch_sub(static_cast<long long>(block->size), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,328 @@
+// Замеры производительности рядом с наборами тестов
+// с калибровкой числа итераций и сравнением с базовыми результатами
+
+#include <dot/test.h>
+#include <dot/allocations.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dot
+{
+    namespace
+    {
+        // замеры регистрируются до глобальных объектов библиотеки при статической сборке
+        std::deque<test::benchmark*>& run_benchmarks()
+        {
+            static std::deque<test::benchmark*> benchmarks;
+            return benchmarks;
+        }
+
+        // итераций не больше, чем проходит за разумное время даже пустой цикл
+        constexpr std::uint64_t iterations_max = 1000000000u;
+
+        // базовый результат замера из файла
+        struct baseline_entry
+        {
+            double nanoseconds;
+            double deviation;
+            double fastest;
+            double allocations;
+        };
+
+        // файл базы: строка на замер вида "имя нс/оп разброс лучшее_нс/оп выделения/оп"
+        bool load_baseline(const char* path, std::map<std::string, baseline_entry>& entries)
+        {
+            std::ifstream file(path);
+            if (!file)
+                return false;
+            std::string line;
+            while (std::getline(file, line))
+            {
+                if (line.empty() || line[0] == '#')
+                    continue;
+                std::istringstream fields(line);
+                std::string name;
+                baseline_entry entry;
+                if (fields >> name >> entry.nanoseconds >> entry.deviation >> entry.fastest >> entry.allocations)
+                    entries[name] = entry;
+            }
+            return true;
+        }
+
+        // счётчики на операцию, недоступные выводятся прочерком
+        void print_counters(const test::benchmark::measurement& result)
+        {
+            if (result.cycles < 0 && result.instructions < 0)
+                return;
+            auto print = [](double value)
+            {
+                if (value < 0)
+                    std::cout << "-";
+                else
+                    std::cout << value;
+            };
+            std::cout << std::setprecision(2) << "; ";
+            print(result.cycles > 0 && result.instructions >= 0 ? result.instructions / result.cycles : -1);
+            std::cout << ", ";
+            print(result.cycles);
+            std::cout << std::setprecision(4) << ", ";
+            print(result.cache_misses);
+            std::cout << ", ";
+            print(result.branch_misses);
+        }
+
+        bool save_baseline(const char* path, const std::vector<test::benchmark::measurement>& measurements)
+        {
+            std::ofstream file(path);
+            if (!file)
+                return false;
+            file << "# dot benchmark baseline: name ns/op stddev fastest_ns/op allocations/op\n"
+                 << std::setprecision(6);
+            for (const test::benchmark::measurement& current : measurements)
+                file << current.name << ' ' << current.nanoseconds << ' '
+                     << current.deviation << ' ' << current.fastest << ' ' << current.allocations << '\n';
+            return static_cast<bool>(file);
+        }
+    }
+
+    test::benchmark::benchmark() noexcept
+    {
+        run_benchmarks().push_back(this);
+    }
+
+    void test::benchmark::escape(const volatile void*) noexcept
+    {
+    }
+
+    void test::benchmark::describe(const measurement&, std::ostream&) const
+    {
+    }
+
+    test::benchmark::measurement test::benchmark::measure(std::chrono::nanoseconds slice, std::size_t samples, bool counters)
+    {
+        const std::uint64_t target = static_cast<std::uint64_t>(std::max<long long>(slice.count(), 1000));
+        samples = std::max<std::size_t>(samples, 2);
+
+        // калибровка: итерации растут в 10 раз, пока проход короче десятой доли повтора,
+        // затем подбираются пропорционально времени последнего прохода
+        std::uint64_t iterations = 1;
+        for (;;)
+        {
+            loop probe(iterations);
+            run(probe);
+            const std::uint64_t elapsed = probe.elapsed();
+            if (elapsed * 10 >= target || iterations >= iterations_max)
+            {
+                if (elapsed)
+                    iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * target / elapsed);
+                iterations = std::min(std::max<std::uint64_t>(iterations, 1), iterations_max);
+                break;
+            }
+            iterations *= 10;
+        }
+
+        // повторы замера дают среднее и стандартное отклонение времени операции
+        std::vector<double> times;
+        std::uint64_t total_iterations = 0;
+        std::uint64_t total_allocations = 0;
+        std::unique_ptr<trace::counters> group(counters ? new trace::counters() : nullptr);
+        if (group && !group->available())
+            group.reset();
+        trace::counters::values total_counters;
+        for (std::size_t sample = 0; sample < samples; ++sample)
+        {
+            loop iteration(iterations, group.get());
+            run(iteration);
+            times.push_back(static_cast<double>(iteration.elapsed()) / iteration.iterations());
+            total_iterations += iteration.iterations();
+            total_allocations += iteration.allocations();
+            if (!sample)
+                total_counters = iteration.counters();
+            else
+                total_counters += iteration.counters();
+        }
+        double mean = 0;
+        for (double time : times)
+            mean += time;
+        mean /= times.size();
+        double variance = 0;
+        for (double time : times)
+            variance += (time - mean) * (time - mean);
+        variance /= times.size() - 1;
+
+        measurement result;
+        result.name = name();
+        result.iterations = iterations;
+        result.nanoseconds = mean;
+        result.deviation = std::sqrt(variance);
+        result.fastest = *std::min_element(times.begin(), times.end());
+        result.per_second = mean > 0 ? 1e9 / mean : 0;
+        if (trace::allocations::hooked())
+            result.allocations = static_cast<double>(total_allocations) / total_iterations;
+        auto per_operation = [&](std::int64_t total)
+        {
+            return total >= 0 ? static_cast<double>(total) / total_iterations : -1.0;
+        };
+        result.cycles = per_operation(total_counters.cycles);
+        result.instructions = per_operation(total_counters.instructions);
+        result.cache_misses = per_operation(total_counters.cache_misses);
+        result.branch_misses = per_operation(total_counters.branch_misses);
+        return result;
+    }
+
+    std::vector<const char*> test::benchmark::names()
+    {
+        std::vector<const char*> result;
+        for (const benchmark* current : run_benchmarks())
+            result.push_back(current->name());
+        return result;
+    }
+
+    std::size_t test::benchmark::run_all(const settings& options, std::vector<measurement>* results)
+    {
+        std::map<std::string, baseline_entry> baseline;
+        if (options.baseline && !load_baseline(options.baseline, baseline))
+            std::cout << " -- Базовые результаты не найдены: " << options.baseline << std::endl;
+
+        const std::size_t samples = std::max<std::size_t>(options.bench_samples, 2);
+        const std::chrono::nanoseconds slice = std::chrono::duration_cast<std::chrono::nanoseconds>(options.bench_time) / samples;
+        std::vector<measurement> measurements;
+        std::size_t regressions = 0;
+        const std::ios::fmtflags flags = std::cout.flags();
+        const std::streamsize precision = std::cout.precision();
+        const bool counters = options.counters && trace::counters::supported();
+        std::cout << "\n -- Замеры производительности (нс/оп ± отклонение, лучший повтор, оп/с, выделений/оп"
+            << (counters ? "; IPC, тактов/оп, промахов кэша/оп, ошибок переходов/оп" : "") << "):\n" << std::endl;
+        if (options.counters && !counters)
+            std::cout << " -- Аппаратные счётчики недоступны, замеры идут без них\n" << std::endl;
+        for (benchmark* current : run_benchmarks())
+        {
+            if (!options.selects(current->name()))
+                continue;
+            std::cout << " -> Замер \"" << current->name() << "\" ... " << std::flush;
+            measurement result;
+            try
+            {
+                result = current->measure(slice, samples, counters);
+            }
+            catch (std::exception& unhandled)
+            {
+                ++regressions;
+                std::cout << "СБОЙ ЗАМЕРА: " << unhandled.what() << std::endl;
+                continue;
+            }
+            catch (...)
+            {
+                ++regressions;
+                std::cout << "СБОЙ ЗАМЕРА" << std::endl;
+                continue;
+            }
+            measurements.push_back(result);
+            std::cout << std::fixed << std::setprecision(3) << result.nanoseconds
+                << " ± " << result.deviation << ", " << result.fastest
+                << ", " << std::setprecision(0) << result.per_second;
+            if (result.allocations >= 0)
+                std::cout << ", " << std::setprecision(2) << result.allocations;
+            print_counters(result);
+            current->describe(result, std::cout);
+
+            // регрессия: замедление лучшего повтора сверх порога либо новые выделения памяти
+            const auto base = baseline.find(result.name);
+            if (base != baseline.end())
+            {
+                const baseline_entry& entry = base->second;
+                const double change = entry.fastest > 0 ? (result.fastest / entry.fastest - 1) * 100 : 0;
+                const bool slower = change > options.threshold;
+                const bool allocates = result.allocations >= 0 && entry.allocations >= 0
+                    && result.allocations > entry.allocations + 0.01;
+                std::cout << " [база " << std::setprecision(3) << entry.fastest
+                    << ", " << std::showpos << std::setprecision(1) << change << "%" << std::noshowpos << "]";
+                if (slower || allocates)
+                {
+                    ++regressions;
+                    std::cout << " РЕГРЕССИЯ";
+                    if (allocates)
+                        std::cout << " выделений: " << std::setprecision(2) << entry.allocations
+                            << " -> " << result.allocations;
+                }
+            }
+            std::cout << std::endl;
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+        if (results)
+            results->insert(results->end(), measurements.begin(), measurements.end());
+
+        if (options.save_baseline)
+        {
+            if (save_baseline(options.save_baseline, measurements))
+                std::cout << " -- Замеры сохранены в " << options.save_baseline << std::endl;
+            else
+                std::cout << " -- Не удалось сохранить замеры в " << options.save_baseline << std::endl;
+        }
+        return regressions;
+    }
+
+    test::benchmark::loop::loop(std::uint64_t iterations, trace::counters* group) noexcept
+        : my_iterations(iterations),
+          my_group(group)
+    {
+    }
+
+    std::uint64_t test::benchmark::loop::iterations() const noexcept
+    {
+        return my_iterations;
+    }
+
+    std::uint64_t test::benchmark::loop::elapsed() const noexcept
+    {
+        return my_elapsed;
+    }
+
+    std::uint64_t test::benchmark::loop::allocations() const noexcept
+    {
+        return my_allocations;
+    }
+
+    const trace::counters::values& test::benchmark::loop::counters() const noexcept
+    {
+        return my_counters;
+    }
+
+    // первый вызов запускает часы, последний их останавливает
+    bool test::benchmark::loop::turn() noexcept
+    {
+        if (my_stage == 0)
+        {
+            my_stage = my_iterations ? 1 : 2;
+            if (!my_iterations)
+                return false;
+            my_left = my_iterations - 1;
+            my_allocations = trace::allocations::thread_count();
+            if (my_group)
+                my_group->start();
+            my_start = trace::now();
+            return true;
+        }
+        if (my_stage == 1)
+        {
+            my_elapsed = trace::now() - my_start;
+            if (my_group)
+                my_counters = my_group->stop();
+            my_allocations = trace::allocations::thread_count() - my_allocations;
+            my_stage = 2;
+        }
+        return false;
+    }
+}
+
+// Здесь должен быть Unicode
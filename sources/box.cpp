@@ -40,6 +40,145 @@ namespace dot
     template<> DOT_CLASS_ID(box<double>::cat)
     template<> DOT_CLASS_ID(box<float>::cat)
     template<> DOT_CLASS_ID(box<bool>::cat)
+
+    // встроенные типы находятся в реестре по имени с загрузки библиотеки
+    DOT_REGISTER_CLASS(box_based)
+    DOT_REGISTER_CLASS(box_based::cat_based)
+
+    DOT_REGISTER_CLASS(box<long long>)
+    DOT_REGISTER_CLASS(box<long>)
+    DOT_REGISTER_CLASS(box<int>)
+    DOT_REGISTER_CLASS(box<short>)
+    DOT_REGISTER_CLASS(box<char>)
+
+    DOT_REGISTER_CLASS(box<unsigned long long>)
+    DOT_REGISTER_CLASS(box<unsigned long>)
+    DOT_REGISTER_CLASS(box<unsigned int>)
+    DOT_REGISTER_CLASS(box<unsigned short>)
+    DOT_REGISTER_CLASS(box<unsigned char>)
+
+    DOT_REGISTER_CLASS(box<double>)
+    DOT_REGISTER_CLASS(box<float>)
+    DOT_REGISTER_CLASS(box<bool>)
+
+    DOT_REGISTER_CLASS(box<long long>::cat)
+    DOT_REGISTER_CLASS(box<long>::cat)
+    DOT_REGISTER_CLASS(box<int>::cat)
+    DOT_REGISTER_CLASS(box<short>::cat)
+    DOT_REGISTER_CLASS(box<char>::cat)
+
+    DOT_REGISTER_CLASS(box<unsigned long long>::cat)
+    DOT_REGISTER_CLASS(box<unsigned long>::cat)
+    DOT_REGISTER_CLASS(box<unsigned int>::cat)
+    DOT_REGISTER_CLASS(box<unsigned short>::cat)
+    DOT_REGISTER_CLASS(box<unsigned char>::cat)
+
+    DOT_REGISTER_CLASS(box<double>::cat)
+    DOT_REGISTER_CLASS(box<float>::cat)
+    DOT_REGISTER_CLASS(box<bool>::cat)
+
+    namespace
+    {
+        // число встроенного типа: целые расширяются до int64 либо uint64 без потерь
+        struct number
+        {
+            enum kind_type { none, signed_integer, unsigned_integer, floating };
+
+            kind_type kind = none;
+            int64 integer = 0;
+            uint64 natural = 0;
+            double real = 0.0;
+        };
+
+        template <class value_type>
+        bool take(const object::data& data, number& result) noexcept
+        {
+            const value_type* value = data.value_as<value_type>();
+            if (!value)
+                return false;
+            if constexpr (std::is_floating_point_v<value_type>)
+            {
+                result.kind = number::floating;
+                result.real = *value;
+            }
+            else if constexpr (std::is_signed_v<value_type>)
+            {
+                result.kind = number::signed_integer;
+                result.integer = *value;
+            }
+            else
+            {
+                result.kind = number::unsigned_integer;
+                result.natural = *value;
+            }
+            return true;
+        }
+
+        number number_of(const object::data& data) noexcept
+        {
+            number result;
+            take<int>(data, result) || take<double>(data, result) || take<long long>(data, result) ||
+                take<long>(data, result) || take<unsigned int>(data, result) || take<unsigned long long>(data, result) ||
+                take<unsigned long>(data, result) || take<float>(data, result) || take<short>(data, result) ||
+                take<unsigned short>(data, result) || take<char>(data, result) || take<unsigned char>(data, result);
+            return result;
+        }
+
+        template <class value_type>
+        int compare(value_type left, value_type right) noexcept
+        {
+            return left < right ? -1 : right < left ? 1 : left == right ? 0 : 2;
+        }
+
+        // порядок целого без знака и числа другого вида
+        int compare_natural(uint64 natural, const number& another) noexcept
+        {
+            switch (another.kind)
+            {
+            case number::signed_integer:
+                return another.integer < 0 ? 1 : compare(natural, static_cast<uint64>(another.integer));
+            case number::unsigned_integer:
+                return compare(natural, another.natural);
+            default:
+                return box_based::cat_based::compare_exact(natural, another.real);
+            }
+        }
+    }
+
+    bool box_based::cat_based::compare_numbers(const object::data& left, const object::data& right, int& order) noexcept
+    {
+        const number first = number_of(left);
+        if (first.kind == number::none)
+            return false;
+        const number second = number_of(right);
+        if (second.kind == number::none)
+            return false;
+        // порядок обратный порядку второго числа с первым, NaN остаётся несравнимым
+        auto reversed = [](int result) { return result == 2 ? 2 : -result; };
+        switch (first.kind)
+        {
+        case number::signed_integer:
+            if (second.kind == number::signed_integer)
+                order = compare(first.integer, second.integer);
+            else if (second.kind == number::unsigned_integer)
+                order = first.integer < 0 ? -1 : compare(static_cast<uint64>(first.integer), second.natural);
+            else
+                order = compare_exact(first.integer, second.real);
+            break;
+        case number::unsigned_integer:
+            order = compare_natural(first.natural, second);
+            break;
+        default:
+            if (second.kind == number::floating)
+                order = compare(first.real, second.real);
+            else if (second.kind == number::signed_integer)
+                order = reversed(compare_exact(second.integer, first.real));
+            else
+                order = reversed(compare_natural(second.natural, first));
+            break;
+        }
+        return true;
+    }
 }
 
 // Здесь должен быть Unicode
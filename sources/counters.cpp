@@ -0,0 +1,165 @@
+// Аппаратные счётчики процессора вокруг участка кода:
+// такты, инструкции, промахи кэша и ошибки предсказания переходов
+
+#include <dot/counters.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace dot
+{
+    namespace
+    {
+#ifdef __linux__
+        // порядок счётчиков группы, первый из них ведущий
+        const std::uint64_t counter_configs[] =
+        {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        int open_counter(std::uint64_t config, int group) noexcept
+        {
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = config;
+            attributes.disabled = group < 0 ? 1 : 0;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+        }
+#endif
+    }
+
+    double trace::counters::values::ipc() const noexcept
+    {
+        return cycles > 0 && instructions >= 0 ? static_cast<double>(instructions) / cycles : -1;
+    }
+
+    trace::counters::values& trace::counters::values::operator += (const values& another) noexcept
+    {
+        // недоступный счётчик в любом из слагаемых делает недоступной и сумму
+        auto add = [](std::int64_t& total, std::int64_t value)
+        {
+            total = total >= 0 && value >= 0 ? total + value : -1;
+        };
+        add(cycles, another.cycles);
+        add(instructions, another.instructions);
+        add(cache_misses, another.cache_misses);
+        add(branch_misses, another.branch_misses);
+        return *this;
+    }
+
+    trace::counters::counters() noexcept
+    {
+        for (int kind = 0; kind < kinds; ++kind)
+        {
+            my_files[kind] = -1;
+            my_ids[kind] = 0;
+        }
+#ifdef __linux__
+        if (!supported())
+            return;
+        my_files[0] = open_counter(counter_configs[0], -1);
+        if (my_files[0] < 0)
+            return;
+        for (int kind = 1; kind < kinds; ++kind)
+            my_files[kind] = open_counter(counter_configs[kind], my_files[0]);
+        // счётчики в прочитанной группе узнаются по идентификаторам
+        for (int kind = 0; kind < kinds; ++kind)
+            if (my_files[kind] >= 0 && ioctl(my_files[kind], PERF_EVENT_IOC_ID, &my_ids[kind]) != 0)
+            {
+                close(my_files[kind]);
+                my_files[kind] = -1;
+            }
+#endif
+    }
+
+    trace::counters::~counters() noexcept
+    {
+#ifdef __linux__
+        for (int file : my_files)
+            if (file >= 0)
+                close(file);
+#endif
+    }
+
+    bool trace::counters::available() const noexcept
+    {
+        return my_files[0] >= 0;
+    }
+
+    void trace::counters::start() noexcept
+    {
+#ifdef __linux__
+        if (!available())
+            return;
+        ioctl(my_files[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(my_files[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    trace::counters::values trace::counters::stop() noexcept
+    {
+        values result;
+#ifdef __linux__
+        if (!available())
+            return result;
+        ioctl(my_files[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // формат чтения группы: число счётчиков, время включения и работы,
+        // затем пары значение и идентификатор счётчика
+        std::uint64_t buffer[3 + 2 * kinds];
+        const ssize_t size = read(my_files[0], buffer, sizeof(buffer));
+        if (size < static_cast<ssize_t>(3 * sizeof(std::uint64_t)))
+            return result;
+        const std::uint64_t count = buffer[0];
+        const std::uint64_t enabled = buffer[1];
+        const std::uint64_t running = buffer[2];
+        if (!running)
+            return result;
+        const double scale = static_cast<double>(enabled) / running;
+
+        std::int64_t* targets[kinds] = { &result.cycles, &result.instructions, &result.cache_misses, &result.branch_misses };
+        for (std::uint64_t index = 0; index < count && index < kinds; ++index)
+        {
+            const std::uint64_t value = buffer[3 + 2 * index];
+            const std::uint64_t id = buffer[4 + 2 * index];
+            for (int kind = 0; kind < kinds; ++kind)
+                if (my_files[kind] >= 0 && my_ids[kind] == id)
+                    *targets[kind] = static_cast<std::int64_t>(value * scale);
+        }
+#endif
+        return result;
+    }
+
+    bool trace::counters::supported() noexcept
+    {
+#ifdef __linux__
+        static const bool opened = []
+        {
+            const int file = open_counter(counter_configs[0], -1);
+            if (file < 0)
+                return false;
+            close(file);
+            return true;
+        }();
+        return opened;
+#else
+        return false;
+#endif
+    }
+}
+
+// Здесь должен быть Unicode
@@ -4,6 +4,7 @@
 #include <utility>
 #include <string>
 #include <sstream>
+#include <thread>
 
 namespace dot
 {
@@ -15,10 +16,22 @@ namespace dot
     DOT_CLASS_ID(fail::null_reference)
     DOT_CLASS_ID(fail::non_comparable)
     DOT_CLASS_ID(fail::non_orderable)
+    DOT_CLASS_ID(fail::bad_path)
 
     template<> DOT_CLASS_ID(rope<fail::info>)
     template<> DOT_CLASS_ID(rope<fail::info>::cow)
 
+    DOT_REGISTER_CLASS(fail::error)
+    DOT_REGISTER_CLASS(fail::bad_typecast)
+    DOT_REGISTER_CLASS(fail::unreadable_data)
+    DOT_REGISTER_CLASS(fail::null_reference)
+    DOT_REGISTER_CLASS(fail::non_comparable)
+    DOT_REGISTER_CLASS(fail::non_orderable)
+    DOT_REGISTER_CLASS(fail::bad_path)
+
+    DOT_REGISTER_CLASS(rope<fail::info>)
+    DOT_REGISTER_CLASS(rope<fail::info>::cow)
+
     fail::info::info(const char* message) noexcept
         : my_backtrace(trace::stack::thread_stack(), message)
     {
@@ -42,14 +55,12 @@ namespace dot
     std::ostream& operator << (std::ostream& stream, const fail::info& source)
     {
         stream << source.what() << "\n";
-        for (trace::stack backtrace = source.backtrace();
-                          backtrace.not_empty();
-                          backtrace.pop())
+        for (const trace::stack::iterator& frame : source.backtrace())
         {
             stream << " ! -> "
-                << backtrace.top_name() << " в "
-                << backtrace.top_file() << '('
-                << backtrace.top_line() << ")\n";
+                << frame.name() << " в "
+                << frame.file() << '('
+                << frame.line() << ")\n";
         }
         return stream;
     }
@@ -61,12 +72,29 @@ namespace dot
     }
 
     fail::error::error(const char* message) noexcept
-        : base(message), exception(message)
+        : base(message), exception()
     {
     }
 
     fail::error::error(const char* message, const trace::stack& backtrace) noexcept
-        : base(message, backtrace), exception(message)
+        : base(message, backtrace), exception()
+    {
+    }
+
+    namespace
+    {
+        // общая информация ошибок, откладывающих её построение
+        const rope<fail::info>& deferred_info()
+        {
+            static const rope<fail::info> empty("", trace::stack());
+            return empty;
+        }
+
+        enum deferred_state { deferred_pending, deferred_building, deferred_ready };
+    }
+
+    fail::error::error() noexcept
+        : base(deferred_info()), exception()
     {
     }
 
@@ -87,7 +115,15 @@ namespace dot
 
     std::ostream& operator << (std::ostream& stream, const fail::error& source)
     {
-        stream << " ! >> " << source.label() << ": " << *source;
+        // сообщение и бэктрейс через виртуальные методы, наследник может строить их лениво
+        stream << " ! >> " << source.label() << ": " << source.what() << "\n";
+        for (const trace::stack::iterator& frame : source.backtrace())
+        {
+            stream << " ! -> "
+                << frame.name() << " в "
+                << frame.file() << '('
+                << frame.line() << ")\n";
+        }
         return stream;
     }
 
@@ -108,8 +144,54 @@ namespace dot
     }
 
     fail::bad_typecast::bad_typecast(const class_id& to_type, const class_id& from_type) noexcept
-        : base(generate_typecast_exception_message(to_type.name(), from_type.name()).c_str())
+        : my_to_type(&to_type), my_from_type(&from_type), my_state(deferred_pending)
+    {
+    }
+
+    fail::bad_typecast::bad_typecast(const bad_typecast& another) noexcept
+        : base(another), my_to_type(another.my_to_type), my_from_type(another.my_from_type),
+          my_snapshot(another.my_snapshot), my_state(another.my_state.load(std::memory_order_acquire) == deferred_ready ? deferred_ready : deferred_pending)
+    {
+    }
+
+    // построение сообщения и бэктрейса, одновременные вызовы ждут первого
+    void fail::bad_typecast::materialize() const noexcept
+    {
+        int state = deferred_pending;
+        if (my_state.compare_exchange_strong(state, deferred_building, std::memory_order_acquire))
+        {
+            try
+            {
+                rope<fail::info>& information = const_cast<bad_typecast&>(*this);
+                information = rope<fail::info>(
+                    generate_typecast_exception_message(my_to_type->name(), my_from_type->name()).c_str(),
+                    trace::stack(my_snapshot));
+                my_state.store(deferred_ready, std::memory_order_release);
+            }
+            catch (...)
+            {
+                // без памяти остаётся пустая информация, попробуем в следующий раз
+                my_state.store(deferred_pending, std::memory_order_release);
+            }
+            return;
+        }
+        while (state == deferred_building)
+        {
+            std::this_thread::yield();
+            state = my_state.load(std::memory_order_acquire);
+        }
+    }
+
+    const char* fail::bad_typecast::what() const noexcept
     {
+        materialize();
+        return error::what();
+    }
+
+    const trace::stack& fail::bad_typecast::backtrace() const noexcept
+    {
+        materialize();
+        return error::backtrace();
     }
 
     const char* fail::bad_typecast::label() const noexcept
@@ -117,6 +199,16 @@ namespace dot
         return "Ошибка приведения типа";
     }
 
+    const class_id& fail::bad_typecast::to_type() const noexcept
+    {
+        return *my_to_type;
+    }
+
+    const class_id& fail::bad_typecast::from_type() const noexcept
+    {
+        return *my_from_type;
+    }
+
     fail::null_reference::null_reference(const char* message) noexcept
         : base(message)
     {
@@ -156,6 +248,16 @@ namespace dot
     {
         return "Данные невозможно сортировать";
     }
+
+    fail::bad_path::bad_path(const char* message) noexcept
+        : base(message)
+    {
+    }
+
+    const char* fail::bad_path::label() const noexcept
+    {
+        return "Ошибка в пути выборки";
+    }
 }
 
 // Здесь должен быть Unicode
@@ -2,213 +2,260 @@
 // может принимать любой тип данных, всё что нужно
 // это унаследоваться от объекта и создать свои данные
 
+// короткие частые методы из заголовка определяются здесь без DOT_INLINE_HOT
+#define DOT_OBJECT_SOURCE
+
 #include <dot/object.h>
 #include <dot/box.h>
 #include <dot/rope.h>
 #include <dot/fail.h>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <utility>
 #include <string>
 
 namespace dot
 {
-    const char* const object::data::null_string = "null";
+    const char* const object_data::null_string = "null";
 
-    object::~object() noexcept
+    namespace
     {
-        // очистка перед удалением
-        reset();
+        // идентификаторы объекта и данных определены в заголовке без DOT_CLASS_ID,
+        // в реестр классов они попадают при загрузке так же, как и остальные
+        const bool object_registered = (object::id(), object_data::id(), true);
     }
 
-    void object::reset() noexcept
+    DOT_CLASS_ID(heap_data)
+    DOT_REGISTER_CLASS(heap_data)
+
+    // объект по умолчанию целиком собирается здесь
+    template class DOT_PUBLIC basic_object<16>;
+
+    std::ostream& object_data::print(std::ostream& stream, const object_data* source)
     {
-        if (my_data)
+        if (source)
+        {
+            return stream << *source;
+        }
+        else
         {
-            // явный вызов деструктора после placement new
-            my_data->~data();
-            my_data = nullptr;
+            return stream << null_string;
         }
     }
 
-    bool object::is_null() const noexcept
+    object_data::~object_data() noexcept
     {
-        return my_data == nullptr;
     }
 
-    bool object::is_not_null() const noexcept
+    void object_data::write(std::ostream& stream) const
     {
-        return !is_null();
+        // unknown data output by default
+        stream << "<data: " << my_id().name() << ">";
     }
 
-    object::object(const object& another)
+    void object_data::read(std::istream&)
     {
-        another.copy_to(*this);
+        // exception of unreadable data throws by default
+        // must be overloaded before read data from stream
+        throw fail::unreadable_data("Unable to read data of the object from byte stream.");
     }
 
-    object& object::operator = (const object& another)
+    bool object_data::operator == (const object_data& another) const
     {
-        another.copy_to(*this);
-        return *this;
+        return equals(another);
     }
 
-    object::object(object&& temporary) noexcept
+    bool object_data::operator != (const object_data& another) const
     {
-        std::move(temporary).move_to(*this);
+        return !equals(another);
     }
 
-    object& object::operator = (object&& temporary) noexcept
+    bool object_data::operator <= (const object_data& another) const
     {
-        std::move(temporary).move_to(*this);
-        return *this;
+        return !another.less(*this);
     }
 
-    void object::copy_to(object& target) const&
+    bool object_data::operator >= (const object_data& another) const
     {
-        target.reset();
-        if (my_data)
-            target.my_data = my_data->copy_to(target.my_buffer);
+        return !less(another);
     }
 
-    void object::move_to(object& target) &&
+    bool object_data::operator < (const object_data& another) const
     {
-        target.reset();
-        if (my_data)
-            target.my_data = my_data->move_to(target.my_buffer);
+        return less(another);
     }
 
-    bool object::operator == (const object& another) const
+    bool object_data::operator > (const object_data& another) const
     {
-        return my_data == another.my_data ||
-            my_data && another.my_data && my_data->equals(*another.my_data);
+        return another.less(*this);
     }
 
-    bool object::operator != (const object& another) const
+    bool object_data::equals(const object_data& another) const noexcept
     {
-        return !(*this == another);
+        return this == &another; // compare address by default, override if required
     }
 
-    bool object::operator <= (const object& another) const
+    bool object_data::less(const object_data& another) const noexcept
     {
-        return !(another < *this);
+        return this < &another; // compare address by default, override if required
     }
 
-    bool object::operator >= (const object& another) const
+    const void* object_data::find_value(const void*) const noexcept
     {
-        return !(*this < another);
+        return nullptr; // no value of known type by default
     }
 
-    bool object::operator < (const object& another) const
+    // блок в кучу выделяется вместе с заголовком, выравнивание заголовка
+    // не меньше выравнивания любых данных в буфере объекта; копии heap_data
+    // делят блок по счётчику ссылок, как "верёвки" делят "шею" "коровы"
+    struct alignas(std::max_align_t) heap_data::block
     {
-        return !my_data && another.my_data ||
-            my_data && another.my_data && my_data->less(*another.my_data);
-    }
+        std::atomic<uint64> bound;
+        std::size_t size;
+        object_data_kind kind;
 
-    bool object::operator > (const object& another) const
-    {
-        return another < *this;
-    }
+        void* buffer() noexcept
+        {
+            return this + 1;
+        }
+
+        object_data* data() noexcept
+        {
+            return std::launder(reinterpret_cast<object_data*>(this + 1));
+        }
+
+        static block* allocate(std::size_t size, object_data_kind kind)
+        {
+            return new(::operator new(sizeof(block) + size)) block{ { 1 }, size, kind };
+        }
+
+        static void release(block* instance) noexcept
+        {
+            if (--instance->bound)
+                return;
+            if (instance->kind >= object_data_kind::relocatable)
+                instance->data()->~object_data();
+            ::operator delete(instance);
+        }
+    };
 
-    const object::data& object::get_data() const
+    heap_data::heap_data(const object_data& source, std::size_t size, object_data_kind kind)
+        : my_block(block::allocate(size, kind))
     {
-        if (!my_data)
-            throw fail::null_reference("Попытка доступа к несуществующим данным.");
-        return *my_data;
+        if (kind == object_data_kind::trivial)
+            std::memcpy(my_block->buffer(), &source, size);
+        else
+            source.copy_to(my_block->buffer());
     }
 
-    const class_id& object::id() noexcept
+    heap_data::heap_data(object_data&& source, std::size_t size, object_data_kind kind)
+        : my_block(block::allocate(size, kind))
     {
-        static const class_id object_id("object");
-        return object_id;
+        // побайтно перенесённые данные источник больше не удаляет
+        if (kind == object_data_kind::general)
+            source.move_to(my_block->buffer());
+        else
+            std::memcpy(my_block->buffer(), &source, size);
     }
 
-    std::ostream& operator << (std::ostream& stream, const object& source)
+    heap_data::heap_data(const heap_data& another) noexcept
+        : my_block(another.my_block)
     {
-        if (source.my_data)
-        {
-            return stream << *source.my_data;
-        }
-        else
-        {
-            return stream << object::data::null_string;
-        }
+        ++my_block->bound;
     }
 
-    std::istream& operator >> (std::istream& stream, object& /*destination*/)
+    heap_data::heap_data(heap_data&& temporary) noexcept
+        : my_block(std::exchange(temporary.my_block, nullptr))
     {
-        // TODO: initialize data by incoming byte stream
-        return stream;
     }
 
-    object::data::~data() noexcept
+    heap_data::~heap_data() noexcept
     {
+        if (my_block)
+            block::release(my_block);
     }
 
-    void object::data::write(std::ostream& stream) const
+    const object_data& heap_data::stored() const noexcept
     {
-        // unknown data output by default
-        stream << "<data: " << my_id().name() << ">";
+        return *my_block->data();
     }
 
-    void object::data::read(std::istream&)
+    std::size_t heap_data::stored_size() const noexcept
     {
-        // exception of unreadable data throws by default
-        // must be overloaded before read data from stream
-        throw fail::unreadable_data("Unable to read data of the object from byte stream.");
+        return my_block->size;
     }
 
-    bool object::data::operator == (const data& another) const
+    object_data_kind heap_data::stored_kind() const noexcept
     {
-        return equals(another);
+        return my_block->kind;
     }
 
-    bool object::data::operator != (const data& another) const
+    object_data* heap_data::copy_to(void* buffer) const noexcept
     {
-        return !equals(another);
+        return new(buffer) heap_data(*this);
     }
 
-    bool object::data::operator <= (const data& another) const
+    object_data* heap_data::move_to(void* buffer) noexcept
     {
-        return !another.less(*this);
+        return new(buffer) heap_data(std::move(*this));
     }
 
-    bool object::data::operator >= (const data& another) const
+    void heap_data::write(std::ostream& stream) const
     {
-        return !less(another);
+        stored().write(stream);
     }
 
-    bool object::data::operator < (const data& another) const
+    void heap_data::read(std::istream& stream)
     {
-        return less(another);
+        // чтение меняет данные, общий блок сначала копируется
+        if (my_block->bound > 1)
+        {
+            block* own = block::allocate(stored_size(), stored_kind());
+            if (stored_kind() == object_data_kind::trivial)
+                std::memcpy(own->buffer(), &stored(), stored_size());
+            else
+                stored().copy_to(own->buffer());
+            block::release(my_block);
+            my_block = own;
+        }
+        my_block->data()->read(stream);
     }
 
-    bool object::data::operator > (const data& another) const
+    namespace
     {
-        return another.less(*this);
+        // данные без обёртки heap_data для сравнения значений
+        const object_data& unwrapped(const object_data& source) noexcept
+        {
+            return source.my_id() == heap_data::id() ? static_cast<const heap_data&>(source).stored() : source;
+        }
     }
 
-    bool object::data::equals(const data& another) const noexcept
+    // обе стороны сравниваются без обёртки, а данные со значением того же типа
+    // в другом виде сравниваются по значению через value_as
+    bool heap_data::equals(const object_data& another) const noexcept
     {
-        return this == &another; // compare address by default, override if required
+        return stored().equals(unwrapped(another));
     }
 
-    bool object::data::less(const data& another) const noexcept
+    bool heap_data::less(const object_data& another) const noexcept
     {
-        return this < &another; // compare address by default, override if required
+        return stored().less(unwrapped(another));
     }
 
-    const class_id& object::data::id() noexcept
+    const void* heap_data::find_value(const void* tag) const noexcept
     {
-        static const class_id object_data_id("object::data");
-        return object_data_id;
+        return stored().find_value(tag);
     }
 
-    std::ostream& operator << (std::ostream& stream, const object::data& value)
+    std::ostream& operator << (std::ostream& stream, const object_data& value)
     {
         value.write(stream);
         return stream;
     }
 
-    std::istream& operator >> (std::istream& stream, object::data& value)
+    std::istream& operator >> (std::istream& stream, object_data& value)
     {
         value.read(stream);
         return stream;
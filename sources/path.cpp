@@ -0,0 +1,620 @@
+// Выборка данных из дерева вложенных объектов по пути
+// вида "orders[*].items[*].sku" компилируемому один раз
+// результат выборки ссылается на данные без копирования
+
+#include <dot/path.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <dot/fail.h>
+#include <dot/visit.h>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+
+namespace dot
+{
+    template<> DOT_CLASS_ID(rope<array>)
+    template<> DOT_CLASS_ID(rope<array>::cow)
+    template<> DOT_CLASS_ID(rope<record>)
+    template<> DOT_CLASS_ID(rope<record>::cow)
+
+    DOT_REGISTER_CLASS(rope<array>)
+    DOT_REGISTER_CLASS(rope<array>::cow)
+    DOT_REGISTER_CLASS(rope<record>)
+    DOT_REGISTER_CLASS(rope<record>::cow)
+
+    namespace
+    {
+        // число из данных объекта для сравнения в фильтре независимо от типа:
+        // знаковые и небольшие беззнаковые целые сравниваются как long long,
+        // остальные числа и смесь целых с дробными как long double
+        struct number
+        {
+            bool valid = false;
+            bool integral = false;
+            long long integer = 0;
+            long double floating = 0;
+        };
+
+        number number_of(const object& value)
+        {
+            return visit<int, long long, long, short, char, unsigned int, unsigned short, unsigned char,
+                unsigned long, unsigned long long, double, float>(value, overloaded
+            {
+                [](const auto& source)
+                {
+                    typedef std::decay_t<decltype(source)> source_type;
+                    number result;
+                    result.valid = true;
+                    result.integral = std::is_integral_v<source_type> &&
+                        (std::is_signed_v<source_type> || sizeof(source_type) < sizeof(long long));
+                    if (result.integral)
+                        result.integer = static_cast<long long>(source);
+                    result.floating = static_cast<long double>(source);
+                    return result;
+                },
+                [](const object&) { return number(); }
+            });
+        }
+    }
+
+    // шаг пути: поле, все элементы, индекс, диапазон либо фильтр
+    class path::step
+    {
+    public:
+        enum kind_type { field, children, index, slice, filter };
+
+        // сравнение значения найденного условием фильтра с литералом
+        enum compare_type { exists, equal, not_equal, less, less_equal, greater, greater_equal };
+
+        explicit step(kind_type step_kind) noexcept
+            : kind(step_kind) { }
+
+        kind_type kind;
+
+        // имя поля записи
+        std::string name;
+
+        // индекс либо диапазон [first:last:stride] массива
+        int64 first = 0;
+        int64 last = 0;
+        int64 stride = 1;
+        bool has_first = false;
+        bool has_last = false;
+
+        // условие фильтра: путь от элемента, сравнение и литерал
+        std::vector<step> condition;
+        compare_type compare = exists;
+        object literal;
+
+        // проверка значения найденного путём условия фильтра,
+        // числа разных типов сравниваются по значению, остальное как объекты
+        bool satisfies(const object& value) const
+        {
+            if (compare == exists)
+                return true;
+            const number left = number_of(value);
+            const number right = number_of(literal);
+            if (left.valid && right.valid)
+            {
+                return left.integral && right.integral ? holds(left.integer, right.integer)
+                    : holds(left.floating, right.floating);
+            }
+            return holds(value, literal);
+        }
+
+        template <typename value_type>
+        bool holds(const value_type& value, const value_type& bound) const
+        {
+            switch (compare)
+            {
+            case equal:         return value == bound;
+            case not_equal:     return value != bound;
+            case less:          return value < bound;
+            case less_equal:    return value <= bound;
+            case greater:       return value > bound;
+            case greater_equal: return value >= bound;
+            default:            return true;
+            }
+        }
+    };
+
+    namespace
+    {
+        // доступ к массиву в данных объекта без исключений
+        const array* array_of(const object& node) noexcept
+        {
+            if (node.is_null())
+                return nullptr;
+            const object::data& data = node.get_data();
+            if (data.is_not<rope<array>::cow>())
+                return nullptr;
+            return &static_cast<const rope<array>::cow&>(data).look();
+        }
+
+        // доступ к записи в данных объекта без исключений
+        const record* record_of(const object& node) noexcept
+        {
+            if (node.is_null())
+                return nullptr;
+            const object::data& data = node.get_data();
+            if (data.is_not<rope<record>::cow>())
+                return nullptr;
+            return &static_cast<const rope<record>::cow&>(data).look();
+        }
+
+        // проверка условия фильтра хотя бы по одному найденному значению
+        bool satisfies(const path::step& filter, const object& child);
+
+        // обход дерева по шагам пути, visit возвращает false для остановки
+        template <typename visitor_type>
+        bool walk(const std::vector<path::step>& steps, size_t position,
+                  const object& node, visitor_type& visit)
+        {
+            if (position == steps.size())
+                return visit(node);
+
+            const path::step& current = steps[position];
+            const size_t next = position + 1;
+
+            switch (current.kind)
+            {
+            case path::step::field:
+                if (const record* fields = record_of(node))
+                {
+                    auto found = fields->find(current.name);
+                    if (found != fields->end())
+                        return walk(steps, next, found->second, visit);
+                }
+                return true;
+
+            case path::step::children:
+            case path::step::filter:
+            {
+                auto accept = [&current](const object& child) -> bool
+                {
+                    return current.kind != path::step::filter || satisfies(current, child);
+                };
+                if (const array* items = array_of(node))
+                {
+                    for (const object& item : *items)
+                        if (accept(item) && !walk(steps, next, item, visit))
+                            return false;
+                }
+                else if (const record* fields = record_of(node))
+                {
+                    for (const auto& item : *fields)
+                        if (accept(item.second) && !walk(steps, next, item.second, visit))
+                            return false;
+                }
+                return true;
+            }
+
+            case path::step::index:
+                if (const array* items = array_of(node))
+                {
+                    const int64 size = static_cast<int64>(items->size());
+                    const int64 at = current.first < 0 ? size + current.first : current.first;
+                    if (at >= 0 && at < size)
+                        return walk(steps, next, (*items)[static_cast<size_t>(at)], visit);
+                }
+                return true;
+
+            case path::step::slice:
+                if (const array* items = array_of(node))
+                {
+                    const int64 size = static_cast<int64>(items->size());
+                    auto clamp = [size](int64 at) -> int64
+                    {
+                        if (at < 0)
+                            at += size;
+                        return at < 0 ? 0 : at > size ? size : at;
+                    };
+                    const int64 from = current.has_first ? clamp(current.first) : 0;
+                    const int64 to = current.has_last ? clamp(current.last) : size;
+                    for (int64 at = from; at < to; at += current.stride)
+                        if (!walk(steps, next, (*items)[static_cast<size_t>(at)], visit))
+                            return false;
+                }
+                return true;
+            }
+            return true;
+        }
+
+        bool satisfies(const path::step& filter, const object& child)
+        {
+            bool satisfied = false;
+            auto check = [&](const object& value) -> bool
+            {
+                satisfied = filter.satisfies(value);
+                return !satisfied;
+            };
+            walk(filter.condition, 0, child, check);
+            return satisfied;
+        }
+
+        // разбор выражения пути в последовательность шагов
+        class parser
+        {
+        public:
+            explicit parser(const std::string& text) noexcept
+                : my_text(text), my_position(0) { }
+
+            std::vector<path::step> parse()
+            {
+                // корневой '$' можно не указывать: "orders[*].sku"
+                const bool leading_name = peek() != '$';
+                if (!leading_name)
+                    ++my_position;
+                std::vector<path::step> steps = parse_steps(leading_name && is_name_char(peek()));
+                if (my_position < my_text.size())
+                    error("неожиданный символ");
+                return steps;
+            }
+
+        private:
+            const std::string& my_text;
+            size_t my_position;
+
+            char peek() const noexcept
+            {
+                return my_position < my_text.size() ? my_text[my_position] : '\0';
+            }
+
+            static bool is_name_char(char c) noexcept
+            {
+                const unsigned char u = static_cast<unsigned char>(c);
+                return u >= 0x80 || std::isalnum(u) || c == '_' || c == '-';
+            }
+
+            [[noreturn]] void error(const char* reason) const
+            {
+                std::stringstream message;
+                message << "Ошибка в выражении пути '" << my_text
+                        << "' в позиции " << my_position << ": " << reason << ".";
+                throw fail::bad_path(message.str().c_str());
+            }
+
+            void expect(char c)
+            {
+                if (peek() != c)
+                {
+                    std::string expected = "ожидается символ '";
+                    expected += c;
+                    expected += "'";
+                    error(expected.c_str());
+                }
+                ++my_position;
+            }
+
+            void skip_spaces() noexcept
+            {
+                while (peek() == ' ' || peek() == '\t')
+                    ++my_position;
+            }
+
+            std::string parse_name()
+            {
+                const size_t begin = my_position;
+                while (is_name_char(peek()))
+                    ++my_position;
+                if (begin == my_position)
+                    error("ожидается имя поля");
+                return my_text.substr(begin, my_position - begin);
+            }
+
+            std::string parse_quoted()
+            {
+                const char quote = peek();
+                ++my_position;
+                std::string result;
+                while (peek() != quote)
+                {
+                    if (my_position >= my_text.size())
+                        error("не закрыты кавычки");
+                    if (peek() == '\\')
+                        ++my_position;
+                    result += peek();
+                    ++my_position;
+                }
+                ++my_position;
+                return result;
+            }
+
+            bool parse_integer(int64& value)
+            {
+                const size_t begin = my_position;
+                if (peek() == '-')
+                    ++my_position;
+                while (std::isdigit(static_cast<unsigned char>(peek())))
+                    ++my_position;
+                if (my_position == begin)
+                    return false;
+                if (my_position == begin + 1 && my_text[begin] == '-')
+                    error("ожидается число");
+                errno = 0;
+                value = std::strtoll(my_text.c_str() + begin, nullptr, 10);
+                if (errno == ERANGE)
+                    error("число вне диапазона int64");
+                return true;
+            }
+
+            std::vector<path::step> parse_steps(bool leading_name)
+            {
+                std::vector<path::step> steps;
+                if (leading_name)
+                {
+                    steps.emplace_back(path::step::field);
+                    steps.back().name = parse_name();
+                }
+                for (;;)
+                {
+                    if (peek() == '.')
+                    {
+                        ++my_position;
+                        if (peek() == '*')
+                        {
+                            ++my_position;
+                            steps.emplace_back(path::step::children);
+                        }
+                        else
+                        {
+                            steps.emplace_back(path::step::field);
+                            steps.back().name = parse_name();
+                        }
+                    }
+                    else if (peek() == '[')
+                    {
+                        ++my_position;
+                        steps.push_back(parse_bracket());
+                        expect(']');
+                    }
+                    else
+                    {
+                        return steps;
+                    }
+                }
+            }
+
+            path::step parse_bracket()
+            {
+                if (peek() == '*')
+                {
+                    ++my_position;
+                    return path::step(path::step::children);
+                }
+                if (peek() == '\'' || peek() == '"')
+                {
+                    path::step result(path::step::field);
+                    result.name = parse_quoted();
+                    return result;
+                }
+                if (peek() == '?')
+                {
+                    ++my_position;
+                    return parse_filter();
+                }
+                path::step result(path::step::index);
+                result.has_first = parse_integer(result.first);
+                if (peek() != ':')
+                {
+                    if (!result.has_first)
+                        error("ожидается индекс, диапазон, '*' или фильтр");
+                    return result;
+                }
+                result.kind = path::step::slice;
+                ++my_position;
+                result.has_last = parse_integer(result.last);
+                if (peek() == ':')
+                {
+                    ++my_position;
+                    if (parse_integer(result.stride) && result.stride <= 0)
+                        error("шаг диапазона должен быть положительным");
+                }
+                return result;
+            }
+
+            path::step parse_filter()
+            {
+                const bool parenthesis = peek() == '(';
+                if (parenthesis)
+                    ++my_position;
+                skip_spaces();
+                expect('@');
+                path::step result(path::step::filter);
+                result.condition = parse_steps(false);
+                skip_spaces();
+                result.compare = parse_compare();
+                if (result.compare != path::step::exists)
+                {
+                    skip_spaces();
+                    result.literal = parse_literal();
+                    skip_spaces();
+                }
+                if (parenthesis)
+                    expect(')');
+                return result;
+            }
+
+            path::step::compare_type parse_compare()
+            {
+                auto next_is = [this](const char* token) -> bool
+                {
+                    if (my_text.compare(my_position, std::strlen(token), token) != 0)
+                        return false;
+                    my_position += std::strlen(token);
+                    return true;
+                };
+                if (next_is("==")) return path::step::equal;
+                if (next_is("!=")) return path::step::not_equal;
+                if (next_is("<=")) return path::step::less_equal;
+                if (next_is(">=")) return path::step::greater_equal;
+                if (next_is("<"))  return path::step::less;
+                if (next_is(">"))  return path::step::greater;
+                return path::step::exists;
+            }
+
+            // литералы: целые как int, дробные как double, строки как std::string
+            object parse_literal()
+            {
+                if (peek() == '\'' || peek() == '"')
+                    return object(parse_quoted());
+                const size_t begin = my_position;
+                while (is_name_char(peek()) || peek() == '.' || peek() == '+')
+                    ++my_position;
+                const std::string token = my_text.substr(begin, my_position - begin);
+                if (token == "true")
+                    return object(true);
+                if (token == "false")
+                    return object(false);
+                if (token == "null")
+                    return object();
+                if (token.empty())
+                    error("ожидается литерал для сравнения");
+                char* end = nullptr;
+                if (token.find_first_of(".eE") == std::string::npos)
+                {
+                    errno = 0;
+                    const long long value = std::strtoll(token.c_str(), &end, 10);
+                    // целое вне диапазона long long сравнивается как double
+                    if (*end == '\0' && errno != ERANGE)
+                    {
+                        if (value >= INT32_MIN && value <= INT32_MAX)
+                            return object(static_cast<int>(value));
+                        return object(value);
+                    }
+                }
+                const double value = std::strtod(token.c_str(), &end);
+                if (*end != '\0')
+                    error("некорректный литерал");
+                return object(value);
+            }
+        };
+    }
+
+    class path::instance
+    {
+    public:
+        explicit instance(const std::string& expression)
+            : my_expression(expression),
+              my_steps(parser(my_expression).parse())
+        {
+        }
+
+        const std::string& expression() const noexcept
+        {
+            return my_expression;
+        }
+
+        const std::vector<step>& steps() const noexcept
+        {
+            return my_steps;
+        }
+
+    private:
+        std::string my_expression;
+        std::vector<step> my_steps;
+    };
+
+    path::path(const char* expression)
+        : my_instance(new instance(expression ? expression : ""))
+    {
+    }
+
+    path::path(const std::string& expression)
+        : my_instance(new instance(expression))
+    {
+    }
+
+    path::~path() noexcept
+    {
+        delete my_instance;
+    }
+
+    // перенесённый путь остаётся без данных, его копия тоже пуста
+    path::path(const path& another)
+        : my_instance(another.my_instance ? new instance(*another.my_instance) : nullptr)
+    {
+    }
+
+    path& path::operator = (const path& another)
+    {
+        path copy(another);
+        std::swap(my_instance, copy.my_instance);
+        return *this;
+    }
+
+    path::path(path&& temporary) noexcept
+        : my_instance(temporary.my_instance)
+    {
+        temporary.my_instance = nullptr;
+    }
+
+    path& path::operator = (path&& temporary) noexcept
+    {
+        std::swap(my_instance, temporary.my_instance);
+        return *this;
+    }
+
+    std::vector<object> path::select(const object& root) const
+    {
+        std::vector<object> result;
+        select(root, result);
+        return result;
+    }
+
+    void path::select(const object& root, std::vector<object>& result) const
+    {
+        auto collect = [&result](const object& found) -> bool
+        {
+            result.push_back(found);
+            return true;
+        };
+        // перенесённый путь пуст и ничего не выбирает
+        if (my_instance)
+            walk(my_instance->steps(), 0, root, collect);
+    }
+
+    object path::first(const object& root) const
+    {
+        object result;
+        auto take = [&result](const object& found) -> bool
+        {
+            result = found;
+            return false;
+        };
+        if (my_instance)
+            walk(my_instance->steps(), 0, root, take);
+        return result;
+    }
+
+    bool path::matches(const object& root) const
+    {
+        bool found = false;
+        auto stop = [&found](const object&) -> bool
+        {
+            found = true;
+            return false;
+        };
+        if (my_instance)
+            walk(my_instance->steps(), 0, root, stop);
+        return found;
+    }
+
+    const char* path::expression() const noexcept
+    {
+        return my_instance ? my_instance->expression().c_str() : "";
+    }
+
+    std::ostream& operator << (std::ostream& stream, const path& source)
+    {
+        return stream << source.expression();
+    }
+}
+
+// Здесь должен быть Unicode
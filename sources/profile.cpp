@@ -0,0 +1,523 @@
+// Сводный профиль времени по скоупам трассировки
+// число вызовов, полное и собственное время каждого скоупа
+// и гистограммы задержек для перцентилей
+
+#include <dot/profile.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dot
+{
+    std::atomic<bool> trace::profile::my_profiling(false);
+
+    namespace
+    {
+        // значения меньше 32 нс хранятся точно, дальше каждая степень двойки
+        // делится на 32 линейные корзины, от 2^44 нс (почти 5 часов) всё в последней
+        constexpr unsigned histogram_bits = 5;
+        constexpr uint64 histogram_linear = uint64(1) << histogram_bits;
+        constexpr unsigned histogram_top = 44;
+        constexpr std::size_t histogram_size = (histogram_top - histogram_bits + 1) * histogram_linear;
+
+        inline unsigned highest_bit(uint64 value) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+
+        inline std::size_t histogram_index(uint64 value) noexcept
+        {
+            if (value < histogram_linear)
+                return static_cast<std::size_t>(value);
+            const unsigned bit = highest_bit(value);
+            if (bit >= histogram_top)
+                return histogram_size - 1;
+            const unsigned shift = bit - histogram_bits;
+            return static_cast<std::size_t>((shift + 1) * histogram_linear + ((value >> shift) - histogram_linear));
+        }
+
+        // наибольшее значение, попадающее в корзину
+        inline uint64 histogram_value(std::size_t index) noexcept
+        {
+            if (index < histogram_linear)
+                return index;
+            const unsigned shift = static_cast<unsigned>(index / histogram_linear - 1);
+            return ((histogram_linear + index % histogram_linear + 1) << shift) - 1;
+        }
+
+        // накопленное время места скоупа, пишет только поток-владелец
+        struct site
+        {
+            site(const char* site_name, const char* site_file, int site_line, site* next_site)
+                : name(site_name), file(site_file), line(site_line),
+                  histogram(new std::atomic<uint64>[histogram_size]()), next(next_site) { }
+
+            const char* name;
+            const char* file;
+            int line;
+
+            std::atomic<uint64> count{ 0 };
+            std::atomic<uint64> inclusive{ 0 };
+            std::atomic<uint64> exclusive{ 0 };
+            std::unique_ptr<std::atomic<uint64>[]> histogram;
+
+            // значения на момент обнуления профиля, меняются под блокировкой реестра
+            uint64 reset_count = 0;
+            uint64 reset_inclusive = 0;
+            uint64 reset_exclusive = 0;
+            std::unique_ptr<uint64[]> reset_histogram;
+
+            site* next;
+        };
+
+        // пишет только владелец, поэтому хватает чтения и записи без блокировки шины
+        inline void add(std::atomic<uint64>& counter, uint64 value) noexcept
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        // открытый скоуп потока и время вложенных в него скоупов
+        struct frame
+        {
+            site* target;
+            uint64 start;
+            uint64 children;
+            uint64 budget;
+        };
+
+        // итог по месту скоупа, сведённый по всем потокам
+        struct total
+        {
+            uint64 count = 0;
+            uint64 inclusive = 0;
+            uint64 exclusive = 0;
+            std::vector<uint64> histogram;
+        };
+
+        // одинаковые литералы разных единиц трансляции сводятся по значению
+        typedef std::tuple<std::string, std::string, int> site_key;
+        typedef std::map<site_key, total> totals;
+
+        // номер включения сбора, открытые до него скоупы забываются
+        std::atomic<uint64> profile_session(0);
+
+        std::atomic<trace::profile::budget_handler> budget_hook(nullptr);
+
+        // таблица мест скоупов одного потока с поиском по адресам литералов,
+        // при завершении потока её итог переходит в общий итог завершившихся
+        class table
+        {
+        public:
+            table();
+            ~table() noexcept;
+
+            table(const table&) = delete;
+            table& operator = (const table&) = delete;
+
+            // таблица текущего потока, создаётся при первом скоупе
+            static table* local() noexcept;
+
+            void enter(const char* name, const char* file, int line, uint64 budget, uint64 time) noexcept;
+            void leave(uint64 time) noexcept;
+
+            // реестр таблиц живых потоков и итог завершившихся
+            static std::mutex& registry_mutex();
+            static std::vector<table*>& registry();
+            static totals& retired();
+
+            // сложение накопленного с последнего обнуления, под блокировкой реестра
+            void collect(totals& result) const;
+            void rebase();
+
+        private:
+            // индекс открытой адресации, используется только потоком-владельцем
+            std::vector<site*> my_index;
+            std::size_t my_used = 0;
+
+            // список мест для чтения из других потоков, только растёт
+            std::atomic<site*> my_sites{ nullptr };
+
+            frame my_frames[trace::stack::capacity];
+            std::size_t my_depth = 0;
+            uint64 my_session = 0;
+
+            site* find(const char* name, const char* file, int line);
+            void grow();
+        };
+
+        DOT_FAST_THREAD_LOCAL table* local_table = nullptr;
+
+        inline std::size_t site_hash(const char* name, const char* file, int line) noexcept
+        {
+            const uint64 mixed = (reinterpret_cast<std::uintptr_t>(name) * 31
+                + reinterpret_cast<std::uintptr_t>(file)) * 31 + static_cast<uint64>(line);
+            return static_cast<std::size_t>((mixed * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        table::table()
+            : my_index(256, nullptr)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry().push_back(this);
+        }
+
+        table::~table() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                collect(retired());
+                std::vector<table*>& tables = registry();
+                tables.erase(std::remove(tables.begin(), tables.end(), this), tables.end());
+            }
+            for (site* target = my_sites.load(std::memory_order_relaxed); target; )
+            {
+                site* next = target->next;
+                delete target;
+                target = next;
+            }
+        }
+
+        table* table::local() noexcept
+        {
+            if (!local_table)
+            {
+                try
+                {
+                    static thread_local std::unique_ptr<table> owner(new table());
+                    local_table = owner.get();
+                }
+                catch (...)
+                {
+                    return nullptr;
+                }
+            }
+            return local_table;
+        }
+
+        std::mutex& table::registry_mutex()
+        {
+            static std::mutex registry_lock;
+            return registry_lock;
+        }
+
+        std::vector<table*>& table::registry()
+        {
+            static std::vector<table*> tables;
+            return tables;
+        }
+
+        totals& table::retired()
+        {
+            static totals finished;
+            return finished;
+        }
+
+        site* table::find(const char* name, const char* file, int line)
+        {
+            const std::size_t mask = my_index.size() - 1;
+            std::size_t slot = site_hash(name, file, line) & mask;
+            for (; my_index[slot]; slot = (slot + 1) & mask)
+            {
+                site* target = my_index[slot];
+                if (target->name == name && target->file == file && target->line == line)
+                    return target;
+            }
+            site* target = new site(name, file, line, my_sites.load(std::memory_order_relaxed));
+            my_sites.store(target, std::memory_order_release);
+            my_index[slot] = target;
+            if (++my_used * 2 > my_index.size())
+                grow();
+            return target;
+        }
+
+        void table::grow()
+        {
+            std::vector<site*> index(my_index.size() * 2, nullptr);
+            const std::size_t mask = index.size() - 1;
+            for (site* target : my_index)
+            {
+                if (!target)
+                    continue;
+                std::size_t slot = site_hash(target->name, target->file, target->line) & mask;
+                while (index[slot])
+                    slot = (slot + 1) & mask;
+                index[slot] = target;
+            }
+            my_index.swap(index);
+        }
+
+        inline void table::enter(const char* name, const char* file, int line, uint64 budget, uint64 time) noexcept
+        {
+            const uint64 session = profile_session.load(std::memory_order_relaxed);
+            if (my_session != session)
+            {
+                my_session = session;
+                my_depth = 0;
+            }
+            if (my_depth++ >= trace::stack::capacity)
+                return;
+            frame& opened = my_frames[my_depth - 1];
+            try
+            {
+                opened.target = find(name, file, line);
+            }
+            catch (...)
+            {
+                opened.target = nullptr;
+            }
+            opened.start = time;
+            opened.children = 0;
+            opened.budget = budget;
+        }
+
+        inline void table::leave(uint64 time) noexcept
+        {
+            // скоуп открыт до включения сбора
+            if (!my_depth || my_session != profile_session.load(std::memory_order_relaxed))
+                return;
+            if (--my_depth >= trace::stack::capacity)
+                return;
+            const frame& closed = my_frames[my_depth];
+            const uint64 elapsed = time - closed.start;
+            if (my_depth)
+                my_frames[my_depth - 1].children += elapsed;
+            if (closed.target)
+            {
+                add(closed.target->count, 1);
+                add(closed.target->inclusive, elapsed);
+                add(closed.target->exclusive, elapsed - closed.children);
+                add(closed.target->histogram[histogram_index(elapsed)], 1);
+            }
+            if (closed.budget && elapsed > closed.budget)
+            {
+                if (trace::profile::budget_handler handler = budget_hook.load(std::memory_order_acquire))
+                {
+                    try
+                    {
+                        handler(trace::stack::thread_stack(), elapsed, closed.budget);
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            }
+        }
+
+        void table::collect(totals& result) const
+        {
+            for (const site* target = my_sites.load(std::memory_order_acquire); target; target = target->next)
+            {
+                total& sum = result[site_key(target->name, target->file, target->line)];
+                sum.count += target->count.load(std::memory_order_relaxed) - target->reset_count;
+                sum.inclusive += target->inclusive.load(std::memory_order_relaxed) - target->reset_inclusive;
+                sum.exclusive += target->exclusive.load(std::memory_order_relaxed) - target->reset_exclusive;
+                if (sum.histogram.empty())
+                    sum.histogram.resize(histogram_size, 0);
+                for (std::size_t index = 0; index < histogram_size; ++index)
+                {
+                    sum.histogram[index] += target->histogram[index].load(std::memory_order_relaxed)
+                        - (target->reset_histogram ? target->reset_histogram[index] : 0);
+                }
+            }
+        }
+
+        void table::rebase()
+        {
+            for (site* target = my_sites.load(std::memory_order_acquire); target; target = target->next)
+            {
+                target->reset_count = target->count.load(std::memory_order_relaxed);
+                target->reset_inclusive = target->inclusive.load(std::memory_order_relaxed);
+                target->reset_exclusive = target->exclusive.load(std::memory_order_relaxed);
+                if (!target->reset_histogram)
+                    target->reset_histogram.reset(new uint64[histogram_size]);
+                for (std::size_t index = 0; index < histogram_size; ++index)
+                    target->reset_histogram[index] = target->histogram[index].load(std::memory_order_relaxed);
+            }
+        }
+
+        // значение, не меньше которого доля fraction длительностей
+        uint64 percentile(const total& sum, double fraction) noexcept
+        {
+            uint64 samples = 0;
+            for (uint64 count : sum.histogram)
+                samples += count;
+            if (!samples)
+                return 0;
+            const uint64 rank = std::max<uint64>(1, static_cast<uint64>(std::ceil(fraction * static_cast<double>(samples))));
+            uint64 seen = 0;
+            for (std::size_t index = 0; index < sum.histogram.size(); ++index)
+            {
+                seen += sum.histogram[index];
+                if (seen >= rank)
+                    return histogram_value(index);
+            }
+            return histogram_value(sum.histogram.size() - 1);
+        }
+
+        void put_percentiles(record& row, const total& sum)
+        {
+            row["p50"] = object(static_cast<long long>(percentile(sum, 0.5)));
+            row["p90"] = object(static_cast<long long>(percentile(sum, 0.9)));
+            row["p99"] = object(static_cast<long long>(percentile(sum, 0.99)));
+            row["p999"] = object(static_cast<long long>(percentile(sum, 0.999)));
+            row["max"] = object(static_cast<long long>(percentile(sum, 1.0)));
+        }
+
+        totals collect_totals()
+        {
+            totals result;
+            std::lock_guard<std::mutex> lock(table::registry_mutex());
+            result = table::retired();
+            for (const table* thread_table : table::registry())
+                thread_table->collect(result);
+            return result;
+        }
+
+        // итоги всех потоков по убыванию собственного времени
+        std::vector<std::pair<site_key, total>> sorted_totals()
+        {
+            const totals result = collect_totals();
+            std::vector<std::pair<site_key, total>> sorted;
+            for (const auto& item : result)
+            {
+                if (item.second.count)
+                    sorted.push_back(item);
+            }
+            std::stable_sort(sorted.begin(), sorted.end(),
+                [](const std::pair<site_key, total>& left, const std::pair<site_key, total>& right)
+                {
+                    return left.second.exclusive > right.second.exclusive;
+                });
+            return sorted;
+        }
+    }
+
+    void trace::profile::start() noexcept
+    {
+        profile_session.fetch_add(1, std::memory_order_relaxed);
+        my_profiling.store(true, std::memory_order_release);
+    }
+
+    void trace::profile::stop() noexcept
+    {
+        my_profiling.store(false, std::memory_order_release);
+    }
+
+    bool trace::profile::profiling() noexcept
+    {
+        return my_profiling.load(std::memory_order_acquire);
+    }
+
+    void trace::profile::reset()
+    {
+        std::lock_guard<std::mutex> lock(table::registry_mutex());
+        table::retired().clear();
+        for (table* thread_table : table::registry())
+            thread_table->rebase();
+    }
+
+    void trace::profile::dump()
+    {
+        dump(std::cout);
+    }
+
+    void trace::profile::dump(std::ostream& stream)
+    {
+        const std::ios::fmtflags flags = stream.flags();
+        const std::streamsize precision = stream.precision();
+        stream << " -- Профиль скоупов\n"
+               << "      вызовы     всего, мс      своё, мс       p99, мс   скоуп\n"
+               << std::fixed << std::setprecision(3);
+        for (const auto& item : sorted_totals())
+        {
+            stream << std::setw(12) << item.second.count
+                << std::setw(14) << item.second.inclusive / 1e6
+                << std::setw(14) << item.second.exclusive / 1e6
+                << std::setw(14) << percentile(item.second, 0.99) / 1e6 << "   "
+                << std::get<0>(item.first) << " в "
+                << std::get<1>(item.first) << '('
+                << std::get<2>(item.first) << ")\n";
+        }
+        stream.flags(flags);
+        stream.precision(precision);
+    }
+
+    array trace::profile::report()
+    {
+        array result;
+        for (const auto& item : sorted_totals())
+        {
+            record row;
+            row["name"] = object(std::get<0>(item.first));
+            row["file"] = object(std::get<1>(item.first));
+            row["line"] = object(std::get<2>(item.first));
+            row["count"] = object(static_cast<long long>(item.second.count));
+            row["inclusive"] = object(static_cast<long long>(item.second.inclusive));
+            row["exclusive"] = object(static_cast<long long>(item.second.exclusive));
+            put_percentiles(row, item.second);
+            result.push_back(object(std::move(row)));
+        }
+        return result;
+    }
+
+    object trace::profile::latency(const char* name)
+    {
+        total merged;
+        merged.histogram.resize(histogram_size, 0);
+        for (const auto& item : collect_totals())
+        {
+            if (std::get<0>(item.first) != name)
+                continue;
+            merged.count += item.second.count;
+            for (std::size_t index = 0; index < item.second.histogram.size(); ++index)
+                merged.histogram[index] += item.second.histogram[index];
+        }
+        if (!merged.count)
+            return object();
+        record row;
+        row["count"] = object(static_cast<long long>(merged.count));
+        put_percentiles(row, merged);
+        return object(std::move(row));
+    }
+
+    void trace::profile::set_budget_handler(budget_handler handler) noexcept
+    {
+        budget_hook.store(handler, std::memory_order_release);
+    }
+
+    void trace::profile::begin(const char* name, const char* file, int line, std::uint64_t budget) noexcept
+    {
+        if (table* thread_table = table::local())
+            thread_table->enter(name, file, line, budget, trace::now());
+    }
+
+    void trace::profile::end() noexcept
+    {
+        const uint64 time = trace::now();
+        if (table* thread_table = table::local())
+            thread_table->leave(time);
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,339 @@
+// Запись времени входа и выхода скоупов трассировки
+// в формате Chrome Trace Event для просмотра в chrome://tracing и Perfetto
+
+#include <dot/recorder.h>
+#include <dot/fail.h>
+#include <dot/type.h>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+namespace dot
+{
+    std::atomic<bool> trace::recorder::my_recording(false);
+
+    namespace
+    {
+        // событие входа в скоуп, у события выхода нет имени
+        struct event
+        {
+            uint64 time;
+            const char* name;
+            const char* file;
+            int line;
+        };
+
+        // кольцевой буфер событий одного потока: пишет только сам поток,
+        // читает только выгрузка, поэтому хватает двух атомарных счётчиков
+        class channel
+        {
+        public:
+            channel(std::size_t capacity, std::size_t thread)
+                : my_events(new event[capacity]), my_mask(capacity - 1), my_thread(thread),
+                  my_head(0), my_tail(0), my_closed(false)
+            {
+            }
+
+            bool push(const event& item) noexcept
+            {
+                const std::size_t head = my_head.load(std::memory_order_relaxed);
+                if (head - my_tail.load(std::memory_order_acquire) > my_mask)
+                    return false;
+                my_events[head & my_mask] = item;
+                my_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            template <typename action_type>
+            void drain(const action_type& action)
+            {
+                const std::size_t head = my_head.load(std::memory_order_acquire);
+                std::size_t tail = my_tail.load(std::memory_order_relaxed);
+                for (; tail != head; ++tail)
+                    action(my_events[tail & my_mask], my_thread);
+                my_tail.store(tail, std::memory_order_release);
+            }
+
+            // поток канала завершился, после выгрузки канал не нужен
+            void close() noexcept { my_closed.store(true, std::memory_order_release); }
+            bool closed() const noexcept { return my_closed.load(std::memory_order_acquire); }
+
+        private:
+            std::unique_ptr<event[]> my_events;
+            std::size_t my_mask;
+            std::size_t my_thread;
+            std::atomic<std::size_t> my_head;
+            std::atomic<std::size_t> my_tail;
+            std::atomic<bool> my_closed;
+        };
+
+        // строка JSON с экранированием кавычек, обратных слешей путей Windows и управляющих символов
+        void write_string(std::ostream& stream, const char* text)
+        {
+            stream << '"';
+            for (; *text; ++text)
+            {
+                const char symbol = *text;
+                if (symbol == '"' || symbol == '\\')
+                {
+                    stream << '\\' << symbol;
+                }
+                else if (static_cast<unsigned char>(symbol) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(symbol));
+                    stream << escaped;
+                }
+                else
+                {
+                    stream << symbol;
+                }
+            }
+            stream << '"';
+        }
+    }
+
+    // сеанс записи: каналы потоков, файл и фоновая выгрузка
+    class trace::recorder::session
+    {
+    public:
+        ~session();
+
+        // единственный сеанс на процесс
+        static session& current();
+
+        // запись события в канал текущего потока без блокировок
+        static void record(const event& item) noexcept;
+
+        void start(const char* path, std::size_t capacity);
+        void stop();
+        void flush();
+
+        channel* attach();
+
+        std::atomic<std::size_t> dropped{ 0 };
+
+    private:
+        // период фоновой выгрузки событий
+        static constexpr std::chrono::milliseconds flush_period{ 100 };
+
+        // start и stop выполняются по очереди
+        std::mutex my_control;
+
+        // каналы и файл разделяются потоками и выгрузкой
+        std::mutex my_mutex;
+        std::condition_variable my_wakeup;
+        std::vector<std::shared_ptr<channel>> my_channels;
+        std::ofstream my_file;
+        std::thread my_flusher;
+        bool my_stopping = false;
+        bool my_first = true;
+        std::size_t my_capacity = 1 << 16;
+        std::size_t my_next_thread = 1;
+        uint64 my_origin = 0;
+
+        void run();
+        void drain();
+        void write(const event& item, std::size_t thread);
+    };
+
+    namespace
+    {
+        // канал текущего потока, закрывается при завершении потока
+        DOT_FAST_THREAD_LOCAL channel* local_channel = nullptr;
+
+        class channel_owner
+        {
+        public:
+            ~channel_owner() { if (my_channel) my_channel->close(); }
+            std::shared_ptr<channel> my_channel;
+        };
+    }
+
+    trace::recorder::session::~session()
+    {
+        stop();
+    }
+
+    trace::recorder::session& trace::recorder::session::current()
+    {
+        static session instance;
+        return instance;
+    }
+
+    void trace::recorder::session::record(const event& item) noexcept
+    {
+        channel* target = local_channel;
+        if (!target)
+        {
+            try
+            {
+                target = local_channel = current().attach();
+            }
+            catch (...)
+            {
+                return;
+            }
+        }
+        if (!target->push(item))
+            current().dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void trace::recorder::session::start(const char* path, std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> control(my_control);
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            my_file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+            if (!my_file)
+                throw fail::error("Не удалось открыть файл для записи трассировки");
+            my_capacity = 16;
+            while (my_capacity < capacity)
+                my_capacity <<= 1;
+            // события прошлого сеанса, записанные после его завершения, не нужны
+            for (const std::shared_ptr<channel>& target : my_channels)
+                target->drain([](const event&, std::size_t) { });
+            dropped.store(0, std::memory_order_relaxed);
+            my_origin = trace::now();
+            my_first = true;
+            my_stopping = false;
+            my_file << "{\"traceEvents\":[";
+            my_flusher = std::thread(&trace::recorder::session::run, this);
+        }
+        trace::recorder::my_recording.store(true, std::memory_order_release);
+    }
+
+    void trace::recorder::session::stop()
+    {
+        std::lock_guard<std::mutex> control(my_control);
+        if (!my_flusher.joinable())
+            return;
+        trace::recorder::my_recording.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            my_stopping = true;
+        }
+        my_wakeup.notify_all();
+        my_flusher.join();
+        std::lock_guard<std::mutex> lock(my_mutex);
+        drain();
+        my_file << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        my_file.close();
+    }
+
+    void trace::recorder::session::flush()
+    {
+        std::lock_guard<std::mutex> lock(my_mutex);
+        if (my_file.is_open())
+        {
+            drain();
+            my_file.flush();
+        }
+    }
+
+    channel* trace::recorder::session::attach()
+    {
+        static thread_local channel_owner owner;
+        std::lock_guard<std::mutex> lock(my_mutex);
+        owner.my_channel = std::make_shared<channel>(my_capacity, my_next_thread++);
+        my_channels.push_back(owner.my_channel);
+        return owner.my_channel.get();
+    }
+
+    void trace::recorder::session::run()
+    {
+        std::unique_lock<std::mutex> lock(my_mutex);
+        while (!my_stopping)
+        {
+            my_wakeup.wait_for(lock, flush_period, [this] { return my_stopping; });
+            drain();
+        }
+    }
+
+    // выгрузка всех каналов, каналы завершённых потоков удаляются
+    void trace::recorder::session::drain()
+    {
+        for (std::size_t index = 0; index < my_channels.size(); )
+        {
+            channel& target = *my_channels[index];
+            const bool closed = target.closed();
+            target.drain([this](const event& item, std::size_t thread) { write(item, thread); });
+            if (closed)
+                my_channels.erase(my_channels.begin() + index);
+            else
+                ++index;
+        }
+    }
+
+    void trace::recorder::session::write(const event& item, std::size_t thread)
+    {
+        // время в микросекундах от начала записи
+        const uint64 elapsed = item.time > my_origin ? item.time - my_origin : 0;
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "%llu.%03u",
+            static_cast<unsigned long long>(elapsed / 1000), static_cast<unsigned>(elapsed % 1000));
+        my_file << (my_first ? "\n" : ",\n");
+        my_first = false;
+        if (item.name)
+        {
+            my_file << "{\"name\":";
+            write_string(my_file, item.name);
+            my_file << ",\"cat\":\"dot\",\"ph\":\"B\"";
+        }
+        else
+        {
+            my_file << "{\"ph\":\"E\"";
+        }
+        my_file << ",\"ts\":" << timestamp << ",\"pid\":1,\"tid\":" << thread;
+        if (item.name)
+        {
+            my_file << ",\"args\":{\"file\":";
+            write_string(my_file, item.file);
+            my_file << ",\"line\":" << item.line << '}';
+        }
+        my_file << '}';
+    }
+
+    void trace::recorder::start(const char* path, std::size_t capacity)
+    {
+        session::current().stop();
+        session::current().start(path, capacity);
+    }
+
+    void trace::recorder::stop()
+    {
+        session::current().stop();
+    }
+
+    void trace::recorder::flush()
+    {
+        session::current().flush();
+    }
+
+    bool trace::recorder::recording() noexcept
+    {
+        return my_recording.load(std::memory_order_acquire);
+    }
+
+    std::size_t trace::recorder::dropped() noexcept
+    {
+        return session::current().dropped.load(std::memory_order_relaxed);
+    }
+
+    void trace::recorder::begin(const char* name, const char* file, int line) noexcept
+    {
+        session::record(event{ trace::now(), name, file, line });
+    }
+
+    void trace::recorder::end() noexcept
+    {
+        session::record(event{ trace::now(), nullptr, nullptr, 0 });
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,130 @@
+// Реестр классов иерархии: от индекса или имени класса
+// к его сведениям, фабрике и кодеку данных
+
+#include <dot/registry.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace dot
+{
+    namespace
+    {
+        // индексы раскладываются по кускам, выделенные куски не перемещаются,
+        // поэтому чтение идёт без блокировок; индексы за последним куском не хранятся
+        constexpr std::size_t chunk_size = 256;
+        constexpr std::size_t chunk_count = 256;
+
+        struct slot
+        {
+            std::atomic<const class_id*> identifier;
+            std::atomic<const class_registry::codec*> codec;
+        };
+
+        struct registry_state
+        {
+            std::atomic<slot*> chunks[chunk_count] = {};
+            std::atomic<uint64> last_index{0};
+            std::mutex mutex;
+            std::unordered_map<std::string_view, const class_id*> names;
+            std::deque<class_registry::codec> codecs;
+        };
+
+        // реестр не разрушается при выходе: классы регистрируются и ищутся
+        // из конструкторов и деструкторов глобальных объектов любых модулей
+        registry_state& state()
+        {
+            static registry_state* const instance = new registry_state();
+            return *instance;
+        }
+
+        slot* find_slot(uint64 index) noexcept
+        {
+            const uint64 chunk = index / chunk_size;
+            if (chunk >= chunk_count)
+                return nullptr;
+            slot* const slots = state().chunks[chunk].load(std::memory_order_acquire);
+            return slots ? slots + index % chunk_size : nullptr;
+        }
+    }
+
+    void class_registry::add(const class_id& identifier) noexcept
+    {
+        registry_state& registry = state();
+        const uint64 index = identifier.index();
+        const uint64 chunk = index / chunk_size;
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (chunk < chunk_count)
+        {
+            slot* slots = registry.chunks[chunk].load(std::memory_order_relaxed);
+            if (!slots)
+            {
+                slots = new slot[chunk_size]();
+                registry.chunks[chunk].store(slots, std::memory_order_release);
+            }
+            slots[index % chunk_size].identifier.store(&identifier, std::memory_order_release);
+        }
+        registry.names.emplace(identifier.name(), &identifier);
+        if (index > registry.last_index.load(std::memory_order_relaxed))
+            registry.last_index.store(index, std::memory_order_release);
+    }
+
+    const class_id* class_registry::find(uint64 index) noexcept
+    {
+        const slot* const target = find_slot(index);
+        return target ? target->identifier.load(std::memory_order_acquire) : nullptr;
+    }
+
+    const class_id* class_registry::find(const char* name) noexcept
+    {
+        registry_state& registry = state();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        const auto found = registry.names.find(name);
+        return found != registry.names.end() ? found->second : nullptr;
+    }
+
+    uint64 class_registry::last_index() noexcept
+    {
+        return state().last_index.load(std::memory_order_acquire);
+    }
+
+    bool class_registry::derives(const class_id& derived, const class_id& ancestor) noexcept
+    {
+        for (const class_id* current = &derived; current; )
+        {
+            if (*current == ancestor)
+                return true;
+            current = current->info().base ? &current->info().base() : nullptr;
+        }
+        return false;
+    }
+
+    void class_registry::set_codec(const class_id& identifier, const codec& value)
+    {
+        registry_state& registry = state();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        slot* const target = find_slot(identifier.index());
+        if (!target)
+            return;
+        registry.codecs.push_back(value);
+        target->codec.store(&registry.codecs.back(), std::memory_order_release);
+    }
+
+    void class_registry::remove_codec(const class_id& identifier) noexcept
+    {
+        registry_state& registry = state();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (slot* const target = find_slot(identifier.index()))
+            target->codec.store(nullptr, std::memory_order_release);
+    }
+
+    const class_registry::codec* class_registry::find_codec(const class_id& identifier) noexcept
+    {
+        const slot* const target = find_slot(identifier.index());
+        return target ? target->codec.load(std::memory_order_acquire) : nullptr;
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,59 @@
+// Результат операции без исключений: значение либо код ошибки
+// с описанием, которое строится только по запросу
+
+#include <dot/result.h>
+#include <dot/fail.h>
+#include <string>
+
+namespace dot
+{
+    result_error::result_error(result_code code, const class_id* to_type, const class_id* from_type) noexcept
+        : my_code(code), my_to_type(to_type), my_from_type(from_type)
+    {
+    }
+
+    result_code result_error::code() const noexcept
+    {
+        return my_code;
+    }
+
+    const class_id* result_error::to_type() const noexcept
+    {
+        return my_to_type;
+    }
+
+    const class_id* result_error::from_type() const noexcept
+    {
+        return my_from_type;
+    }
+
+    std::string result_error::detail() const
+    {
+        switch (my_code)
+        {
+        case result_code::ok:
+            return std::string();
+        case result_code::null_reference:
+            return "Попытка доступа к несуществующим данным.";
+        case result_code::bad_typecast:
+            // сообщение строит само исключение, чтобы тексты не расходились
+            return fail::bad_typecast(*my_to_type, *my_from_type).what();
+        }
+        return std::string();
+    }
+
+    void result_error::raise() const
+    {
+        switch (my_code)
+        {
+        case result_code::null_reference:
+            throw fail::null_reference(detail().c_str());
+        case result_code::bad_typecast:
+            throw fail::bad_typecast(*my_to_type, *my_from_type);
+        default:
+            throw fail::error("Неудача без ошибки в результате операции.");
+        }
+    }
+}
+
+// Здесь должен быть Unicode
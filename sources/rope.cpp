@@ -9,6 +9,9 @@ namespace dot
 {
     DOT_CLASS_ID(rope_based)
     DOT_CLASS_ID(rope_based::cow_based)
+
+    DOT_REGISTER_CLASS(rope_based)
+    DOT_REGISTER_CLASS(rope_based::cow_based)
 }
 
 // Здесь должен быть Unicode
@@ -0,0 +1,334 @@
+// Выборочный профиль по сигналу таймера процессорного времени
+// в формате свёрнутых стеков для построения flame graph
+
+#include <dot/sampler.h>
+#include <dot/fail.h>
+#include <dot/type.h>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+namespace dot
+{
+    std::atomic<bool> trace::sampler::my_sampling(false);
+
+    namespace
+    {
+        // выборка: имена кадров стека от корня к вершине
+        struct sample
+        {
+            const char* names[trace::sampler::depth];
+            std::size_t size;
+        };
+
+        // ячейка буфера выборок, номер поколения отличает записанную ячейку от свободной
+        struct cell
+        {
+            std::atomic<std::size_t> sequence;
+            sample item;
+        };
+    }
+
+    // сеанс сбора: буфер выборок, таймер, обработчик сигнала и фоновое сведение
+    class trace::sampler::session
+    {
+    public:
+        ~session();
+
+        // единственный сеанс на процесс
+        static session& current();
+
+        void start(std::chrono::microseconds interval, std::size_t capacity);
+        void stop();
+        void reset();
+        void dump(std::ostream& stream);
+
+        std::atomic<std::size_t> samples{ 0 };
+        std::atomic<std::size_t> dropped{ 0 };
+
+    private:
+        // период фонового сведения выборок
+        static constexpr std::chrono::milliseconds drain_period{ 100 };
+
+        // сеанс, в который пишет обработчик сигнала, пуст когда сбор остановлен
+        static std::atomic<session*> active;
+
+        // число обработчиков сигнала, выполняющихся прямо сейчас
+        static std::atomic<std::size_t> handling;
+
+        // start и stop выполняются по очереди
+        std::mutex my_control;
+
+        // буфер выборок: пишут обработчики сигнала всех потоков без блокировок,
+        // читает под my_mutex фоновое сведение
+        std::unique_ptr<cell[]> my_cells;
+        std::size_t my_mask = 0;
+        std::atomic<std::size_t> my_tail{ 0 };
+        std::size_t my_head = 0;
+
+        std::mutex my_mutex;
+        std::condition_variable my_wakeup;
+        std::map<std::vector<const char*>, std::size_t> my_stacks;
+        std::thread my_drainer;
+        bool my_stopping = false;
+        bool my_installed = false;
+
+        static void handle(int signal_number);
+        void push(const char* const* names, std::size_t size) noexcept;
+
+        void run();
+        void drain();
+    };
+
+    std::atomic<trace::sampler::session*> trace::sampler::session::active(nullptr);
+    std::atomic<std::size_t> trace::sampler::session::handling(0);
+
+    trace::sampler::session::~session()
+    {
+        stop();
+    }
+
+    trace::sampler::session& trace::sampler::session::current()
+    {
+        static session instance;
+        return instance;
+    }
+
+    // обработчик SIGPROF: только чтение кадров своего потока и атомарные операции
+    void trace::sampler::session::handle(int)
+    {
+        const int saved_errno = errno;
+        // порядок с остановкой: обработчик отмечается до чтения сеанса,
+        // остановка сбрасывает сеанс до ожидания обработчиков
+        handling.fetch_add(1);
+        if (session* target = active.load())
+        {
+            const char* names[trace::stack::capacity];
+            std::size_t size = 0;
+            for (trace::stack::iterator frame = trace::stack::signal_top(); frame != trace::stack::iterator() && size < trace::stack::capacity; ++frame)
+                names[size++] = frame.name();
+            target->push(names, size);
+        }
+        handling.fetch_sub(1);
+        errno = saved_errno;
+    }
+
+    // очередь с ограниченным буфером на номерах поколений ячеек, пишут несколько потоков
+    void trace::sampler::session::push(const char* const* names, std::size_t size) noexcept
+    {
+        std::size_t position = my_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell& target = my_cells[position & my_mask];
+            const std::size_t sequence = target.sequence.load(std::memory_order_acquire);
+            if (sequence == position)
+            {
+                if (my_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    // кадры стека идут от вершины, в выборку от корня
+                    const std::size_t kept = size < trace::sampler::depth ? size : trace::sampler::depth;
+                    for (std::size_t index = 0; index < kept; ++index)
+                        target.item.names[index] = names[size - 1 - index];
+                    target.item.size = kept;
+                    target.sequence.store(position + 1, std::memory_order_release);
+                    return;
+                }
+            }
+            else if (sequence < position)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                position = my_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void trace::sampler::session::start(std::chrono::microseconds interval, std::size_t capacity)
+    {
+#ifdef _WIN32
+        static_cast<void>(interval);
+        static_cast<void>(capacity);
+        throw fail::error("Выборочный профиль по сигналу таймера поддерживается только в POSIX системах");
+#else
+        std::lock_guard<std::mutex> control(my_control);
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            std::size_t size = 16;
+            while (size < capacity)
+                size <<= 1;
+            // буфер заводится заново только при смене размера
+            if (size != my_mask + 1)
+            {
+                my_cells.reset(new cell[size]);
+                my_mask = size - 1;
+            }
+            for (std::size_t index = 0; index < size; ++index)
+                my_cells[index].sequence.store(index, std::memory_order_relaxed);
+            my_tail.store(0, std::memory_order_relaxed);
+            my_head = 0;
+            my_stopping = false;
+            my_drainer = std::thread(&trace::sampler::session::run, this);
+        }
+        // обработчик не снимается при остановке: отложенный SIGPROF
+        // с действием по умолчанию завершил бы процесс
+        if (!my_installed)
+        {
+            struct sigaction action = {};
+            action.sa_handler = &trace::sampler::session::handle;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (sigaction(SIGPROF, &action, nullptr) != 0)
+                throw fail::error("Не удалось установить обработчик сигнала SIGPROF");
+            my_installed = true;
+        }
+        active.store(this, std::memory_order_release);
+        trace::sampler::my_sampling.store(true, std::memory_order_release);
+        itimerval timer = {};
+        timer.it_interval.tv_sec = static_cast<time_t>(interval.count() / 1000000);
+        timer.it_interval.tv_usec = static_cast<suseconds_t>(interval.count() % 1000000);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+        {
+            active.store(nullptr, std::memory_order_release);
+            trace::sampler::my_sampling.store(false, std::memory_order_release);
+            throw fail::error("Не удалось запустить таймер процессорного времени");
+        }
+#endif
+    }
+
+    void trace::sampler::session::stop()
+    {
+        std::lock_guard<std::mutex> control(my_control);
+        if (!my_drainer.joinable())
+            return;
+#ifndef _WIN32
+        itimerval timer = {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+        active.store(nullptr);
+        trace::sampler::my_sampling.store(false, std::memory_order_release);
+        // обработчики, успевшие взять сеанс, дописывают выборки
+        while (handling.load())
+            std::this_thread::yield();
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            my_stopping = true;
+        }
+        my_wakeup.notify_all();
+        my_drainer.join();
+        std::lock_guard<std::mutex> lock(my_mutex);
+        drain();
+    }
+
+    void trace::sampler::session::reset()
+    {
+        std::lock_guard<std::mutex> lock(my_mutex);
+        if (my_cells)
+            drain();
+        my_stacks.clear();
+        samples.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+    }
+
+    void trace::sampler::session::dump(std::ostream& stream)
+    {
+        std::map<std::string, std::size_t> folded;
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            if (my_cells)
+                drain();
+            // одинаковые имена из разных литералов сливаются в один стек
+            for (const auto& entry : my_stacks)
+            {
+                std::string path;
+                for (const char* name : entry.first)
+                {
+                    if (!path.empty())
+                        path += ';';
+                    path += name;
+                }
+                folded[path.empty() ? trace::sampler::outside : path] += entry.second;
+            }
+        }
+        for (const auto& entry : folded)
+            stream << entry.first << ' ' << entry.second << '\n';
+    }
+
+    void trace::sampler::session::run()
+    {
+        std::unique_lock<std::mutex> lock(my_mutex);
+        while (!my_stopping)
+        {
+            my_wakeup.wait_for(lock, drain_period, [this] { return my_stopping; });
+            drain();
+        }
+    }
+
+    // сведение записанных выборок по стекам, ячейки освобождаются для следующего круга
+    void trace::sampler::session::drain()
+    {
+        for (;;)
+        {
+            cell& target = my_cells[my_head & my_mask];
+            if (target.sequence.load(std::memory_order_acquire) != my_head + 1)
+                break;
+            const sample& item = target.item;
+            ++my_stacks[std::vector<const char*>(item.names, item.names + item.size)];
+            samples.fetch_add(1, std::memory_order_relaxed);
+            target.sequence.store(my_head + my_mask + 1, std::memory_order_release);
+            ++my_head;
+        }
+    }
+
+    void trace::sampler::start(std::chrono::microseconds interval, std::size_t capacity)
+    {
+        session::current().stop();
+        session::current().start(interval, capacity);
+    }
+
+    void trace::sampler::stop()
+    {
+        session::current().stop();
+    }
+
+    bool trace::sampler::sampling() noexcept
+    {
+        return my_sampling.load(std::memory_order_acquire);
+    }
+
+    void trace::sampler::reset()
+    {
+        session::current().reset();
+    }
+
+    void trace::sampler::dump(std::ostream& stream)
+    {
+        session::current().dump(stream);
+    }
+
+    std::size_t trace::sampler::samples() noexcept
+    {
+        return session::current().samples.load(std::memory_order_relaxed);
+    }
+
+    std::size_t trace::sampler::dropped() noexcept
+    {
+        return session::current().dropped.load(std::memory_order_relaxed);
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,348 @@
+// Сортировка массивов объектов по нормализованным ключам
+// ключи сравниваются побайтно без виртуальных вызовов
+// а сама сортировка выполняется параллельно на всех ядрах
+
+#include <dot/sort.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <algorithm>
+#include <utility>
+#include <thread>
+#include <cstring>
+
+namespace dot
+{
+    namespace
+    {
+        // ранги типов в первом байте ключа
+        enum rank_type : byte
+        {
+            rank_null,
+            rank_bool,
+            rank_number,
+            rank_string,
+            rank_wstring,
+            rank_u16string,
+            rank_u32string
+        };
+
+        // запись беззнакового числа старшими байтами вперёд
+        template <typename unsigned_type>
+        void put_big_endian(std::string& key, unsigned_type bits)
+        {
+            for (int shift = 8 * (sizeof(unsigned_type) - 1); shift >= 0; shift -= 8)
+                key += static_cast<char>(static_cast<byte>(bits >> shift));
+        }
+
+        // числа всех типов в одной области ключей: биты IEEE 754 значения double
+        // с инверсией для сохранения порядка, затем байт положения точного значения
+        // относительно double; целое, не представимое точно, добавляет знак и 64 бита,
+        // в дополнительном коде отрицательные упорядочены так же как беззнаковые
+        enum number_side : byte
+        {
+            side_below,
+            side_exact,
+            side_above
+        };
+
+        void put_double(std::string& key, double value)
+        {
+            if (value == 0.0)
+                value = 0.0; // -0.0 и 0.0 равны
+            uint64 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits = (bits >> 63) ? ~bits : bits | (uint64(1) << 63);
+            key += static_cast<char>(rank_number);
+            put_big_endian(key, bits);
+        }
+
+        template <typename integer_type>
+        void encode_integer(const object::data& data, std::string& key)
+        {
+            const integer_type value = static_cast<const typename box<integer_type>::cat&>(data).look();
+            typedef std::conditional_t<std::is_signed_v<integer_type>, int64, uint64> wide_type;
+            const wide_type wide = static_cast<wide_type>(value);
+            const double rounded = static_cast<double>(wide);
+            put_double(key, rounded);
+            const int order = box_based::cat_based::compare_exact(wide, rounded);
+            if (!order)
+            {
+                key += static_cast<char>(side_exact);
+                return;
+            }
+            key += static_cast<char>(order < 0 ? side_below : side_above);
+            key += static_cast<char>(wide < 0 ? 0 : 1);
+            put_big_endian(key, static_cast<uint64>(wide));
+        }
+
+        template <typename floating_type>
+        void encode_floating(const object::data& data, std::string& key)
+        {
+            put_double(key, static_cast<const typename box<floating_type>::cat&>(data).look());
+            key += static_cast<char>(side_exact);
+        }
+
+        void encode_bool(const object::data& data, std::string& key)
+        {
+            key += static_cast<char>(rank_bool);
+            key += static_cast<char>(static_cast<const box<bool>::cat&>(data).look() ? 1 : 0);
+        }
+
+        // строки: единицы кодировки старшими байтами вперёд, короткий префикс меньше
+        template <typename string_type, byte rank>
+        void encode_string(const object::data& data, std::string& key)
+        {
+            using unit_type = typename string_type::value_type;
+            const string_type& value = static_cast<const typename rope<string_type>::cow&>(data).look();
+            key += static_cast<char>(rank);
+            if constexpr (sizeof(unit_type) == 1)
+            {
+                key.append(reinterpret_cast<const char*>(value.data()), value.size());
+            }
+            else
+            {
+                key.reserve(key.size() + value.size() * sizeof(unit_type));
+                for (unit_type unit : value)
+                    put_big_endian(key, static_cast<std::make_unsigned_t<unit_type>>(unit));
+            }
+        }
+
+        typedef void (*encoder_type)(const object::data&, std::string&);
+
+        struct encoder_entry
+        {
+            const class_id& id;
+            encoder_type encode;
+        };
+
+        // таблица кодирования встроенных типов по идентификатору данных
+        const std::vector<encoder_entry>& encoders()
+        {
+            static const std::vector<encoder_entry> table =
+            {
+                { box<int>::cat::id(),                &encode_integer<int> },
+                { box<double>::cat::id(),             &encode_floating<double> },
+                { rope<std::string>::cow::id(),       &encode_string<std::string, rank_string> },
+                { box<long long>::cat::id(),          &encode_integer<long long> },
+                { box<long>::cat::id(),               &encode_integer<long> },
+                { box<bool>::cat::id(),               &encode_bool },
+                { box<unsigned int>::cat::id(),       &encode_integer<unsigned int> },
+                { box<unsigned long long>::cat::id(), &encode_integer<unsigned long long> },
+                { box<unsigned long>::cat::id(),      &encode_integer<unsigned long> },
+                { box<float>::cat::id(),              &encode_floating<float> },
+                { box<short>::cat::id(),              &encode_integer<short> },
+                { box<unsigned short>::cat::id(),     &encode_integer<unsigned short> },
+                { box<char>::cat::id(),               &encode_integer<char> },
+                { box<unsigned char>::cat::id(),      &encode_integer<unsigned char> },
+                { rope<std::wstring>::cow::id(),      &encode_string<std::wstring, rank_wstring> },
+                { rope<std::u16string>::cow::id(),    &encode_string<std::u16string, rank_u16string> },
+                { rope<std::u32string>::cow::id(),    &encode_string<std::u32string, rank_u32string> },
+            };
+            return table;
+        }
+
+        // один виртуальный вызов на объект вместо вызовов на каждое сравнение
+        void append_key(const object& value, std::string& key)
+        {
+            if (value.is_null())
+            {
+                key += static_cast<char>(rank_null);
+                return;
+            }
+            const object::data& data = value.get_data();
+            const class_id& id = data.my_id();
+            for (const encoder_entry& entry : encoders())
+            {
+                if (entry.id == id)
+                {
+                    entry.encode(data, key);
+                    return;
+                }
+            }
+            key += static_cast<char>(sort_key_unordered);
+        }
+
+        // элемент сортировки: первые 8 байт ключа числом для быстрого сравнения
+        struct entry
+        {
+            uint64 prefix;
+            const char* key;
+            size_t length;
+            size_t index;
+
+            bool operator < (const entry& another) const noexcept
+            {
+                if (prefix != another.prefix)
+                    return prefix < another.prefix;
+                const size_t common = std::min(length, another.length);
+                if (common > sizeof(prefix))
+                {
+                    const int order = std::memcmp(key + sizeof(prefix), another.key + sizeof(prefix),
+                        common - sizeof(prefix));
+                    if (order)
+                        return order < 0;
+                }
+                if (length != another.length)
+                    return length < another.length;
+                return index < another.index;
+            }
+        };
+
+        // меньше этого количества параллельная сортировка не окупается
+        constexpr size_t parallel_threshold = 1 << 14;
+
+        // число элементов выборки на каждый поток для выбора разделителей
+        constexpr size_t oversampling = 64;
+
+        // запуск действия над частями [0, parts) в отдельных потоках
+        template <typename action_type>
+        void parallel_for(uint parts, const action_type& action)
+        {
+            std::vector<std::thread> workers;
+            workers.reserve(parts - 1);
+            for (uint part = 1; part < parts; ++part)
+                workers.emplace_back(action, part);
+            action(0u);
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+
+        // границы части part из parts для диапазона [0, size)
+        size_t part_begin(size_t size, uint parts, uint part) noexcept
+        {
+            return size * part / parts;
+        }
+
+        // сортировка выборкой: разделители по выборке, раскладка по корзинам,
+        // затем каждая корзина сортируется в своём потоке
+        void sample_sort(std::vector<entry>& entries, uint threads)
+        {
+            const size_t size = entries.size();
+            std::vector<entry> samples;
+            samples.reserve(threads * oversampling);
+            for (size_t i = 0; i < threads * oversampling; ++i)
+                samples.push_back(entries[i * size / (threads * oversampling)]);
+            std::sort(samples.begin(), samples.end());
+            std::vector<entry> splitters;
+            splitters.reserve(threads - 1);
+            for (uint bucket = 1; bucket < threads; ++bucket)
+                splitters.push_back(samples[bucket * oversampling]);
+
+            std::vector<uint> bucket_of(size);
+            std::vector<std::vector<size_t>> counts(threads, std::vector<size_t>(threads, 0));
+            parallel_for(threads, [&](uint part)
+            {
+                std::vector<size_t>& count = counts[part];
+                for (size_t i = part_begin(size, threads, part); i < part_begin(size, threads, part + 1); ++i)
+                {
+                    const uint bucket = static_cast<uint>(
+                        std::upper_bound(splitters.begin(), splitters.end(), entries[i]) - splitters.begin());
+                    bucket_of[i] = bucket;
+                    ++count[bucket];
+                }
+            });
+
+            // смещения каждой части внутри каждой корзины
+            std::vector<size_t> bucket_begin(threads + 1, 0);
+            std::vector<std::vector<size_t>> offsets(threads, std::vector<size_t>(threads, 0));
+            size_t position = 0;
+            for (uint bucket = 0; bucket < threads; ++bucket)
+            {
+                bucket_begin[bucket] = position;
+                for (uint part = 0; part < threads; ++part)
+                {
+                    offsets[part][bucket] = position;
+                    position += counts[part][bucket];
+                }
+            }
+            bucket_begin[threads] = position;
+
+            std::vector<entry> sorted(size);
+            parallel_for(threads, [&](uint part)
+            {
+                std::vector<size_t>& offset = offsets[part];
+                for (size_t i = part_begin(size, threads, part); i < part_begin(size, threads, part + 1); ++i)
+                    sorted[offset[bucket_of[i]]++] = entries[i];
+            });
+            parallel_for(threads, [&](uint bucket)
+            {
+                std::sort(sorted.begin() + bucket_begin[bucket], sorted.begin() + bucket_begin[bucket + 1]);
+            });
+            entries.swap(sorted);
+        }
+    }
+
+    std::string sort_key(const object& value)
+    {
+        std::string key;
+        append_key(value, key);
+        return key;
+    }
+
+    void sort(std::vector<object>& objects, uint threads)
+    {
+        const size_t size = objects.size();
+        if (size < 2)
+            return;
+        // потоков не больше ядер и не больше, чем даёт выборка по размеру массива:
+        // таблицы раскладки по корзинам растут как квадрат числа потоков
+        const uint cores = std::max(1u, std::thread::hardware_concurrency());
+        if (!threads)
+            threads = cores;
+        threads = std::min(threads, cores);
+        threads = static_cast<uint>(std::min<size_t>(threads, std::max<size_t>(size / oversampling, 1)));
+        if (size < parallel_threshold)
+            threads = 1;
+
+        // ключи каждой части копятся в своём буфере
+        std::vector<std::string> arenas(threads);
+        std::vector<entry> entries(size);
+        parallel_for(threads, [&](uint part)
+        {
+            std::string& arena = arenas[part];
+            const size_t begin = part_begin(size, threads, part);
+            const size_t end = part_begin(size, threads, part + 1);
+            std::vector<size_t> offsets;
+            offsets.reserve(end - begin + 1);
+            for (size_t i = begin; i < end; ++i)
+            {
+                offsets.push_back(arena.size());
+                append_key(objects[i], arena);
+            }
+            offsets.push_back(arena.size());
+            for (size_t i = begin; i < end; ++i)
+            {
+                entry& item = entries[i];
+                item.key = arena.data() + offsets[i - begin];
+                item.length = offsets[i - begin + 1] - offsets[i - begin];
+                item.index = i;
+                item.prefix = 0;
+                for (size_t at = 0; at < sizeof(item.prefix); ++at)
+                {
+                    item.prefix <<= 8;
+                    if (at < item.length)
+                        item.prefix |= static_cast<byte>(item.key[at]);
+                }
+            }
+        });
+
+        if (threads > 1)
+            sample_sort(entries, threads);
+        else
+            std::sort(entries.begin(), entries.end());
+
+        std::vector<object> result;
+        result.reserve(size);
+        for (const entry& item : entries)
+            result.push_back(std::move(objects[item.index]));
+        objects.swap(result);
+
+        // объекты прочих типов в конце упорядочиваются своими операторами
+        auto unordered = std::find_if(entries.begin(), entries.end(),
+            [](const entry& item) { return static_cast<byte>(item.key[0]) == sort_key_unordered; });
+        if (unordered != entries.end())
+            std::stable_sort(objects.begin() + (unordered - entries.begin()), objects.end());
+    }
+}
+
+// Здесь должен быть Unicode
@@ -5,10 +5,27 @@
 #include <dot/test.h>
 #include <dot/object.h>
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <memory>
 #include <deque>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 namespace dot
 {
@@ -16,9 +33,19 @@ namespace dot
     DOT_CLASS_ID(test::suite_fail)
     DOT_CLASS_ID(test::run_fail)
 
+    DOT_REGISTER_CLASS(test::check_fail)
+    DOT_REGISTER_CLASS(test::suite_fail)
+    DOT_REGISTER_CLASS(test::run_fail)
+
     namespace
     {
-        std::deque<test::suite*> run_suites;
+        // наборы регистрируются конструкторами глобальных объектов других единиц трансляции,
+        // при статической сборке раньше глобальных объектов библиотеки
+        std::deque<test::suite*>& run_suites()
+        {
+            static std::deque<test::suite*> suites;
+            return suites;
+        }
         thread_local std::deque<std::unique_ptr<const test::check_fail>> test_fails;
 
         template <typename fail_type, typename... argument_types>
@@ -47,77 +74,661 @@ namespace dot
         std::string my_message;
     };
 
-    void test::run() noexcept
+    namespace
     {
-        std::cout << "Запуск всех тестов...\n" << std::endl;
-        size_t suite_number = run_suites.size();
-        size_t suite_passed = 0;
-        size_t suite_failed = 0;
-        auto interruption_found = std::find_if(run_suites.begin(), run_suites.end(),
-            [&](test::suite* test_suite) -> bool
+        // один запуск набора тестов, заполняется потоком пула,
+        // а выводится потоком запуска строго по порядку
+        struct suite_run
+        {
+            test::suite* target;
+            std::size_t round;
+            bool done;
+            bool skipped;
+            bool passed;
+            bool interrupt;
+            std::string label;
+            std::string report;
+            std::uint64_t wall;
+            std::uint64_t cpu;
+            trace::counters::values counters;
+        };
+
+        // суммарное время и счётчики всех повторов набора
+        struct suite_time
+        {
+            const char* name;
+            std::uint64_t wall;
+            std::uint64_t cpu;
+            trace::counters::values counters;
+        };
+
+        // процессорное время текущего потока в наносекундах
+        std::uint64_t thread_cpu_time() noexcept
+        {
+#ifdef _WIN32
+            FILETIME creation, exit, kernel, user;
+            if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+                return 0;
+            const std::uint64_t ticks =
+                (static_cast<std::uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) +
+                (static_cast<std::uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+            return ticks * 100;
+#else
+            timespec time;
+            if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time))
+                return 0;
+            return static_cast<std::uint64_t>(time.tv_sec) * 1000000000u + static_cast<std::uint64_t>(time.tv_nsec);
+#endif
+        }
+
+        // запуск набора в текущем потоке, сбои набора копятся в его test_fails,
+        // аппаратные счётчики открываются в потоке набора и считают только его
+        void execute(suite_run& current, bool counters) noexcept
+        {
+            std::unique_ptr<trace::counters> group(counters ? new trace::counters() : nullptr);
+            if (group)
+                group->start();
+            const std::uint64_t wall_start = trace::now();
+            const std::uint64_t cpu_start = thread_cpu_time();
+            try
             {
-                bool interrupt = false;
-                try
-                {
-                    std::cout << " -> Запуск набора тестов \"" << test_suite->name() << "\" ... ";
-                    test_suite->run();
-                }
-                catch (test::run_fail&)
-                {
-                    interrupt = true;
-                }
-                catch (test::suite_fail&)
+                current.target->run();
+            }
+            catch (test::run_fail&)
+            {
+                current.interrupt = true;
+            }
+            catch (test::suite_fail&)
+            {
+            }
+            catch (fail::error& unhandled)
+            {
+                test::output out;
+                out.print("Прервано ошибкой " DOT_TEST_OUTPUT_ANY ": " DOT_TEST_OUTPUT_ANY,
+                    unhandled.label(), unhandled.what());
+                register_fail<test::suite_fail>(out.message(), unhandled.backtrace());
+            }
+            catch (std::exception& unhandled)
+            {
+                test::output out;
+                out.print("Прервано исключением: " DOT_TEST_OUTPUT_ANY,
+                    unhandled.what());
+                register_fail<test::suite_fail>(out.message());
+            }
+            catch (...)
+            {
+                register_fail<test::suite_fail>(
+                    "Прервано нестандартным исключением.");
+            }
+            current.cpu = thread_cpu_time() - cpu_start;
+            current.wall = trace::now() - wall_start;
+            if (group)
+                current.counters = group->stop();
+            current.passed = test_fails.empty();
+            if (!current.passed)
+            {
+                current.label = test_fails.back()->label();
+                std::stringstream report;
+                std::for_each(test_fails.begin(), test_fails.end(),
+                    [&](const std::unique_ptr<const test::check_fail>& fail)
+                    {
+                        report << *fail;
+                    }
+                );
+                current.report = report.str();
+                test_fails.clear();
+            }
+        }
+
+        // набор подряд loops раз с суммой времени и счётчиков до первого сбоя,
+        // в round остаётся число выполненных прогонов
+        void execute_loop(suite_run& current, bool counters, std::size_t loops) noexcept
+        {
+            std::uint64_t wall = 0;
+            std::uint64_t cpu = 0;
+            trace::counters::values total;
+            std::size_t done = 0;
+            while (done < loops)
+            {
+                execute(current, counters);
+                wall += current.wall;
+                cpu += current.cpu;
+                if (!done)
+                    total = current.counters;
+                else
+                    total += current.counters;
+                ++done;
+                if (!current.passed || current.interrupt)
+                    break;
+            }
+            current.round = done;
+            current.wall = wall;
+            current.cpu = cpu;
+            current.counters = total;
+        }
+
+        // шаблон имени с * на любую часть и ? на любой символ
+        bool matches(const char* pattern, const char* pattern_end, const char* name) noexcept
+        {
+            const char* star = nullptr;
+            const char* resume = name;
+            while (*name)
+            {
+                if (pattern != pattern_end && (*pattern == '?' || *pattern == *name))
                 {
+                    ++pattern;
+                    ++name;
                 }
-                catch (fail::error& unhandled)
+                else if (pattern != pattern_end && *pattern == '*')
                 {
-                    output out;
-                    out.print("Прервано ошибкой " DOT_TEST_OUTPUT_ANY ": " DOT_TEST_OUTPUT_ANY,
-                        unhandled.label(), unhandled.what());
-                    register_fail<test::suite_fail>(out.message(), unhandled.backtrace());
+                    star = pattern++;
+                    resume = name;
                 }
-                catch (std::exception& unhandled)
+                else if (star)
                 {
-                    output out;
-                    out.print("Прервано исключением: " DOT_TEST_OUTPUT_ANY,
-                        unhandled.what());
-                    register_fail<test::suite_fail>(out.message());
+                    pattern = star + 1;
+                    name = ++resume;
                 }
-                catch (...)
+                else
+                    return false;
+            }
+            while (pattern != pattern_end && *pattern == '*')
+                ++pattern;
+            return pattern == pattern_end;
+        }
+
+        // строка JSON с экранированием кавычек, обратной косой черты и управляющих символов
+        void write_json(std::ostream& stream, const std::string& text)
+        {
+            stream << '"';
+            for (const char symbol : text)
+            {
+                switch (symbol)
                 {
-                    register_fail<test::suite_fail>(
-                        "Прервано нестандартным исключением.");
+                case '"': stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                case '\n': stream << "\\n"; break;
+                case '\r': stream << "\\r"; break;
+                case '\t': stream << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(symbol) < 0x20)
+                        stream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                            << static_cast<int>(symbol) << std::dec << std::setfill(' ');
+                    else
+                        stream << symbol;
                 }
-                if (test_fails.empty())
+            }
+            stream << '"';
+        }
+
+        // поле JSON только для собранного значения счётчика
+        template <typename value_type>
+        void write_counter(std::ostream& stream, const char* name, value_type value)
+        {
+            if (value >= 0)
+                stream << ", \"" << name << "\": " << value;
+        }
+
+        // отчёт о запусках наборов в порядке выполнения и о замерах
+        bool write_report(const test::settings& options, const std::deque<suite_run>& runs,
+            const std::vector<test::benchmark::measurement>& measurements,
+            unsigned seed, std::size_t jobs, std::uint64_t wall, bool passed)
+        {
+            std::ofstream file(options.report);
+            if (!file)
+                return false;
+            file << std::setprecision(9);
+            file << "{\n  \"passed\": " << (passed ? "true" : "false")
+                << ",\n  \"jobs\": " << jobs
+                << ",\n  \"wall_ns\": " << wall;
+            if (options.shuffle)
+                file << ",\n  \"seed\": " << seed;
+            if (options.loop)
+                file << ",\n  \"loop\": " << options.loop;
+            file << ",\n  \"suites\": [";
+            bool first = true;
+            for (const suite_run& current : runs)
+            {
+                if (!current.done)
+                    continue;
+                file << (first ? "\n" : ",\n") << "    { \"name\": ";
+                first = false;
+                write_json(file, current.target->name());
+                file << ", \"" << (options.loop ? "loops" : "round") << "\": " << current.round
+                    << ", \"passed\": " << (current.skipped || current.passed ? "true" : "false")
+                    << ", \"skipped\": " << (current.skipped ? "true" : "false")
+                    << ", \"wall_ns\": " << current.wall
+                    << ", \"cpu_ns\": " << current.cpu;
+                write_counter(file, "cycles", current.counters.cycles);
+                write_counter(file, "instructions", current.counters.instructions);
+                write_counter(file, "cache_misses", current.counters.cache_misses);
+                write_counter(file, "branch_misses", current.counters.branch_misses);
+                if (!current.passed && !current.skipped)
                 {
-                    ++suite_passed;
-                    std::cout << "Успешно!" << std::endl;
+                    file << ", \"failure\": ";
+                    write_json(file, current.report);
                 }
-                else
+                file << " }";
+            }
+            file << "\n  ],\n  \"benchmarks\": [";
+            first = true;
+            for (const test::benchmark::measurement& current : measurements)
+            {
+                file << (first ? "\n" : ",\n") << "    { \"name\": ";
+                first = false;
+                write_json(file, current.name);
+                file << ", \"iterations\": " << current.iterations
+                    << ", \"ns_per_op\": " << current.nanoseconds
+                    << ", \"stddev_ns\": " << current.deviation
+                    << ", \"fastest_ns\": " << current.fastest
+                    << ", \"ops_per_second\": " << current.per_second;
+                write_counter(file, "allocations_per_op", current.allocations);
+                write_counter(file, "cycles_per_op", current.cycles);
+                write_counter(file, "instructions_per_op", current.instructions);
+                write_counter(file, "cache_misses_per_op", current.cache_misses);
+                write_counter(file, "branch_misses_per_op", current.branch_misses);
+                file << " }";
+            }
+            file << "\n  ]\n}\n";
+            return static_cast<bool>(file);
+        }
+
+        std::size_t parse_count(const char* text, std::size_t fallback) noexcept
+        {
+            char* end = nullptr;
+            const unsigned long long value = std::strtoull(text, &end, 10);
+            return end != text && !*end ? static_cast<std::size_t>(value) : fallback;
+        }
+    }
+
+    void test::run() noexcept
+    {
+        run(settings());
+    }
+
+    bool test::run(const settings& options) noexcept
+    {
+        // в цикле каждый набор идёт один раз, но подряд loop прогонов
+        const std::size_t repeat = options.loop ? 1 : options.repeat ? options.repeat : 1;
+        std::deque<suite_run> runs;
+        for (test::suite* test_suite : run_suites())
+            if (options.selects(test_suite->name()))
+                for (std::size_t round = 1; round <= repeat; ++round)
+                    runs.push_back(suite_run{ test_suite, round, false, false, false, false, {}, {}, 0, 0, {} });
+
+        unsigned seed = options.seed;
+        if (options.shuffle)
+        {
+            if (!seed)
+                seed = static_cast<unsigned>(trace::now() % 1000000000u) | 1u;
+            std::shuffle(runs.begin(), runs.end(), std::mt19937(seed));
+        }
+        if (!runs.empty())
+        {
+            std::cout << "Запуск " << (options.filter ? "отобранных" : "всех") << " тестов";
+            if (options.shuffle)
+                std::cout << " в случайном порядке (--seed " << seed << ")";
+            std::cout << "...\n" << std::endl;
+        }
+
+        const bool counters = options.counters && trace::counters::supported();
+        std::size_t jobs = options.loop ? 1 : options.jobs ? options.jobs : std::thread::hardware_concurrency();
+        jobs = std::max<std::size_t>(1, std::min(jobs, runs.size()));
+
+        // пул разбирает запуски по порядку, после прерывания пропускаются лишь запуски
+        // дальше прервавшего, начатые до него идут до конца и выводятся как обычно;
+        // исключительный набор ждёт завершения идущих и не даёт начать следующие
+        std::mutex done_mutex;
+        std::condition_variable done_signal;
+        std::size_t next_run = 0;
+        std::size_t active_runs = 0;
+        bool exclusive_run = false;
+        std::size_t interrupted_at = runs.size();
+        std::vector<std::thread> pool;
+        if (jobs > 1)
+        {
+            for (std::size_t job = 0; job < jobs; ++job)
+            {
+                pool.emplace_back([&]
                 {
-                    ++suite_failed;
-                    std::cout << test_fails.back()->label() << std::endl;
-                    std::for_each(test_fails.begin(), test_fails.end(),
-                        [](const std::unique_ptr<const test::check_fail>& fail)
+                    std::unique_lock<std::mutex> lock(done_mutex);
+                    for (;;)
+                    {
+                        done_signal.wait(lock, [&] { return !exclusive_run; });
+                        if (next_run >= runs.size())
+                            break;
+                        const std::size_t index = next_run++;
+                        suite_run& current = runs[index];
+                        const bool exclusive = current.target->exclusive();
+                        if (exclusive)
                         {
-                            std::cout << *fail;
+                            exclusive_run = true;
+                            done_signal.wait(lock, [&] { return !active_runs; });
                         }
-                    );
-                    test_fails.clear();
+                        const bool skip = index > interrupted_at;
+                        ++active_runs;
+                        lock.unlock();
+                        if (skip)
+                            current.skipped = true;
+                        else
+                            execute(current, counters);
+                        lock.lock();
+                        if (current.interrupt)
+                            interrupted_at = std::min(interrupted_at, index);
+                        --active_runs;
+                        if (exclusive)
+                            exclusive_run = false;
+                        current.done = true;
+                        done_signal.notify_all();
+                    }
+                });
+            }
+        }
+
+        const std::uint64_t run_start = trace::now();
+        std::size_t suite_passed = 0;
+        std::size_t suite_failed = 0;
+        std::size_t suite_skipped = 0;
+        bool interrupted = false;
+        for (suite_run& current : runs)
+        {
+            if (options.loop)
+                std::cout << " -> Цикл набора тестов \"" << current.target->name() << "\" [" << options.loop << "] ";
+            else
+                std::cout << " -> Запуск набора тестов \"" << current.target->name() << "\" ";
+            if (repeat > 1)
+                std::cout << "[" << current.round << "/" << repeat << "] ";
+            std::cout << "... " << std::flush;
+            if (jobs > 1)
+            {
+                std::unique_lock<std::mutex> lock(done_mutex);
+                done_signal.wait(lock, [&] { return current.done; });
+            }
+            else
+            {
+                if (options.loop)
+                    execute_loop(current, counters, options.loop);
+                else
+                    execute(current, counters);
+                current.done = true;
+            }
+            if (current.skipped)
+            {
+                ++suite_skipped;
+                std::cout << "Пропущен" << std::endl;
+            }
+            else if (current.passed)
+            {
+                ++suite_passed;
+                std::cout << "Успешно!";
+                if (options.loop)
+                    std::cout << " (" << current.wall / 1e3 / current.round << " мкс на прогон)";
+                std::cout << std::endl;
+            }
+            else
+            {
+                ++suite_failed;
+                std::cout << current.label << std::endl << current.report;
+            }
+            if (current.interrupt)
+            {
+                // запуски после прервавшего не выводятся и считаются пропущенными
+                suite_skipped = runs.size() - suite_passed - suite_failed;
+                interrupted = true;
+                break;
+            }
+        }
+        for (std::thread& worker : pool)
+            worker.join();
+        const std::uint64_t run_wall = trace::now() - run_start;
+
+        // самые медленные наборы по сумме времени всех повторов,
+        // повторы одного набора при --shuffle и в пуле идут не подряд
+        std::vector<suite_time> times;
+        std::unordered_map<const test::suite*, std::size_t> time_index;
+        for (const suite_run& current : runs)
+        {
+            if (!current.done || current.skipped)
+                continue;
+            const auto found = time_index.emplace(current.target, times.size());
+            if (found.second)
+                times.push_back(suite_time{ current.target->name(), 0, 0, current.counters });
+            else
+                times[found.first->second].counters += current.counters;
+            suite_time& time = times[found.first->second];
+            time.wall += current.wall;
+            time.cpu += current.cpu;
+        }
+        std::stable_sort(times.begin(), times.end(),
+            [](const suite_time& left, const suite_time& right) { return left.wall > right.wall; });
+        if (times.size() > options.slowest)
+            times.resize(options.slowest);
+        if (!times.empty())
+        {
+            const std::ios::fmtflags flags = std::cout.flags();
+            const std::streamsize precision = std::cout.precision();
+            std::cout << "\n -- Самые медленные наборы тестов (мс, время / процессор"
+                << (counters ? "; IPC, промахов кэша и ошибок переходов в тысячах" : "") << "):\n"
+                << std::fixed << std::setprecision(3);
+            for (const suite_time& time : times)
+            {
+                std::cout << std::setw(12) << time.wall / 1e6
+                    << std::setw(12) << time.cpu / 1e6;
+                if (counters)
+                {
+                    const trace::counters::values& values = time.counters;
+                    std::cout << std::setprecision(2) << std::setw(8) << values.ipc()
+                        << std::setprecision(1)
+                        << std::setw(12) << (values.cache_misses >= 0 ? values.cache_misses / 1e3 : -1.0)
+                        << std::setw(12) << (values.branch_misses >= 0 ? values.branch_misses / 1e3 : -1.0)
+                        << std::setprecision(3);
                 }
-                return interrupt;
+                std::cout << "   " << time.name << "\n";
+            }
+            if (options.counters && !counters)
+                std::cout << " -- Аппаратные счётчики недоступны\n";
+            std::cout << " -- Время запуска: " << run_wall / 1e6 << " мс, потоков: " << jobs << std::endl;
+            std::cout.flags(flags);
+            std::cout.precision(precision);
+        }
+
+        // замеры идут после наборов в одном потоке, без помех от пула
+        std::size_t regressions = 0;
+        std::vector<benchmark::measurement> measurements;
+        if (options.benchmarks && !interrupted)
+        {
+            try
+            {
+                regressions = benchmark::run_all(options, &measurements);
+            }
+            catch (std::exception& unhandled)
+            {
+                ++regressions;
+                std::cout << " -- Замеры прерваны исключением: " << unhandled.what() << std::endl;
             }
-        );
-        std::cout << "\n -- Запуск тестов " << (suite_failed ? "провален!" : "успешен.");
-        std::cout << " (Всего: " << suite_number
+        }
+
+        const bool failed = suite_failed || regressions;
+        std::cout << "\n -- Запуск тестов " << (failed ? "провален!" : "успешен.");
+        std::cout << " (Всего: " << runs.size()
             << "; Успешно: "     << suite_passed
-            << "; Провалено: "   << suite_failed
-            << ")" << std::endl;
+            << "; Провалено: "   << suite_failed;
+        if (suite_skipped)
+            std::cout << "; Пропущено: " << suite_skipped;
+        if (options.benchmarks)
+            std::cout << "; Регрессий замеров: " << regressions;
+        std::cout << ")" << std::endl;
+
+        if (options.report)
+        {
+            bool written = false;
+            try
+            {
+                written = write_report(options, runs, measurements, seed, jobs, run_wall, !failed);
+            }
+            catch (std::exception&)
+            {
+            }
+            if (!written)
+                std::cout << " -- Не удалось записать отчёт в " << options.report << std::endl;
+        }
+        return !failed;
+    }
+
+    int test::main(int argc, const char* const argv[])
+    {
+        return main(argc, argv, settings());
+    }
+
+    int test::main(int argc, const char* const argv[], const settings& defaults)
+    {
+#ifdef _WIN32
+        SetConsoleOutputCP(CP_UTF8);
+#endif
+        const settings options = settings::parse(argc, argv, defaults);
+        if (!options.valid || options.help)
+        {
+            settings::usage(options.valid ? std::cout : std::cerr);
+            return options.valid ? 0 : 2;
+        }
+        if (options.list)
+        {
+            for (const test::suite* test_suite : run_suites())
+                if (options.selects(test_suite->name()))
+                    std::cout << test_suite->name() << "\n";
+            if (options.benchmarks)
+                for (const char* name : benchmark::names())
+                    if (options.selects(name))
+                        std::cout << name << "\n";
+            std::cout << std::flush;
+            return 0;
+        }
+        const bool passed = run(options);
+        if (options.pause)
+        {
+            std::cout << "\n < Нажмите Enter > ... " << std::flush;
+            std::cin.get();
+        }
+        return passed ? 0 : 1;
+    }
+
+    bool test::settings::selects(const char* name) const noexcept
+    {
+        if (!filter || !*filter)
+            return true;
+        const char* pattern = filter;
+        for (;;)
+        {
+            const char* pattern_end = std::strchr(pattern, ',');
+            if (!pattern_end)
+                pattern_end = pattern + std::strlen(pattern);
+            if (std::find_if(pattern, pattern_end, [](char symbol) { return symbol == '*' || symbol == '?'; }) != pattern_end)
+            {
+                if (matches(pattern, pattern_end, name))
+                    return true;
+            }
+            else if (pattern != pattern_end && std::search(name, name + std::strlen(name), pattern, pattern_end) != name + std::strlen(name))
+                return true;
+            if (!*pattern_end)
+                return false;
+            pattern = pattern_end + 1;
+        }
+    }
+
+    void test::settings::usage(std::ostream& stream)
+    {
+        stream << "Аргументы запуска тестов:\n"
+            "  --filter PATTERN      наборы и замеры по шаблону с * и ? или части имени, через запятую\n"
+            "  --list                вывести имена отобранных наборов, с --bench и замеров\n"
+            "  --jobs N, -j N        потоков пула, 0 - по числу процессоров\n"
+            "  --repeat N            повторов каждого набора\n"
+            "  --shuffle             случайный порядок запусков, --seed N для повторения порядка\n"
+            "  --loop N              каждый набор подряд N раз в одном потоке, например под perf record\n"
+            "  --slowest N           сколько самых медленных наборов вывести\n"
+            "  --json FILE           отчёт о наборах и замерах в формате JSON\n"
+            "  --counters            аппаратные счётчики perf_event_open\n"
+            "  --bench               замеры DOT_BENCHMARK после наборов\n"
+            "  --bench-time MS       время каждого замера\n"
+            "  --baseline FILE       сравнение замеров с базой, --threshold P допустимое замедление\n"
+            "  --save-baseline FILE  сохранение замеров как базы\n"
+            "  --pause               ожидание Enter после запуска\n"
+            "  --help                эта справка\n";
+    }
+
+    test::settings test::settings::parse(int argc, const char* const argv[])
+    {
+        return parse(argc, argv, settings());
+    }
+
+    test::settings test::settings::parse(int argc, const char* const argv[], const settings& defaults)
+    {
+        settings result = defaults;
+        for (int index = 1; index < argc; ++index)
+        {
+            const std::string option = argv[index];
+            bool* flag = option == "--bench" ? &result.benchmarks
+                : option == "--counters" ? &result.counters
+                : option == "--shuffle" ? &result.shuffle
+                : option == "--list" ? &result.list
+                : option == "--help" || option == "-h" ? &result.help
+                : option == "--pause" ? &result.pause
+                : nullptr;
+            if (flag)
+            {
+                *flag = true;
+                continue;
+            }
+            const bool has_value = index + 1 < argc;
+            const char* value = has_value ? argv[index + 1] : "";
+            if (option == "--jobs" || option == "-j")
+                result.jobs = parse_count(value, result.jobs);
+            else if (option == "--repeat")
+                result.repeat = parse_count(value, result.repeat);
+            else if (option == "--slowest")
+                result.slowest = parse_count(value, result.slowest);
+            else if (option == "--bench-time")
+                result.bench_time = std::chrono::milliseconds(parse_count(value, static_cast<std::size_t>(result.bench_time.count())));
+            else if (option == "--baseline")
+                result.baseline = value;
+            else if (option == "--save-baseline")
+                result.save_baseline = value;
+            else if (option == "--threshold")
+                result.threshold = std::strtod(value, nullptr);
+            else if (option == "--filter")
+                result.filter = value;
+            else if (option == "--seed")
+            {
+                result.shuffle = true;
+                result.seed = static_cast<unsigned>(parse_count(value, result.seed));
+            }
+            else if (option == "--loop")
+                result.loop = parse_count(value, result.loop);
+            else if (option == "--json")
+                result.report = value;
+            else
+            {
+                std::cerr << "Неизвестный аргумент запуска тестов: " << option << std::endl;
+                result.valid = false;
+                continue;
+            }
+            if (!has_value)
+            {
+                std::cerr << "Нет значения аргумента запуска тестов: " << option << std::endl;
+                result.valid = false;
+            }
+            ++index;
+        }
+        return result;
     }
 
     test::suite::suite() noexcept
     {
-        run_suites.push_back(this);
+        run_suites().push_back(this);
+    }
+
+    bool test::suite::exclusive() const noexcept
+    {
+        return false;
     }
 
     test::check_fail::check_fail(const char* message) noexcept
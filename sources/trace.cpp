@@ -1,38 +1,94 @@
 // Трассировка по вложенным скоупам для бэктрейса ошибок
 
 #include <dot/trace.h>
+#include <dot/recorder.h>
+#include <dot/profile.h>
 #include <iostream>
 #include <utility>
 #include <string>
-#include <stack>
-
-#ifdef _WIN32
-#define DOT_TESTS_PATH "\\dot\\tests\\"
-#else
-#define DOT_TESTS_PATH "/dot/tests/"
-#endif
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <algorithm>
 
 namespace dot
 {
-    class trace::stack::entry
+    // кадр стека ссылается на литералы и на кадр вызывающего скоупа,
+    // пока на кадр ссылаются снимки стека он не изменяется
+    class trace::stack::frame
     {
     public:
-        entry(const char* name, const char* file, int line) noexcept
-            : my_name(name), my_file(file), my_line(line) { }
+        frame(const char* name, const char* file, int line, frame* parent) noexcept
+            : my_name(name), my_file(file), my_line(line), my_parent(parent), my_bound(1) { }
+
+        // заполнение кадра стека потока, используемого повторно
+        void reset(const char* name, const char* file, int line, frame* parent) noexcept
+        {
+            my_name = name;
+            my_file = file;
+            my_line = line;
+            my_parent = parent;
+            my_bound.store(1, std::memory_order_relaxed);
+        }
 
-        const char* get_name() const noexcept { return my_name.c_str(); }
-        const char* get_file() const noexcept { return my_file.c_str(); }
+        const char* get_name() const noexcept { return my_name; }
+        const char* get_file() const noexcept { return my_file; }
         int get_line() const noexcept { return my_line; }
+        frame* get_parent() const noexcept { return my_parent; }
+
+        bool unique() const noexcept { return my_bound.load(std::memory_order_acquire) == 1; }
+
+        static void retain(frame* target) noexcept
+        {
+            if (target)
+                target->my_bound.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // освобождение кадра вместе с хвостом, на который больше никто не ссылается
+        static void release(frame* target) noexcept
+        {
+            while (target && target->my_bound.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                frame* parent = target->my_parent;
+                delete target;
+                target = parent;
+            }
+        }
 
     private:
-        std::string my_name;
-        std::string my_file;
+        const char* my_name;
+        const char* my_file;
         int my_line;
+        frame* my_parent;
+
+        // ссылки на кадр: снимки стека, отцепленные дочерние кадры и сам стек
+        std::atomic<std::size_t> my_bound;
     };
 
+    // стек потока владеет кадрами по глубине и заполняет их повторно,
+    // его кадры не ссылаются на родителя счётчиком, ведь родитель живёт дольше;
+    // когда кадр со снимком удаляется из стека потока, он отцепляется
+    // и начинает ссылаться на родителя, а на его место заводится новый кадр;
+    // копии стека ссылаются счётчиком на все кадры и изменяются как обычный список
     class trace::stack::instance
     {
     public:
+        instance() noexcept = default;
+        ~instance() noexcept;
+
+        instance(const instance& another) noexcept;
+        instance& operator = (const instance& another) noexcept;
+
+        instance(instance&& temporary) noexcept;
+        instance& operator = (instance&& temporary) noexcept;
+
+        // копия стека по вершине, ссылка на вершину переходит к копии
+        instance(frame* top, std::size_t depth) noexcept;
+
+        // стек потока с заранее выделенными местами под кадры
+        static instance* live();
+
         void push(const char* name, const char* file, int line) noexcept;
         void pop() noexcept;
 
@@ -41,33 +97,206 @@ namespace dot
         int top_line() const noexcept;
 
         bool empty() const noexcept;
+        std::size_t depth() const noexcept;
+        const frame* top_frame() const noexcept;
+        frame* top_frame() noexcept { return my_top; }
 
         void set_message(const char* message) noexcept;
         const std::string& get_message() const noexcept;
 
+        // чтение копии кадров стека потока из другого потока,
+        // false если поток всё время менял стек во время чтения
+        bool observe(std::vector<observed>& frames) const;
+
+        // стеки всех живых потоков под общим мьютексом
+        static std::mutex& registry_mutex();
+        static std::vector<instance*>& registry();
+
+        std::size_t get_thread() const noexcept { return my_thread; }
+
     private:
-        static const entry global;
-        std::stack<entry> my_stack;
+        static const frame global;
+
+        // копия кадров стека потока для чтения из других потоков:
+        // запись окружается нечётным номером версии, и читатель,
+        // увидевший разные или нечётные версии до и после чтения, читает заново
+        struct watched
+        {
+            std::atomic<const char*> name;
+            std::atomic<const char*> file;
+            std::atomic<int> line;
+            std::atomic<std::size_t> serial;
+        };
+
+        // кадры не глубже capacity, более глубокие скоупы только считаются
+        frame* my_top = nullptr;
+        std::size_t my_depth = 0;
         std::string my_message;
 
-        const entry& top() const noexcept;
+        // места под кадры стека потока, у копий стека пусто
+        std::vector<frame*> my_slots;
+
+        // копия кадров и номер потока в реестре, только у стека потока
+        std::unique_ptr<watched[]> my_watched;
+        std::atomic<std::size_t> my_version{ 0 };
+        std::atomic<std::size_t> my_watched_depth{ 0 };
+        std::size_t my_thread = 0;
+
+        const frame& top() const noexcept;
+        void clear() noexcept;
     };
 
-    const trace::stack::entry trace::stack::instance::global("global", "", 0);
+    const trace::stack::frame trace::stack::instance::global("global", "", 0, nullptr);
+
+    trace::stack::instance::~instance() noexcept
+    {
+        clear();
+    }
+
+    trace::stack::instance::instance(const instance& another) noexcept
+        : my_top(another.my_top), my_depth(another.my_depth), my_message(another.my_message)
+    {
+        frame::retain(my_top);
+    }
+
+    trace::stack::instance& trace::stack::instance::operator = (const instance& another) noexcept
+    {
+        if (this != &another)
+        {
+            frame::retain(another.my_top);
+            clear();
+            my_top = another.my_top;
+            my_depth = another.my_depth;
+            my_message = another.my_message;
+        }
+        return *this;
+    }
+
+    trace::stack::instance::instance(instance&& temporary) noexcept
+        : instance(static_cast<const instance&>(temporary))
+    {
+        if (temporary.my_slots.empty())
+        {
+            temporary.clear();
+            my_message = std::move(temporary.my_message);
+        }
+    }
+
+    trace::stack::instance& trace::stack::instance::operator = (instance&& temporary) noexcept
+    {
+        *this = static_cast<const instance&>(temporary);
+        if (this != &temporary && temporary.my_slots.empty())
+            temporary.clear();
+        return *this;
+    }
+
+    trace::stack::instance::instance(frame* top, std::size_t depth) noexcept
+        : my_top(top), my_depth(depth)
+    {
+    }
 
-    const trace::stack::entry& trace::stack::instance::top() const noexcept
+    trace::stack::instance* trace::stack::instance::live()
     {
-        return my_stack.empty() ? global : my_stack.top();
+        std::unique_ptr<instance> result(new instance());
+        result->my_slots.resize(capacity, nullptr);
+        result->my_watched.reset(new watched[capacity]);
+        static std::size_t last_thread = 0;
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        result->my_thread = ++last_thread;
+        registry().push_back(result.get());
+        return result.release();
     }
 
-    void trace::stack::instance::push(const char* name, const char* file, int line) noexcept
+    // реестр не удаляется при выходе, потоки могут завершаться позже статических объектов
+    std::mutex& trace::stack::instance::registry_mutex()
     {
-        my_stack.push(entry(name, file, line));
+        static std::mutex* mutex = new std::mutex();
+        return *mutex;
     }
 
-    void trace::stack::instance::pop() noexcept
+    std::vector<trace::stack::instance*>& trace::stack::instance::registry()
     {
-        my_stack.pop();
+        static std::vector<instance*>* instances = new std::vector<instance*>();
+        return *instances;
+    }
+
+    void trace::stack::instance::clear() noexcept
+    {
+        if (my_slots.empty())
+        {
+            frame::release(my_top);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                std::vector<instance*>& instances = registry();
+                instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+            }
+            while (my_depth)
+                pop();
+            for (frame* slot : my_slots)
+                delete slot;
+            my_slots.clear();
+        }
+        my_top = nullptr;
+        my_depth = 0;
+    }
+
+    inline const trace::stack::frame& trace::stack::instance::top() const noexcept
+    {
+        return my_top ? *my_top : global;
+    }
+
+    inline void trace::stack::instance::push(const char* name, const char* file, int line) noexcept
+    {
+        if (my_depth++ >= capacity)
+            return;
+        if (my_slots.empty())
+        {
+            // ссылка стека на прежнюю вершину переходит к новому кадру
+            my_top = new frame(name, file, line, my_top);
+            return;
+        }
+        frame*& slot = my_slots[my_depth - 1];
+        if (slot)
+            slot->reset(name, file, line, my_top);
+        else
+            slot = new frame(name, file, line, my_top);
+        // обработчик сигнала в этом потоке должен видеть кадр заполненным до смены вершины
+        std::atomic_signal_fence(std::memory_order_release);
+        my_top = slot;
+        const std::size_t version = my_version.load(std::memory_order_relaxed);
+        my_version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        watched& entry = my_watched[my_depth - 1];
+        entry.name.store(name, std::memory_order_relaxed);
+        entry.file.store(file, std::memory_order_relaxed);
+        entry.line.store(line, std::memory_order_relaxed);
+        entry.serial.store(version + 2, std::memory_order_relaxed);
+        my_watched_depth.store(my_depth, std::memory_order_relaxed);
+        my_version.store(version + 2, std::memory_order_release);
+    }
+
+    inline void trace::stack::instance::pop() noexcept
+    {
+        if (!my_depth || --my_depth >= capacity)
+            return;
+        frame* target = my_top;
+        my_top = target->get_parent();
+        // и не видеть удалённый кадр вершиной стека
+        std::atomic_signal_fence(std::memory_order_release);
+        if (!my_slots.empty())
+        {
+            // кадры ниже вершины не меняются, поэтому версия не нужна
+            my_watched_depth.store(my_depth, std::memory_order_release);
+            // на кадр никто кроме стека потока не ссылается, он будет заполнен повторно
+            if (target->unique())
+                return;
+            my_slots[my_depth] = nullptr;
+        }
+        frame::retain(my_top);
+        frame::release(target);
     }
 
     const char* trace::stack::instance::top_name() const noexcept
@@ -85,9 +314,45 @@ namespace dot
         return top().get_line();
     }
 
-    bool trace::stack::instance::empty() const noexcept
+    inline bool trace::stack::instance::empty() const noexcept
+    {
+        return !my_depth;
+    }
+
+    std::size_t trace::stack::instance::depth() const noexcept
     {
-        return my_stack.empty();
+        return my_depth;
+    }
+
+    const trace::stack::frame* trace::stack::instance::top_frame() const noexcept
+    {
+        return my_top;
+    }
+
+    bool trace::stack::instance::observe(std::vector<observed>& frames) const
+    {
+        for (int attempt = 0; attempt < 64; ++attempt)
+        {
+            const std::size_t version = my_version.load(std::memory_order_acquire);
+            if (version & 1)
+                continue;
+            const std::size_t depth = my_watched_depth.load(std::memory_order_acquire);
+            frames.resize(depth);
+            for (std::size_t index = 0; index < depth; ++index)
+            {
+                const watched& entry = my_watched[index];
+                frames[index] = observed{
+                    entry.name.load(std::memory_order_relaxed),
+                    entry.file.load(std::memory_order_relaxed),
+                    entry.line.load(std::memory_order_relaxed),
+                    entry.serial.load(std::memory_order_relaxed)
+                };
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (my_version.load(std::memory_order_relaxed) == version)
+                return true;
+        }
+        return false;
     }
 
     void trace::stack::instance::set_message(const char* message) noexcept
@@ -100,17 +365,106 @@ namespace dot
         return my_message;
     }
 
+    namespace
+    {
+        // указатель на стек потока не требует ленивой инициализации
+        // в отличие от самого стека, поэтому доступ к нему дешевле
+        DOT_FAST_THREAD_LOCAL trace::stack* current_stack = nullptr;
+
+        inline trace::stack& local_stack() noexcept
+        {
+            if (!current_stack)
+                current_stack = &trace::stack::thread_stack();
+            return *current_stack;
+        }
+
+        // период выборки корневых скоупов общий для всех потоков
+        std::atomic<std::size_t> sampling_period(100);
+
+        // сколько корневых скоупов потока осталось пропустить до записи
+        DOT_FAST_THREAD_LOCAL std::size_t sampled_countdown = 0;
+
+        // глубина вложенности выборочных скоупов непопавшего в выборку корня
+        DOT_FAST_THREAD_LOCAL std::size_t skipped_depth = 0;
+    }
+
+    void trace::set_sampling(std::size_t period) noexcept
+    {
+        sampling_period.store(period, std::memory_order_relaxed);
+    }
+
+    std::size_t trace::get_sampling() noexcept
+    {
+        return sampling_period.load(std::memory_order_relaxed);
+    }
+
     trace::scope::scope(const char* name, const char* file, int line) noexcept
     {
-        const char* entry = strstr(file, DOT_TESTS_PATH);
-        if (!entry)
-            entry = file;
-        stack::thread_stack().push(name, entry, line);
+        local_stack().my_instance->push(name, file, line);
+        if (recorder::my_recording.load(std::memory_order_relaxed))
+            recorder::begin(name, file, line);
+        if (profile::my_profiling.load(std::memory_order_relaxed))
+            profile::begin(name, file, line);
+    }
+
+    trace::scope::scope(const char* name, const char* file, int line, std::chrono::nanoseconds budget) noexcept
+    {
+        local_stack().my_instance->push(name, file, line);
+        if (recorder::my_recording.load(std::memory_order_relaxed))
+            recorder::begin(name, file, line);
+        if (profile::my_profiling.load(std::memory_order_relaxed))
+            profile::begin(name, file, line, static_cast<std::uint64_t>(budget.count()));
     }
 
     trace::scope::~scope() noexcept
     {
-        stack::thread_stack().pop();
+        if (profile::my_profiling.load(std::memory_order_relaxed))
+            profile::end();
+        if (recorder::my_recording.load(std::memory_order_relaxed))
+            recorder::end();
+        local_stack().my_instance->pop();
+    }
+
+    trace::sampled_scope::sampled_scope(const char* name, const char* file, int line) noexcept
+    {
+        if (skipped_depth)
+        {
+            ++skipped_depth;
+            return;
+        }
+        trace::stack::instance& stack = *local_stack().my_instance;
+        if (stack.empty())
+        {
+            // обратный отсчёт вместо деления на каждом корневом скоупе
+            const std::size_t period = sampled_countdown ? 0 : sampling_period.load(std::memory_order_relaxed);
+            if (!period)
+            {
+                if (sampled_countdown)
+                    --sampled_countdown;
+                skipped_depth = 1;
+                return;
+            }
+            sampled_countdown = period - 1;
+        }
+        stack.push(name, file, line);
+        if (recorder::my_recording.load(std::memory_order_relaxed))
+            recorder::begin(name, file, line);
+        if (profile::my_profiling.load(std::memory_order_relaxed))
+            profile::begin(name, file, line);
+    }
+
+    trace::sampled_scope::~sampled_scope() noexcept
+    {
+        if (skipped_depth)
+        {
+            --skipped_depth;
+            return;
+        }
+        if (profile::my_profiling.load(std::memory_order_relaxed))
+            profile::end();
+        if (recorder::my_recording.load(std::memory_order_relaxed))
+            recorder::end();
+        local_stack().my_instance->pop();
     }
 
     trace::stack::stack() noexcept
@@ -118,8 +472,16 @@ namespace dot
     {
     }
 
+    trace::stack::stack(instance* source) noexcept
+        : my_instance(source)
+    {
+    }
+
     trace::stack::~stack() noexcept
     {
+        if (current_stack == this)
+            current_stack = nullptr;
+        std::atomic_signal_fence(std::memory_order_release);
         delete my_instance;
     }
 
@@ -157,6 +519,38 @@ namespace dot
         set_message(message);
     }
 
+    trace::stack::stack(const snapshot& source) noexcept
+        : my_instance(new instance(source.my_top, source.my_depth))
+    {
+        frame::retain(source.my_top);
+    }
+
+    trace::stack::snapshot::snapshot() noexcept
+        : my_top(local_stack().my_instance->top_frame()), my_depth(local_stack().depth())
+    {
+        frame::retain(my_top);
+    }
+
+    trace::stack::snapshot::~snapshot() noexcept
+    {
+        frame::release(my_top);
+    }
+
+    trace::stack::snapshot::snapshot(const snapshot& another) noexcept
+        : my_top(another.my_top), my_depth(another.my_depth)
+    {
+        frame::retain(my_top);
+    }
+
+    trace::stack::snapshot& trace::stack::snapshot::operator = (const snapshot& another) noexcept
+    {
+        frame::retain(another.my_top);
+        frame::release(my_top);
+        my_top = another.my_top;
+        my_depth = another.my_depth;
+        return *this;
+    }
+
     void trace::stack::push(const char* name, const char* file, int line) noexcept
     {
         my_instance->push(name, file, line);
@@ -192,6 +586,62 @@ namespace dot
         return !my_instance->empty();
     }
 
+    std::size_t trace::stack::depth() const noexcept
+    {
+        return my_instance->depth();
+    }
+
+    trace::stack::iterator trace::stack::begin() const noexcept
+    {
+        return iterator(my_instance->top_frame());
+    }
+
+    trace::stack::iterator trace::stack::end() const noexcept
+    {
+        return iterator();
+    }
+
+    trace::stack::iterator::iterator(const frame* position) noexcept
+        : my_frame(position)
+    {
+    }
+
+    const char* trace::stack::iterator::name() const noexcept
+    {
+        return my_frame->get_name();
+    }
+
+    const char* trace::stack::iterator::file() const noexcept
+    {
+        return my_frame->get_file();
+    }
+
+    int trace::stack::iterator::line() const noexcept
+    {
+        return my_frame->get_line();
+    }
+
+    const trace::stack::iterator& trace::stack::iterator::operator * () const noexcept
+    {
+        return *this;
+    }
+
+    trace::stack::iterator& trace::stack::iterator::operator ++ () noexcept
+    {
+        my_frame = my_frame->get_parent();
+        return *this;
+    }
+
+    bool trace::stack::iterator::operator == (const iterator& another) const noexcept
+    {
+        return my_frame == another.my_frame;
+    }
+
+    bool trace::stack::iterator::operator != (const iterator& another) const noexcept
+    {
+        return my_frame != another.my_frame;
+    }
+
     void trace::stack::set_message(const char* message) noexcept
     {
         my_instance->set_message(message);
@@ -209,27 +659,47 @@ namespace dot
 
     trace::stack& trace::stack::thread_stack() noexcept
     {
-        static thread_local stack local_stack;
+        static thread_local stack local_stack(instance::live());
+        current_stack = &local_stack;
         return local_stack;
     }
 
+    trace::stack::iterator trace::stack::signal_top() noexcept
+    {
+        const trace::stack* stack = current_stack;
+        return iterator(stack ? stack->my_instance->top_frame() : nullptr);
+    }
+
+    void trace::stack::observe(observer action, void* context)
+    {
+        // обход вызывается вне мьютекса реестра, он может сам заводить стеки потоков
+        std::vector<std::pair<std::size_t, std::vector<observed>>> stacks;
+        {
+            std::lock_guard<std::mutex> lock(instance::registry_mutex());
+            stacks.reserve(instance::registry().size());
+            for (const instance* target : instance::registry())
+            {
+                std::vector<observed> frames;
+                if (target->observe(frames))
+                    stacks.emplace_back(target->get_thread(), std::move(frames));
+            }
+        }
+        for (const auto& stack : stacks)
+            action(context, stack.first, stack.second.data(), stack.second.size());
+    }
+
     std::ostream& operator << (std::ostream& stream, const trace::stack& source)
     {
         if (source.has_message())
         {
             stream << source.get_message() << "\n";
         }
-        if (source.not_empty())
+        for (const trace::stack::iterator& frame : source)
         {
-            for (trace::stack backtrace = source;
-                              backtrace.not_empty();
-                              backtrace.pop())
-            {
-                stream << " >>-> "
-                    << backtrace.top_name() << " в "
-                    << backtrace.top_file() << '('
-                    << backtrace.top_line() << ")\n";
-            }
+            stream << " >>-> "
+                << frame.name() << " в "
+                << frame.file() << '('
+                << frame.line() << ")\n";
         }
         return stream;
     }
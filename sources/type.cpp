@@ -2,7 +2,11 @@
 // идентификатор классов для динамической типизации
 // классы приведения типов вверх по иерархии классов
 
+// короткие частые методы из заголовка определяются здесь без DOT_INLINE_HOT
+#define DOT_TYPE_SOURCE
+
 #include <dot/type.h>
+#include <dot/registry.h>
 #include <dot/fail.h>
 #include <iostream>
 #include <atomic>
@@ -15,28 +19,15 @@ namespace dot
     }
 
     class_id::class_id(const char* const name) noexcept
-        : my_name(name), my_index(++last_class_id)
-    {
-    }
-
-    const char* const class_id::name() const noexcept
-    {
-        return my_name;
-    }
-
-    const uint64 class_id::index() const noexcept
-    {
-        return my_index;
-    }
-
-    bool class_id::operator == (const class_id& another) const noexcept
+        : my_name(name), my_index(++last_class_id), my_info()
     {
-        return my_index == another.my_index;
+        class_registry::add(*this);
     }
 
-    bool class_id::operator != (const class_id& another) const noexcept
+    class_id::class_id(const char* const name, const class_info& info) noexcept
+        : my_name(name), my_index(++last_class_id), my_info(info)
     {
-        return my_index != another.my_index;
+        class_registry::add(*this);
     }
 
     std::ostream& operator << (std::ostream& output, const class_id& identifier)
@@ -44,9 +35,9 @@ namespace dot
         return output << identifier.name();
     }
 
-    void invalid_typecast(const char* to_class_name, const char* from_class_name)
+    void invalid_typecast(const class_id& to_class, const class_id& from_class)
     {
-        throw fail::bad_typecast(class_id(to_class_name), class_id(from_class_name));
+        throw fail::bad_typecast(to_class, from_class);
     }
 }
 
@@ -0,0 +1,185 @@
+// Сторож зависаний: поиск скоупов трассировки, открытых дольше порога
+
+#include <dot/watchdog.h>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dot
+{
+    std::atomic<bool> trace::watchdog::my_watching(false);
+
+    namespace
+    {
+        // скоуп на некоторой глубине стека потока, замеченный сторожем
+        struct seen
+        {
+            std::size_t serial;
+            std::uint64_t since;
+            bool reported;
+        };
+
+        // последние замеченные скоупы потока и номер опроса, в котором поток был жив
+        struct watched_thread
+        {
+            std::vector<seen> frames;
+            std::size_t round = 0;
+        };
+
+        void print_stall(std::size_t thread, const trace::stack& backtrace, std::uint64_t elapsed)
+        {
+            std::cerr << "Поток " << thread << " находится в скоупе уже "
+                << elapsed / 1000000 << " мс:\n" << backtrace;
+        }
+    }
+
+    // сеанс сторожа: фоновый поток опроса стеков и замеченные скоупы потоков
+    class trace::watchdog::session
+    {
+    public:
+        ~session();
+
+        // единственный сеанс на процесс
+        static session& current();
+
+        void start(std::chrono::milliseconds threshold, stall_handler handler);
+        void stop();
+
+    private:
+        std::mutex my_mutex;
+        std::condition_variable my_wakeup;
+        std::thread my_watcher;
+        bool my_stopping = false;
+
+        // данные опроса меняет только поток сторожа
+        std::uint64_t my_threshold = 0;
+        stall_handler my_handler = nullptr;
+        std::map<std::size_t, watched_thread> my_threads;
+        std::size_t my_round = 0;
+        std::uint64_t my_now = 0;
+
+        void run(std::chrono::milliseconds period);
+        void poll();
+
+        static void inspect(void* context, std::size_t thread, const trace::stack::observed* frames, std::size_t depth);
+    };
+
+    trace::watchdog::session::~session()
+    {
+        stop();
+    }
+
+    trace::watchdog::session& trace::watchdog::session::current()
+    {
+        static session instance;
+        return instance;
+    }
+
+    void trace::watchdog::session::start(std::chrono::milliseconds threshold, stall_handler handler)
+    {
+        std::lock_guard<std::mutex> lock(my_mutex);
+        my_threshold = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count());
+        my_handler = handler ? handler : &print_stall;
+        my_threads.clear();
+        my_stopping = false;
+        const std::chrono::milliseconds period = threshold / 4 > std::chrono::milliseconds(1) ? threshold / 4 : std::chrono::milliseconds(1);
+        my_watcher = std::thread(&trace::watchdog::session::run, this, period);
+        trace::watchdog::my_watching.store(true, std::memory_order_release);
+    }
+
+    void trace::watchdog::session::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            if (!my_watcher.joinable())
+                return;
+            my_stopping = true;
+        }
+        my_wakeup.notify_all();
+        my_watcher.join();
+        trace::watchdog::my_watching.store(false, std::memory_order_release);
+    }
+
+    void trace::watchdog::session::run(std::chrono::milliseconds period)
+    {
+        std::unique_lock<std::mutex> lock(my_mutex);
+        while (!my_wakeup.wait_for(lock, period, [this] { return my_stopping; }))
+        {
+            lock.unlock();
+            poll();
+            lock.lock();
+        }
+    }
+
+    void trace::watchdog::session::poll()
+    {
+        my_now = trace::now();
+        ++my_round;
+        trace::stack::observe(&trace::watchdog::session::inspect, this);
+        // завершившиеся потоки больше не попадают в реестр
+        for (auto entry = my_threads.begin(); entry != my_threads.end(); )
+        {
+            if (entry->second.round != my_round)
+                entry = my_threads.erase(entry);
+            else
+                ++entry;
+        }
+    }
+
+    void trace::watchdog::session::inspect(void* context, std::size_t thread, const trace::stack::observed* frames, std::size_t depth)
+    {
+        session& self = *static_cast<session*>(context);
+        watched_thread& target = self.my_threads[thread];
+        target.round = self.my_round;
+        target.frames.resize(depth);
+
+        // скоуп с другим номером входа на той же глубине замечен впервые
+        std::size_t stalled = depth;
+        for (std::size_t index = 0; index < depth; ++index)
+        {
+            seen& entry = target.frames[index];
+            if (entry.serial != frames[index].serial)
+                entry = seen{ frames[index].serial, self.my_now, false };
+            if (self.my_now - entry.since >= self.my_threshold)
+                stalled = index;
+        }
+
+        // сообщается самый глубокий из долгих скоупов, вместе с ним покрыты и внешние
+        if (stalled == depth || target.frames[stalled].reported)
+            return;
+        for (std::size_t index = 0; index <= stalled; ++index)
+            target.frames[index].reported = true;
+
+        trace::stack backtrace;
+        for (std::size_t index = 0; index < depth; ++index)
+            backtrace.push(frames[index].name, frames[index].file, frames[index].line);
+        try
+        {
+            self.my_handler(thread, backtrace, self.my_now - target.frames[stalled].since);
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void trace::watchdog::start(std::chrono::milliseconds threshold, stall_handler handler)
+    {
+        session::current().stop();
+        session::current().start(threshold, handler);
+    }
+
+    void trace::watchdog::stop()
+    {
+        session::current().stop();
+    }
+
+    bool trace::watchdog::watching() noexcept
+    {
+        return my_watching.load(std::memory_order_acquire);
+    }
+}
+
+// Здесь должен быть Unicode
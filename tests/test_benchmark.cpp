@@ -0,0 +1,49 @@
+// Тестирование замеров производительности
+
+#include <dot/test.h>
+#include <iostream>
+#include <memory>
+
+namespace dot
+{
+    DOT_BENCHMARK(operator_new_delete)
+    {
+        while (loop.next())
+        {
+            std::unique_ptr<int> value(new int(42));
+            test::benchmark::keep(value);
+        }
+    }
+
+    DOT_TEST_SUITE(benchmark_loop_counts_iterations)
+    {
+        test::benchmark::loop empty(0);
+        DOT_CHECK(empty.next()).is_false();
+        DOT_CHECK(empty.elapsed()) == 0u;
+
+        test::benchmark::loop counted(3);
+        int iterations = 0;
+        while (counted.next())
+            ++iterations;
+        DOT_CHECK(iterations) == 3;
+        DOT_CHECK(counted.next()).is_false();
+        DOT_CHECK(counted.iterations()) == 3u;
+    }
+
+    DOT_TEST_SUITE(benchmark_measures_allocations)
+    {
+        const test::benchmark::measurement result =
+            g_benchmark_operator_new_delete.measure(std::chrono::milliseconds(2), 3);
+        DOT_CHECK(result.name) == std::string("operator_new_delete");
+        DOT_CHECK(result.iterations > 0u).is_true();
+        DOT_CHECK(result.nanoseconds > 0).is_true();
+        DOT_CHECK(result.per_second > 0).is_true();
+        DOT_CHECK(result.deviation >= 0).is_true();
+#ifndef _WIN32
+        // operator new подменён в test_trace.cpp, одно выделение на итерацию
+        DOT_CHECK(result.allocations) == 1.0;
+#endif
+    }
+}
+
+// Здесь должен быть Unicode
@@ -2,7 +2,10 @@
 
 #include <dot/test.h>
 #include <dot/box.h>
+#include <dot/fail.h>
 #include <iostream>
+#include <sstream>
+#include <string>
 
 namespace dot
 {
@@ -101,22 +104,22 @@ namespace dot
         box<unsigned long long> uLL(12345678901234567890uLL);
         box<unsigned long> uL(4201234567uL);
         box<unsigned int> ui(0xbadfaced);
-        box<unsigned short> us(unsigned short(0x1eaf));
-        box<unsigned char> uc(unsigned char('u'));
+        box<unsigned short> us(static_cast<unsigned short>(0x1eaf));
+        box<unsigned char> uc(static_cast<unsigned char>('u'));
         box<double> d(987.65432109876);
         box<float> f(54.321f);
         box<bool> b(true);
 
-        DOT_CHECK(long long(LL)) == -1234567890123456789LL;
-        DOT_CHECK(long(L)) == 123456789L;
+        DOT_CHECK(static_cast<long long>(LL)) == -1234567890123456789LL;
+        DOT_CHECK(static_cast<long>(L)) == 123456789L;
         DOT_CHECK(int(i)) == -987654321;
         DOT_CHECK(short(s)) == -32100;
         DOT_CHECK(char(c)) == 'c';
-        DOT_CHECK(unsigned long long(uLL)) == 12345678901234567890uLL;
-        DOT_CHECK(unsigned long(uL)) == 4201234567uL;
-        DOT_CHECK(unsigned int(ui)) == 0xbadfaced;
-        DOT_CHECK(unsigned short(us)) == 0x1eaf;
-        DOT_CHECK(unsigned char(uc)) == 'u';
+        DOT_CHECK(static_cast<unsigned long long>(uLL)) == 12345678901234567890uLL;
+        DOT_CHECK(static_cast<unsigned long>(uL)) == 4201234567uL;
+        DOT_CHECK(static_cast<unsigned int>(ui)) == 0xbadfaced;
+        DOT_CHECK(static_cast<unsigned short>(us)) == 0x1eaf;
+        DOT_CHECK(static_cast<unsigned char>(uc)) == 'u';
         DOT_CHECK(double(d)) == 987.65432109876;
         DOT_CHECK(float(f)) == 54.321f;
         DOT_CHECK(bool(b)).is_true();
@@ -135,16 +138,16 @@ namespace dot
         object of = f;
         object ob = b;
 
-        DOT_CHECK(long long(oLL)) == -1234567890123456789LL;
-        DOT_CHECK(long(oL)) == 123456789L;
+        DOT_CHECK(static_cast<long long>(oLL)) == -1234567890123456789LL;
+        DOT_CHECK(static_cast<long>(oL)) == 123456789L;
         DOT_CHECK(int(oi)) == -987654321;
         DOT_CHECK(short(os)) == -32100;
         DOT_CHECK(char(oc)) == 'c';
-        DOT_CHECK(unsigned long long(ouLL)) == 12345678901234567890uLL;
-        DOT_CHECK(unsigned long(ouL)) == 4201234567uL;
-        DOT_CHECK(unsigned int(oui)) == 0xbadfaced;
-        DOT_CHECK(unsigned short(ous)) == 0x1eaf;
-        DOT_CHECK(unsigned char(ouc)) == 'u';
+        DOT_CHECK(static_cast<unsigned long long>(ouLL)) == 12345678901234567890uLL;
+        DOT_CHECK(static_cast<unsigned long>(ouL)) == 4201234567uL;
+        DOT_CHECK(static_cast<unsigned int>(oui)) == 0xbadfaced;
+        DOT_CHECK(static_cast<unsigned short>(ous)) == 0x1eaf;
+        DOT_CHECK(static_cast<unsigned char>(ouc)) == 'u';
         DOT_CHECK(double(od)) == 987.65432109876;
         DOT_CHECK(float(of)) == 54.321f;
         DOT_CHECK(bool(ob)).is_true();
@@ -163,16 +166,16 @@ namespace dot
         box<float> af = of;
         box<bool> ab = ob;
 
-        DOT_CHECK(long long(aLL)) == -1234567890123456789LL;
-        DOT_CHECK(long(aL)) == 123456789L;
+        DOT_CHECK(static_cast<long long>(aLL)) == -1234567890123456789LL;
+        DOT_CHECK(static_cast<long>(aL)) == 123456789L;
         DOT_CHECK(int(ai)) == -987654321;
         DOT_CHECK(short(as)) == -32100;
         DOT_CHECK(char(ac)) == 'c';
-        DOT_CHECK(unsigned long long(auLL)) == 12345678901234567890uLL;
-        DOT_CHECK(unsigned long(auL)) == 4201234567uL;
-        DOT_CHECK(unsigned int(aui)) == 0xbadfaced;
-        DOT_CHECK(unsigned short(aus)) == 0x1eaf;
-        DOT_CHECK(unsigned char(auc)) == 'u';
+        DOT_CHECK(static_cast<unsigned long long>(auLL)) == 12345678901234567890uLL;
+        DOT_CHECK(static_cast<unsigned long>(auL)) == 4201234567uL;
+        DOT_CHECK(static_cast<unsigned int>(aui)) == 0xbadfaced;
+        DOT_CHECK(static_cast<unsigned short>(aus)) == 0x1eaf;
+        DOT_CHECK(static_cast<unsigned char>(auc)) == 'u';
         DOT_CHECK(double(ad)) == 987.65432109876;
         DOT_CHECK(float(af)) == 54.321f;
         DOT_CHECK(bool(ab)).is_true();
@@ -278,6 +281,62 @@ namespace dot
         DOT_CHECK(x.get_as<test_type>().index) == 12345678901234567890uLL;
         DOT_CHECK(x.get_as<test_type>().value) == -1234567.87654321;
     }
+
+    DOT_TEST_SUITE(box_typecast_failure_is_lazy)
+    {
+        const object number(42);
+        bool caught = false;
+        try
+        {
+            trace::scope probe("typecast_probe", "file", 7);
+            number.get_data().as<box<double>::cat>();
+        }
+        catch (const fail::bad_typecast& failure)
+        {
+            caught = true;
+            // идентификаторы те же, что у классов, новые не заводятся
+            DOT_CHECK(failure.to_type() == box<double>::cat::id()).is_true();
+            DOT_CHECK(failure.from_type() == box<int>::cat::id()).is_true();
+
+            const fail::bad_typecast copy(failure);
+            const std::string message = copy.what();
+            DOT_CHECK(message.find(box<double>::cat::id().name()) != std::string::npos).is_true();
+            DOT_CHECK(message.find(box<int>::cat::id().name()) != std::string::npos).is_true();
+            DOT_CHECK(std::string(failure.what())) == message;
+
+            // бэктрейс снят в момент ошибки, хотя скоуп уже закрыт
+            DOT_ENSURE(failure.backtrace().not_empty()).is_true();
+            DOT_CHECK(std::string(failure.backtrace().top_name())) == std::string("typecast_probe");
+
+            std::ostringstream output;
+            output << failure;
+            DOT_CHECK(output.str().find("typecast_probe") != std::string::npos).is_true();
+        }
+        DOT_CHECK(caught).is_true();
+    }
+
+    DOT_TEST_SUITE(box_does_not_allocate)
+    {
+        // значение малого типа живёт во внутреннем буфере объекта
+        DOT_CHECK_NO_ALLOCATION(object created(12345));
+        DOT_CHECK_NO_ALLOCATION(box<int> created(12345));
+
+        const box<int> source(12345);
+        DOT_CHECK_NO_ALLOCATION(box<int> copy(source));
+        DOT_CHECK_NO_ALLOCATION(source.look());
+
+        box<int> target(0);
+        DOT_CHECK_NO_ALLOCATION(++target.touch());
+        DOT_CHECK(target.look()) == 1;
+
+        const object number(42);
+        DOT_CHECK_NO_ALLOCATION(object copy(number));
+        DOT_CHECK_NO_ALLOCATION(number.get_as<int>());
+        DOT_CHECK_NO_ALLOCATION(number.data_as<box<int>::cat>().look());
+
+        // неудачное приведение без исключения тоже обходится без памяти
+        DOT_CHECK_NO_ALLOCATION(number.get_data().try_as<box<double>::cat>().ok());
+    }
 }
 
 // Здесь должен быть Unicode
@@ -1,25 +1,13 @@
 // Запуск всех написанных наборов тестов
 
 #include <dot/test.h>
-#include <iostream>
-#include <conio.h>
+#include <dot/allocations.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#endif
+// выделения всей тестовой программы проходят через учёт по скоупам,
+// на нём же строятся проверки DOT_CHECK_NO_ALLOCATION и DOT_CHECK_ALLOCATIONS
+DOT_TRACE_ALLOCATIONS_HOOK
 
-int main()
-{
-#ifdef _WIN32
-   SetConsoleOutputCP(CP_UTF8);
-#endif
-
-    dot::test::run();
-
-    std::cout << "\n < Нажмите любую клавишу > ... ";
-    getch();
-
-    return 0;
-}
+// аргументы запуска: test_dot --help
+DOT_TEST_MAIN
 
 // Здесь должен быть Unicode
@@ -3,7 +3,15 @@
 #include <dot/test.h>
 #include <dot/object.h>
 #include <dot/box.h>
+#include <dot/string.h>
+#include <dot/visit.h>
+#include <dot/fail.h>
+#include <array>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace dot
 {
@@ -32,8 +40,8 @@ namespace dot
         object uLL(12345678909876543210uLL);
         object uL(0xdeadceeduL);
         object u(1024u);
-        object us(unsigned short(0xfee1));
-        object uc(unsigned char('~'));
+        object us(static_cast<unsigned short>(0xfee1));
+        object uc(static_cast<unsigned char>('~'));
         object d(2.345678901e+123);
         object f(3.45678e+12f);
         object b(true);
@@ -46,12 +54,349 @@ namespace dot
         DOT_CHECK(uLL.get_as<unsigned long long>()) == 12345678909876543210uLL;
         DOT_CHECK(uL.get_as<unsigned long>()) == 0xdeadceeduL;
         DOT_CHECK(u.get_as<unsigned int>()) == 1024u;
-        DOT_CHECK(us.get_as<unsigned short>()) == unsigned short(0xfee1);
-        DOT_CHECK(uc.get_as<unsigned char>()) == unsigned char('~');
+        DOT_CHECK(us.get_as<unsigned short>()) == static_cast<unsigned short>(0xfee1);
+        DOT_CHECK(uc.get_as<unsigned char>()) == static_cast<unsigned char>('~');
         DOT_CHECK(d.get_as<double>()) == 2.345678901e+123;
         DOT_CHECK(f.get_as<float>()) == 3.45678e+12f;
         DOT_CHECK(b).is_true();
     }
+
+    DOT_TEST_SUITE(object_visit)
+    {
+        // варианты выводятся из параметров лямбд, запасной вариант получает объект
+        auto describe = [](const object& source)
+        {
+            return visit(source, overloaded
+            {
+                [](int value) { return "int " + std::to_string(value); },
+                [](double value) { return "double " + std::to_string(static_cast<int>(value)); },
+                [](const std::string& value) { return "string " + value; },
+                [](const object& other) { return std::string(other.is_null() ? "null" : "other"); }
+            });
+        };
+        DOT_CHECK(describe(object(42))) == "int 42";
+        DOT_CHECK(describe(object(2.5))) == "double 2";
+        DOT_CHECK(describe(object(std::string("text longer than the object buffer")))) == "string text longer than the object buffer";
+        DOT_CHECK(describe(object(std::string("short")))) == "string short";
+        DOT_CHECK(describe(object())) == "null";
+        DOT_CHECK(describe(object(1.5f))) == "other";
+        DOT_CHECK(describe(object(7L))) == "other";
+
+        // явный список вариантов годится и для шаблонной лямбды
+        int total = 0;
+        const object values[] = { object(1), object(2LL), object(true), object(3.0f), object() };
+        for (const object& value : values)
+        {
+            visit<int, long long, bool>(value, overloaded
+            {
+                [&](const auto& number) { total += static_cast<int>(number) * 10; },
+                [&](const object&) { total += 1; }
+            });
+        }
+        DOT_CHECK(total) == 42;
+
+        // таблица строится при первом обходе, дальше обход не выделяет память
+        const object number(12345);
+        auto twice = overloaded{ [](int value) { return 2 * value; }, [](const object&) { return 0; } };
+        DOT_CHECK(visit(number, twice)) == 24690;
+        DOT_CHECK_NO_ALLOCATION(test::benchmark::keep(visit(number, twice)));
+    }
+
+    // наследник "кошки" с владеющим указателем: признаки побайтного копирования
+    // объявлены для box<int>::cat и ему не достаются
+    class owned_cat : public box<int>::cat
+    {
+    public:
+        explicit owned_cat(int value)
+            : box<int>::cat(value),
+              my_text(new std::string("owned"))
+        {
+        }
+
+        owned_cat(const owned_cat& another)
+            : box<int>::cat(another.look()),
+              my_text(new std::string(*another.my_text))
+        {
+        }
+
+        const std::string& text() const noexcept
+        {
+            return *my_text;
+        }
+
+        DOT_HIERARCHIC(box<int>::cat);
+
+    protected:
+        virtual object::data* copy_to(void* buffer) const noexcept override
+        {
+            return new(buffer) owned_cat(*this);
+        }
+
+        virtual object::data* move_to(void* buffer) noexcept override
+        {
+            return new(buffer) owned_cat(*this);
+        }
+
+    private:
+        std::unique_ptr<std::string> my_text;
+    };
+
+    DOT_CLASS_ID(owned_cat)
+
+    // объект с данными owned_cat
+    class owned_object : public object
+    {
+    public:
+        explicit owned_object(int value)
+        {
+            initialize<owned_cat>(value);
+        }
+    };
+
+    DOT_TEST_SUITE(object_owned_data)
+    {
+        DOT_CHECK(trivially_copyable_class<box<int>::cat>::value).is_true();
+        DOT_CHECK(trivially_copyable_class<owned_cat>::value).is_false();
+        DOT_CHECK(trivially_relocatable_class<owned_cat>::value).is_false();
+        DOT_CHECK(owned_cat::id().info().trivially_copyable).is_false();
+
+        // копия получает свою строку, а не побайтную копию указателя
+        const owned_object source(7);
+        object copy;
+        DOT_CHECK_ALLOCATIONS(copy = source, 1);
+        const owned_cat& original = source.data_as<owned_cat>();
+        const owned_cat& copied = copy.data_as<owned_cat>();
+        DOT_CHECK(copied.look()) == 7;
+        DOT_CHECK(copied.text()) == "owned";
+        DOT_CHECK(&copied.text() != &original.text()).is_true();
+
+        // перенос и сброс вызывают конструктор и деструктор данных
+        object moved(std::move(copy));
+        DOT_CHECK(moved.data_as<owned_cat>().text()) == "owned";
+        moved.reset();
+        DOT_CHECK(moved).is_null();
+    }
+
+    DOT_TEST_SUITE(object_relocation)
+    {
+        // тривиальные данные копируются и переносятся побайтно, источник сохраняет значение
+        object number(12345);
+        object copy(number);
+        object moved(std::move(number));
+        DOT_CHECK(copy.get_as<int>()) == 12345;
+        DOT_CHECK(moved.get_as<int>()) == 12345;
+        DOT_CHECK(number.get_as<int>()) == 12345;
+
+        // "верёвка" переносится побайтно без изменения счётчика ссылок,
+        // перенесённый объект пуст, а копия разделяет значение без выделения памяти
+        const std::string text = "text longer than the object buffer";
+        object source(text);
+        object shared;
+        DOT_CHECK_NO_ALLOCATION(shared = source);
+        object target;
+        DOT_CHECK_NO_ALLOCATION(target = std::move(source));
+        DOT_CHECK(source).is_null();
+        DOT_CHECK(target.get_as<std::string>()) == text;
+        DOT_CHECK(shared.get_as<std::string>()) == text;
+        DOT_CHECK(target == shared).is_true();
+
+        // присваивание самому себе сохраняет данные
+        object& same = target;
+        target = same;
+        DOT_CHECK(target.get_as<std::string>()) == text;
+        target = std::move(same);
+        DOT_CHECK(target.get_as<std::string>()) == text;
+
+        // перевыделение вектора переносит объекты без потери данных
+        std::vector<object> values;
+        for (int index = 0; index < 100; ++index)
+        {
+            if (index % 3)
+                values.emplace_back(index);
+            else
+                values.emplace_back(text + std::to_string(index));
+        }
+        for (int index = 0; index < 100; ++index)
+        {
+            if (index % 3)
+                DOT_CHECK(values[index].get_as<int>()) == index;
+            else
+                DOT_CHECK(values[index].get_as<std::string>()) == text + std::to_string(index);
+        }
+    }
+
+    // 3 double и метка, как в геометрических данных
+    struct tagged_point
+    {
+        double x, y, z;
+        int64 tag;
+
+        bool operator == (const tagged_point& another) const noexcept
+        {
+            return x == another.x && y == another.y && z == another.z && tag == another.tag;
+        }
+
+        bool operator < (const tagged_point& another) const noexcept
+        {
+            return tag < another.tag;
+        }
+    };
+
+    template<> DOT_CLASS_ID(box<tagged_point>::cat)
+    template<> DOT_CLASS_ID(rope<tagged_point>::cow)
+
+    // значения на границе ёмкостей: 2 int64 лежат в буфере object, но не basic_object<8>,
+    // а 3 int64 лежат в буфере basic_object<32>, но данные с ними больше буфера object
+    typedef std::array<int64, 2> boundary_pair;
+    typedef std::array<int64, 3> boundary_triple;
+
+    template<> DOT_CLASS_ID(box<boundary_pair>::cat)
+    template<> DOT_CLASS_ID(rope<boundary_pair>::cow)
+    template<> DOT_CLASS_ID(box<boundary_triple>::cat)
+    template<> DOT_CLASS_ID(rope<boundary_triple>::cow)
+
+    DOT_TEST_SUITE(object_capacity)
+    {
+        // размер объекта следует ёмкости буфера
+        DOT_CHECK(sizeof(basic_object<8>) < sizeof(object)).is_true();
+        DOT_CHECK(sizeof(object) < sizeof(basic_object<32>)).is_true();
+        DOT_CHECK(std::string(object::id().name())) == "object";
+        DOT_CHECK(std::string(basic_object<32>::id().name())) == "basic_object<32>";
+        DOT_CHECK(std::string(basic_object<8>::id().name())) == "basic_object<8>";
+
+        // переход от box к rope следует ёмкости
+        const tagged_point spot = { 1.0, 2.0, 3.0, 42 };
+        const basic_object<32> wide(spot);
+        const object narrow(spot);
+        DOT_CHECK(wide).is<basic_object<32>>();
+        DOT_CHECK(wide.get_data()).is<box<tagged_point>::cat>();
+        DOT_CHECK(narrow.get_data()).is<rope<tagged_point>::cow>();
+        DOT_CHECK(wide.get_as<tagged_point>() == spot).is_true();
+        DOT_CHECK(narrow.get_as<tagged_point>() == spot).is_true();
+        DOT_CHECK(wide.try_get_as<tagged_point>().ok()).is_true();
+        const basic_object<8> key(12345LL);
+        DOT_CHECK(key.get_data()).is<box<long long>::cat>();
+        DOT_CHECK(key.get_as<long long>()) == 12345LL;
+
+        // строки хранятся по общей ссылке в объекте любой ёмкости
+        const basic_object<32> text(std::string("short"));
+        DOT_CHECK(text.get_data()).is<rope<std::string>::cow>();
+        DOT_CHECK(text.get_as<std::string>()) == "short";
+        const basic_object<8> literal("literal");
+        DOT_CHECK(literal.get_data()).is<rope<std::string>::cow>();
+        DOT_CHECK(std::string(literal.get_as<const char*>())) == "literal";
+        DOT_CHECK(std::string(literal.try_get_as<const char*>().value())) == "literal";
+
+        // данные переходят между ёмкостями в буфер цели
+        const object from_key(key);
+        DOT_CHECK(from_key.get_as<long long>()) == 12345LL;
+        DOT_CHECK(from_key.get_data() == key.get_data()).is_true();
+        const basic_object<64> wider(wide);
+        DOT_CHECK(wider.get_as<tagged_point>() == spot).is_true();
+        basic_object<8> shared(narrow);
+        DOT_CHECK(shared.get_data()).is<rope<tagged_point>::cow>();
+        DOT_CHECK(shared.get_as<tagged_point>() == spot).is_true();
+
+        // данные больше буфера цели лежат в куче и возвращаются в буфер большой цели
+        const object too_small(wide);
+        DOT_CHECK(too_small.get_data()).is<heap_data>();
+        DOT_CHECK(too_small.get_as<tagged_point>() == spot).is_true();
+        DOT_CHECK(too_small.try_get_as<tagged_point>().ok()).is_true();
+        DOT_CHECK(too_small == object(too_small)).is_true();
+        DOT_CHECK(too_small == object(spot)).is_true();
+        DOT_CHECK(object(spot) == too_small).is_true();
+        DOT_CHECK(too_small < object(spot)).is_false();
+        DOT_CHECK(object(spot) < too_small).is_false();
+        DOT_CHECK(too_small < object(tagged_point{ 0.0, 0.0, 0.0, 43 })).is_true();
+        DOT_CHECK(object(tagged_point{ 0.0, 0.0, 0.0, 41 }) < too_small).is_true();
+        object heap_copy;
+        DOT_CHECK_NO_ALLOCATION(heap_copy = too_small);
+        DOT_CHECK(heap_copy.get_as<tagged_point>() == spot).is_true();
+        const basic_object<48> roomy(too_small);
+        DOT_CHECK(roomy.get_data()).is<box<tagged_point>::cat>();
+        DOT_CHECK(roomy.get_as<tagged_point>() == spot).is_true();
+        object target(1);
+        target = wide;
+        DOT_CHECK(target.get_as<tagged_point>() == spot).is_true();
+        basic_object<32> heap_moved;
+        heap_moved = std::move(target);
+        DOT_CHECK(target).is_null();
+        DOT_CHECK(heap_moved.get_data()).is<box<tagged_point>::cat>();
+        target = key;
+        DOT_CHECK(target.get_as<long long>()) == 12345LL;
+
+        // значение на границе ёмкостей читается в любом виде данных
+        const boundary_pair pair = { 1, 2 };
+        const basic_object<8> pair_by_reference(pair);
+        DOT_CHECK(pair_by_reference.get_data()).is<rope<boundary_pair>::cow>();
+        const object pair_copy(pair_by_reference);
+        DOT_CHECK(pair_copy.get_data()).is<rope<boundary_pair>::cow>();
+        DOT_CHECK(pair_copy.get_as<boundary_pair>() == pair).is_true();
+        DOT_CHECK(pair_copy.try_get_as<boundary_pair>().ok()).is_true();
+        const basic_object<8> pair_back{ object(pair) };
+        DOT_CHECK(pair_back.get_data()).is<heap_data>();
+        DOT_CHECK(pair_back.get_as<boundary_pair>() == pair).is_true();
+        const boundary_triple triple = { 1, 2, 3 };
+        basic_object<32> triple_boxed(triple);
+        DOT_CHECK(triple_boxed.get_data()).is<box<boundary_triple>::cat>();
+        const object triple_copy(triple_boxed);
+        DOT_CHECK(triple_copy.get_as<boundary_triple>() == triple).is_true();
+        DOT_CHECK(triple_copy == object(triple)).is_true();
+        DOT_CHECK(object(triple) == triple_copy).is_true();
+        const object triple_moved(std::move(triple_boxed));
+        DOT_CHECK(triple_moved.get_as<boundary_triple>() == triple).is_true();
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_typecast, triple_copy.get_as<boundary_pair>());
+        auto sum = overloaded
+        {
+            [](const boundary_pair& value) { return value[0] + value[1]; },
+            [](const boundary_triple& value) { return value[0] + value[1] + value[2]; },
+            [](const object&) { return int64(-1); },
+            [](const basic_object<8>&) { return int64(-8); }
+        };
+        DOT_CHECK(visit(pair_copy, sum)) == 3;
+        DOT_CHECK(visit(triple_copy, sum)) == 6;
+        DOT_CHECK(visit(pair_back, sum)) == 3;
+        DOT_CHECK(visit(from_key, sum)) == -1;
+
+        // перенос между ёмкостями не копирует строку и опустошает источник
+        basic_object<32> source(std::string("text longer than the object buffer"));
+        basic_object<8> moved;
+        DOT_CHECK_NO_ALLOCATION(moved = std::move(source));
+        DOT_CHECK(source).is_null();
+        DOT_CHECK(moved.get_as<std::string>()) == "text longer than the object buffer";
+
+        // обход объекта другой ёмкости выбирает данные по его же правилу
+        auto describe = overloaded
+        {
+            [](const tagged_point& value) { return static_cast<int>(value.tag); },
+            [](long long value) { return static_cast<int>(value); },
+            [](const basic_object<32>&) { return -1; },
+            [](const basic_object<8>&) { return -8; }
+        };
+        DOT_CHECK(visit(wide, describe)) == 42;
+        DOT_CHECK(visit(basic_object<32>(7LL), describe)) == 7;
+        DOT_CHECK(visit(text, describe)) == -1;
+        DOT_CHECK(visit(key, describe)) == 12345;
+        DOT_CHECK(visit(shared, describe)) == 42;
+        DOT_CHECK(visit(literal, describe)) == -8;
+    }
+
+    DOT_BENCHMARK(object_copy_of_box)
+    {
+        const object source(12345);
+        while (loop.next())
+        {
+            object copy(source);
+            test::benchmark::keep(copy);
+        }
+    }
+
+    DOT_BENCHMARK(object_get_as_int)
+    {
+        const object source(12345);
+        while (loop.next())
+            test::benchmark::keep(source.get_as<int>());
+    }
 }
 
 // Здесь должен быть Unicode
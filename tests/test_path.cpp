@@ -0,0 +1,155 @@
+// Тестирование выборки вложенных объектов по пути
+
+#include <dot/test.h>
+#include <dot/path.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <iostream>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        object make_item(const char* sku, int price)
+        {
+            record item;
+            item["sku"] = object(string(sku));
+            item["price"] = object(price);
+            return object(std::move(item));
+        }
+
+        object make_document()
+        {
+            array first_items;
+            first_items.push_back(make_item("A1", 10));
+            first_items.push_back(make_item("B2", 25));
+            array second_items;
+            second_items.push_back(make_item("C3", 5));
+            record first, second;
+            first["id"] = object(1);
+            first["items"] = object(std::move(first_items));
+            second["id"] = object(2);
+            second["items"] = object(std::move(second_items));
+            array orders;
+            orders.push_back(object(std::move(first)));
+            orders.push_back(object(std::move(second)));
+            record root;
+            root["orders"] = object(std::move(orders));
+            return object(std::move(root));
+        }
+    }
+
+    DOT_TEST_SUITE(path_fields_and_wildcards)
+    {
+        const object document = make_document();
+        DOT_ENSURE(document.get_data()).is<rope<record>::cow>();
+
+        const path skus("orders[*].items[*].sku");
+        std::vector<object> found = skus.select(document);
+        DOT_ENSURE(found.size()) == 3u;
+        DOT_CHECK(found[0].get_as<string>()) == string("A1");
+        DOT_CHECK(found[1].get_as<string>()) == string("B2");
+        DOT_CHECK(found[2].get_as<string>()) == string("C3");
+
+        const path same("$.orders.*['items'][*].sku");
+        DOT_CHECK(same.select(document).size()) == 3u;
+
+        DOT_CHECK(path("$.orders[*].missing").select(document).size()) == 0u;
+        DOT_CHECK(path("$.orders[*].id.deeper").select(document).size()) == 0u;
+        DOT_CHECK(path("$").select(document).size()) == 1u;
+    }
+
+    DOT_TEST_SUITE(path_indexes_and_slices)
+    {
+        const object document = make_document();
+        DOT_CHECK(path("$.orders[0].id").first(document).get_as<int>()) == 1;
+        DOT_CHECK(path("$.orders[-1].id").first(document).get_as<int>()) == 2;
+        DOT_CHECK(path("$.orders[5].id").first(document)).is_null();
+        DOT_CHECK(path("$.orders[0].items[1:].sku").first(document).get_as<string>()) == string("B2");
+        DOT_CHECK(path("$.orders[0].items[:1].sku").select(document).size()) == 1u;
+        DOT_CHECK(path("$.orders[0].items[::2].sku").select(document).size()) == 1u;
+        DOT_CHECK(path("$.orders[-5:10].id").select(document).size()) == 2u;
+    }
+
+    DOT_TEST_SUITE(path_filters)
+    {
+        const object document = make_document();
+        std::vector<object> expensive = path("$.orders[*].items[?(@.price > 8)].sku").select(document);
+        DOT_ENSURE(expensive.size()) == 2u;
+        DOT_CHECK(expensive[0].get_as<string>()) == string("A1");
+        DOT_CHECK(expensive[1].get_as<string>()) == string("B2");
+
+        DOT_CHECK(path("$.orders[?(@.id == 2)].items[*].sku").first(document).get_as<string>()) == string("C3");
+        DOT_CHECK(path("$.orders[*].items[?@.sku == 'B2'].price").first(document).get_as<int>()) == 25;
+        DOT_CHECK(path("$.orders[?(@.items[?(@.price < 6)])].id").first(document).get_as<int>()) == 2;
+        DOT_CHECK(path("$.orders[*].items[?(@.discount)]").matches(document)).is_false();
+    }
+
+    DOT_TEST_SUITE(path_filters_mixed_numbers)
+    {
+        // числа разных типов сравниваются с литералом по значению
+        array items;
+        items.push_back(object(20));
+        items.push_back(object(12LL));
+        items.push_back(object(9.5));
+        items.push_back(object(string("12")));
+        record root;
+        root["prices"] = object(std::move(items));
+        const object document(std::move(root));
+        DOT_CHECK(path("$.prices[?(@ > 8)]").select(document).size()) == 3u;
+        DOT_CHECK(path("$.prices[?(@ == 12)]").first(document).get_as<long long>()) == 12LL;
+        DOT_CHECK(path("$.prices[?(@ == 12.0)]").select(document).size()) == 1u;
+        DOT_CHECK(path("$.prices[?(@ < 10)]").first(document).get_as<double>()) == 9.5;
+        DOT_CHECK(path("$.prices[?(@ >= 20.0)]").first(document).get_as<int>()) == 20;
+        DOT_CHECK(path("$.prices[?(@ != 20)]").select(document).size()) == 3u;
+        DOT_CHECK(path("$.prices[?(@ == '12')]").first(document).get_as<string>()) == string("12");
+    }
+
+    DOT_TEST_SUITE(path_copy_moved)
+    {
+        // присваивание перенесённому пути и копия перенесённого не падают
+        const object document = make_document();
+        path source("$.orders[*].id");
+        path moved(std::move(source));
+        const path other("$.orders[0].id");
+        DOT_CHECK_NO_EXCEPTION(source = other);
+        DOT_CHECK(source.first(document).get_as<int>()) == 1;
+        path emptied(std::move(source));
+        DOT_CHECK_NO_EXCEPTION(path copy(source); copy = moved);
+        DOT_CHECK(moved.select(document).size()) == 2u;
+
+        // перенесённый путь пуст и ничего не выбирает
+        DOT_CHECK(source.select(document).size()) == 0u;
+        DOT_CHECK(source.first(document)).is_null();
+        DOT_CHECK(source.matches(document)).is_false();
+        DOT_CHECK(std::string(source.expression())) == "";
+    }
+
+    DOT_TEST_SUITE(path_shares_data)
+    {
+        const object document = make_document();
+        const path items("$.orders[0].items");
+        rope<array> selected = items.first(document);
+        DOT_CHECK(selected.bound()) == 2u;
+        selected.touch().clear();
+        DOT_CHECK(selected.unique()).is_true();
+        DOT_CHECK(path("$.orders[0].items[*]").select(document).size()) == 2u;
+    }
+
+    DOT_TEST_SUITE(path_syntax_errors)
+    {
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders["));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders[abc]"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders[::0]"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders[?(@.id > )]"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$..orders"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders[99999999999999999999]"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders[-99999999999999999999:]"));
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_path, path("$.orders['id]"));
+        DOT_CHECK_NO_EXCEPTION(path("orders[*].items[*].sku"));
+    }
+}
+
+// Здесь должен быть Unicode
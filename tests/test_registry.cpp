@@ -0,0 +1,130 @@
+// Тестирование реестра классов иерархии
+
+#include <dot/test.h>
+#include <dot/registry.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <dot/fail.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace dot
+{
+    // наследник box без конструктора по умолчанию: признак предка ему не достаётся
+    class registry_counter : public box<int>
+    {
+    public:
+        explicit registry_counter(int start)
+            : box<int>(start)
+        {
+        }
+
+        DOT_HIERARCHIC(box<int>);
+    };
+
+    DOT_CLASS_ID(registry_counter)
+    DOT_REGISTER_CLASS(registry_counter)
+
+    DOT_TEST_SUITE(registry_find)
+    {
+        // классы библиотеки и классы с DOT_REGISTER_CLASS известны реестру до первого обращения к id()
+        const class_id* cat = class_registry::find("box<int>::cat");
+        DOT_ENSURE(cat != nullptr).is_true();
+        DOT_CHECK(*cat == box<int>::cat::id()).is_true();
+        DOT_CHECK(class_registry::find(cat->index())) == cat;
+        DOT_CHECK(class_registry::find("rope<string>::cow")) == &rope<std::string>::cow::id();
+        DOT_CHECK(class_registry::find("object")) == &object::id();
+        DOT_CHECK(class_registry::find("registry_counter")) == &registry_counter::id();
+        DOT_CHECK(class_registry::find("no such class") == nullptr).is_true();
+        DOT_CHECK(class_registry::find(class_registry::last_index() + 1) == nullptr).is_true();
+        DOT_CHECK(class_registry::find(uint64(0)) == nullptr).is_true();
+
+        // все индексы до последнего плотные
+        uint64 found = 0;
+        for (uint64 index = 1; index <= class_registry::last_index(); ++index)
+            if (class_registry::find(index))
+                ++found;
+        DOT_CHECK(found) == class_registry::last_index();
+    }
+
+    DOT_TEST_SUITE(registry_info)
+    {
+        const class_info& cat = box<double>::cat::id().info();
+        DOT_CHECK(cat.size) == sizeof(box<double>::cat);
+        DOT_CHECK(cat.alignment) == alignof(box<double>::cat);
+        DOT_CHECK(cat.trivially_copyable).is_true();
+        DOT_CHECK(cat.trivially_relocatable).is_true();
+        DOT_CHECK(cat.abstract).is_false();
+        DOT_ENSURE(cat.base != nullptr).is_true();
+        DOT_CHECK(cat.base() == box_based::cat_based::id()).is_true();
+
+        const class_info& data = object::data::id().info();
+        DOT_CHECK(data.abstract).is_true();
+        DOT_CHECK(data.create == nullptr).is_true();
+        DOT_CHECK(data.trivially_copyable).is_false();
+        DOT_CHECK(object::id().info().base == nullptr).is_true();
+
+        // предки по сведениям DOT_HIERARCHIC совпадают с проверкой is<...>()
+        DOT_CHECK(class_registry::derives(box<double>::cat::id(), object::data::id())).is_true();
+        DOT_CHECK(class_registry::derives(box<double>::cat::id(), box<double>::cat::id())).is_true();
+        DOT_CHECK(class_registry::derives(box<double>::cat::id(), box<int>::cat::id())).is_false();
+        DOT_CHECK(class_registry::derives(rope<std::string>::id(), object::id())).is_true();
+        DOT_CHECK(class_registry::derives(object::id(), rope_based::id())).is_false();
+
+        // фабрика создаёт экземпляр по имени класса
+        const class_id* found = class_registry::find("box<int>::cat");
+        DOT_ENSURE(found != nullptr).is_true();
+        const class_info& info = found->info();
+        DOT_ENSURE(info.create != nullptr).is_true();
+        std::unique_ptr<unsigned char[]> buffer(new unsigned char[info.size + info.alignment]);
+        void* place = buffer.get();
+        std::size_t space = info.size + info.alignment;
+        DOT_ENSURE(std::align(info.alignment, info.size, place, space) != nullptr).is_true();
+        hierarchic* created = info.create(place);
+        DOT_CHECK(created->my_id() == *found).is_true();
+        DOT_CHECK(created->as<box<int>::cat>().look()) == 0;
+        created->~hierarchic();
+
+        // фабрики нет у наследника без конструктора по умолчанию
+        DOT_CHECK(registry_counter::id().info().create == nullptr).is_true();
+        DOT_CHECK(box<int>::id().info().create != nullptr).is_true();
+    }
+
+    // кодек задаётся для всего процесса, поэтому набор не идёт в пуле с другими
+    DOT_TEST_SUITE_EXCLUSIVE(registry_codec)
+    {
+        const class_id& identifier = box<short>::cat::id();
+        DOT_CHECK(class_registry::find_codec(identifier) == nullptr).is_true();
+
+        class_registry::codec binary;
+        binary.write = [](const hierarchic& source, std::ostream& stream)
+        {
+            const short value = source.as<box<short>::cat>().look();
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        binary.read = [](std::istream& stream, hierarchic& target)
+        {
+            stream.read(reinterpret_cast<char*>(&target.as<box<short>::cat>().touch()), sizeof(short));
+        };
+        class_registry::set_codec(identifier, binary);
+        const class_registry::codec* found = class_registry::find_codec(identifier);
+        DOT_ENSURE(found != nullptr).is_true();
+        DOT_CHECK(found->write == binary.write).is_true();
+        DOT_CHECK(found->read == binary.read).is_true();
+
+        const box<short>::cat source(short(-1234));
+        box<short>::cat target(short(0));
+        std::stringstream stream;
+        found->write(source, stream);
+        found->read(stream, target);
+        DOT_CHECK(target.look()) == short(-1234);
+
+        // снятый кодек не виден следующим запускам набора
+        class_registry::remove_codec(identifier);
+        DOT_CHECK(class_registry::find_codec(identifier) == nullptr).is_true();
+    }
+}
+
+// Здесь должен быть Unicode
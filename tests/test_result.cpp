@@ -0,0 +1,84 @@
+// Тестирование доступа к данным объектов без исключений
+
+#include <dot/test.h>
+#include <dot/box.h>
+#include <dot/rope.h>
+#include <dot/string.h>
+#include <dot/fail.h>
+#include <iostream>
+#include <string>
+
+using std::string;
+
+namespace dot
+{
+    // собраны без исключений в test_result_no_exceptions.cpp
+    int no_exceptions_get_int_or(const object& source, int fallback) noexcept;
+    result_code no_exceptions_data_code(const object& source) noexcept;
+    std::size_t no_exceptions_string_size(const object& source) noexcept;
+
+    DOT_TEST_SUITE(result_of_successful_access)
+    {
+        const object number(42);
+        const result<int> value = number.try_get_as<int>();
+        DOT_ENSURE(value.ok()).is_true();
+        DOT_CHECK(value.code() == result_code::ok).is_true();
+        DOT_CHECK(*value) == 42;
+        DOT_CHECK(value.value()) == 42;
+        DOT_CHECK(value.value_or(7)) == 42;
+
+        const result<const box<int>::cat&> data = number.try_data_as<box<int>::cat>();
+        DOT_ENSURE(data.ok()).is_true();
+        DOT_CHECK(&*data == &number.get_data()).is_true();
+        DOT_CHECK(number.get_data().try_as<box<int>::cat>().ok()).is_true();
+
+        const object text(string("строка длиннее внутреннего буфера объекта"));
+        const result<string> copy = text.try_get_as<string>();
+        DOT_ENSURE(copy.ok()).is_true();
+        DOT_CHECK(*copy) == string("строка длиннее внутреннего буфера объекта");
+    }
+
+    DOT_TEST_SUITE(result_of_failed_typecast)
+    {
+        const object number(42);
+        const result<double> value = number.try_get_as<double>();
+        DOT_ENSURE(value.ok()).is_false();
+        DOT_CHECK(static_cast<bool>(value)).is_false();
+        DOT_CHECK(value.code() == result_code::bad_typecast).is_true();
+        DOT_CHECK(value.error().to_type() == &box<double>::cat::id()).is_true();
+        DOT_CHECK(value.error().from_type() == &box<int>::cat::id()).is_true();
+        DOT_CHECK(value.value_or(1.5)) == 1.5;
+
+        // описание то же, что и у исключения
+        const string detail = value.error().detail();
+        DOT_CHECK(detail.find(box<double>::cat::id().name()) != string::npos).is_true();
+        DOT_CHECK(detail.find(box<int>::cat::id().name()) != string::npos).is_true();
+        DOT_CHECK_EXPECT_EXCEPTION(fail::bad_typecast, value.value());
+
+        DOT_CHECK(number.try_get_as<string>().code() == result_code::bad_typecast).is_true();
+        DOT_CHECK(number.get_data().try_as<box<double>::cat>().ok()).is_false();
+    }
+
+    DOT_TEST_SUITE(result_of_null_access)
+    {
+        const object empty;
+        DOT_CHECK(empty.try_get_data().code() == result_code::null_reference).is_true();
+        DOT_CHECK(empty.try_get_as<int>().code() == result_code::null_reference).is_true();
+        DOT_CHECK(empty.try_data_as<box<int>::cat>().error().detail().empty()).is_false();
+        DOT_CHECK_EXPECT_EXCEPTION(fail::null_reference, empty.try_get_as<int>().value());
+        DOT_CHECK_EXPECT_EXCEPTION(fail::null_reference, empty.get_data());
+    }
+
+    DOT_TEST_SUITE(result_without_exceptions)
+    {
+        DOT_CHECK(no_exceptions_get_int_or(object(5), -1)) == 5;
+        DOT_CHECK(no_exceptions_get_int_or(object(2.5), -1)) == -1;
+        DOT_CHECK(no_exceptions_get_int_or(object(), -1)) == -1;
+        DOT_CHECK(no_exceptions_data_code(object(5)) == result_code::bad_typecast).is_true();
+        DOT_CHECK(no_exceptions_data_code(object(0.5)) == result_code::ok).is_true();
+        DOT_CHECK(no_exceptions_string_size(object(string("четыре")))) == string("четыре").size();
+        DOT_CHECK(no_exceptions_string_size(object(4))) == 0u;
+    }
+}
+
+// Здесь должен быть Unicode
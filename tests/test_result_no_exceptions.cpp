@@ -0,0 +1,28 @@
+// Доступ к данным объектов в сборке без исключений
+// файл собирается с -fno-exceptions, а проверяется из test_result.cpp
+
+#include <dot/box.h>
+#include <dot/rope.h>
+#include <dot/string.h>
+#include <string>
+
+namespace dot
+{
+    int no_exceptions_get_int_or(const object& source, int fallback) noexcept
+    {
+        return source.try_get_as<int>().value_or(fallback);
+    }
+
+    result_code no_exceptions_data_code(const object& source) noexcept
+    {
+        return source.try_data_as<box<double>::cat>().code();
+    }
+
+    std::size_t no_exceptions_string_size(const object& source) noexcept
+    {
+        const result<std::string> text = source.try_get_as<std::string>();
+        return text ? (*text).size() : 0;
+    }
+}
+
+// Здесь должен быть Unicode
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <thread>
 #include <vector>
+#include <cstring>
 
 using std::string;
 using std::wstring;
@@ -139,8 +140,9 @@ namespace dot
     {
         static const string original_text = "Copy me gently! Again and again...";
         static const string another_text = "Just a text. Nothing else.";
-        static const rope<string> original = original_text;
-        static const rope<string> another(another_text);
+        // local ropes so concurrent repeats of the suite do not share bound counters
+        const rope<string> original = original_text;
+        const rope<string> another(another_text);
         static const uint copy_count = 1000;
         static const uint thread_count = 10;
         vector<rope<string>> copies(copy_count);
@@ -287,6 +289,38 @@ namespace dot
         DOT_CHECK(u) == u2;
         DOT_CHECK(U) == U2;
     }
+
+    DOT_TEST_SUITE(rope_allocations)
+    {
+        // short text fits into the small string buffer, so only the neck is allocated
+        DOT_CHECK_ALLOCATIONS(rope<string> created(string("short")), 1);
+
+        const rope<string> original(string("Copy me gently! Again and again..."));
+        DOT_CHECK_NO_ALLOCATION(rope<string> copy(original));
+        DOT_CHECK_NO_ALLOCATION(original.look().size());
+
+        rope<string> unique(string("short"));
+        DOT_CHECK_NO_ALLOCATION(unique.touch()[0] = 'S');
+
+        // touch of a shared rope allocates a new neck and copies the long text
+        rope<string> shared(original);
+        DOT_CHECK_ALLOCATIONS(shared.touch()[0] = 'S', 2);
+        DOT_CHECK(original.look()[0]) == 'C';
+
+        const object holder(original.look());
+        DOT_CHECK_NO_ALLOCATION(object copy(holder));
+        DOT_CHECK_NO_ALLOCATION(holder.get_as<const string&>().size());
+    }
+
+    DOT_BENCHMARK(rope_copy_of_shared)
+    {
+        const rope<string> original(string("Copy me gently! Again and again..."));
+        while (loop.next())
+        {
+            rope<string> copy(original);
+            test::benchmark::keep(copy);
+        }
+    }
 }
 
 // Здесь должен быть Unicode
@@ -0,0 +1,162 @@
+// Тестирование сортировки объектов по нормализованным ключам
+
+#include <dot/test.h>
+#include <dot/sort.h>
+#include <dot/box.h>
+#include <dot/string.h>
+#include <dot/path.h>
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using std::string;
+using std::u32string;
+
+namespace dot
+{
+    DOT_TEST_SUITE(sort_key_order)
+    {
+        DOT_CHECK(sort_key(object()) < sort_key(object(false))).is_true();
+        DOT_CHECK(sort_key(object(false)) < sort_key(object(true))).is_true();
+        DOT_CHECK(sort_key(object(true)) < sort_key(object(-100))).is_true();
+        DOT_CHECK(sort_key(object(-100)) < sort_key(object(-1))).is_true();
+        DOT_CHECK(sort_key(object(-1)) < sort_key(object(0u))).is_true();
+        DOT_CHECK(sort_key(object(0u)) < sort_key(object(short(1)))).is_true();
+        DOT_CHECK(sort_key(object(-9000000000LL)) < sort_key(object(-1))).is_true();
+        DOT_CHECK(sort_key(object(9000000000LL)) < sort_key(object(18000000000000000000uLL))).is_true();
+        DOT_CHECK(sort_key(object(7)) == sort_key(object(7LL))).is_true();
+        DOT_CHECK(sort_key(object(-1.5)) < sort_key(object(-1))).is_true();
+        DOT_CHECK(sort_key(object(1)) < sort_key(object(1.5))).is_true();
+        DOT_CHECK(sort_key(object(7)) == sort_key(object(7.0))).is_true();
+        DOT_CHECK(sort_key(object(1.0)) < sort_key(object(5))).is_true();
+        DOT_CHECK(sort_key(object(-1.5)) < sort_key(object(-0.25f))).is_true();
+        DOT_CHECK(sort_key(object(9007199254740992.0)) < sort_key(object(9007199254740993LL))).is_true();
+        DOT_CHECK(sort_key(object(9007199254740993LL)) < sort_key(object(9007199254740994.0))).is_true();
+        DOT_CHECK(sort_key(object(9223372036854775807LL)) < sort_key(object(9223372036854775808.0))).is_true();
+        DOT_CHECK(sort_key(object(9223372036854775808uLL)) == sort_key(object(9223372036854775808.0))).is_true();
+        DOT_CHECK(sort_key(object(-0.0)) == sort_key(object(0.0))).is_true();
+        DOT_CHECK(sort_key(object(0.0)) < sort_key(object(1e-300))).is_true();
+        DOT_CHECK(sort_key(object(1e300)) < sort_key(object(string("")))).is_true();
+        DOT_CHECK(sort_key(object(string("ab"))) < sort_key(object(string("abc")))).is_true();
+        DOT_CHECK(sort_key(object(string("abc"))) < sort_key(object(string("b")))).is_true();
+        DOT_CHECK(sort_key(object(u32string(U"Я"))) < sort_key(object(u32string(U"Яа")))).is_true();
+        DOT_CHECK(static_cast<byte>(sort_key(object(array(3))).front())) == sort_key_unordered;
+    }
+
+    DOT_TEST_SUITE(sort_mixed_objects)
+    {
+        std::vector<object> objects;
+        objects.emplace_back(string("pear"));
+        objects.emplace_back(3.5);
+        objects.emplace_back(42);
+        objects.emplace_back();
+        objects.emplace_back(string("apple"));
+        objects.emplace_back(-7LL);
+        objects.emplace_back(true);
+        objects.emplace_back(42u);
+        objects.emplace_back(array(1, object(2)));
+        objects.emplace_back(array(1, object(1)));
+        sort(objects);
+        DOT_ENSURE(objects.size()) == 10u;
+        DOT_CHECK(objects[0]).is_null();
+        DOT_CHECK(objects[1].get_as<bool>()).is_true();
+        DOT_CHECK(objects[2].get_as<long long>()) == -7LL;
+        DOT_CHECK(objects[3].get_as<double>()) == 3.5;
+        DOT_CHECK(objects[4].get_as<int>()) == 42;
+        DOT_CHECK(objects[5].get_as<unsigned int>()) == 42u;
+        DOT_CHECK(objects[6].get_as<string>()) == string("apple");
+        DOT_CHECK(objects[7].get_as<string>()) == string("pear");
+        DOT_CHECK(objects[8].get_as<array>().front().get_as<int>()) == 1;
+        DOT_CHECK(objects[9].get_as<array>().front().get_as<int>()) == 2;
+    }
+
+    DOT_TEST_SUITE(sort_parallel_matches_sequential)
+    {
+        std::mt19937_64 random(12345);
+        std::vector<object> numbers, texts;
+        std::vector<long long> expected_numbers;
+        std::vector<string> expected_texts;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const long long number = static_cast<long long>(random() % 20000) - 10000;
+            numbers.emplace_back(number);
+            expected_numbers.push_back(number);
+            const string text = std::to_string(random() % 100000);
+            texts.emplace_back(text);
+            expected_texts.push_back(text);
+        }
+        std::sort(expected_numbers.begin(), expected_numbers.end());
+        std::sort(expected_texts.begin(), expected_texts.end());
+        sort(numbers, 4);
+        sort(texts, 3);
+        bool numbers_sorted = true, texts_sorted = true;
+        for (size_t i = 0; i < numbers.size(); ++i)
+        {
+            numbers_sorted = numbers_sorted && numbers[i].get_as<long long>() == expected_numbers[i];
+            texts_sorted = texts_sorted && texts[i].get_as<string>() == expected_texts[i];
+        }
+        DOT_CHECK(numbers_sorted).is_true();
+        DOT_CHECK(texts_sorted).is_true();
+    }
+
+    DOT_TEST_SUITE(sort_mixed_numbers)
+    {
+        // целые и дробные упорядочены вместе так же, как их сравнивает object::operator <
+        std::mt19937_64 random(2024);
+        std::vector<object> numbers;
+        for (int i = 0; i < 20000; ++i)
+        {
+            const long long whole = static_cast<long long>(random() % 200) - 100;
+            switch (random() % 5)
+            {
+            case 0: numbers.emplace_back(static_cast<int>(whole)); break;
+            case 1: numbers.emplace_back(whole * 1000000007LL); break;
+            case 2: numbers.emplace_back(static_cast<double>(whole) + 0.5); break;
+            case 3: numbers.emplace_back(static_cast<float>(whole)); break;
+            default: numbers.emplace_back(static_cast<unsigned int>(whole + 100)); break;
+            }
+        }
+        numbers.emplace_back(9007199254740993LL);
+        numbers.emplace_back(9007199254740992.0);
+        numbers.emplace_back(18446744073709551615uLL);
+        numbers.emplace_back(-9223372036854775807LL - 1);
+        std::vector<object> expected = numbers;
+        std::stable_sort(expected.begin(), expected.end());
+        sort(numbers, 2);
+        bool same = numbers.size() == expected.size();
+        for (std::size_t i = 0; same && i < numbers.size(); ++i)
+            same = sort_key(numbers[i]) == sort_key(expected[i]);
+        DOT_CHECK(same).is_true();
+        DOT_CHECK(object(5) < object(5.5)).is_true();
+        DOT_CHECK(object(1.0) < object(5)).is_true();
+        DOT_CHECK(object(7) == object(7.0)).is_true();
+        DOT_CHECK(object(-1) < object(0u)).is_true();
+        DOT_CHECK(object(9007199254740993LL) > object(9007199254740992.0)).is_true();
+    }
+
+    DOT_TEST_SUITE(sort_of_shared_ropes)
+    {
+        const rope<string> shared(string("same"));
+        std::vector<object> objects(50000, object(shared));
+        objects.emplace_back(string("first"));
+        sort(objects, 2);
+        DOT_CHECK(objects.front().get_as<string>()) == string("first");
+        DOT_CHECK(objects.back().get_as<string>()) == string("same");
+        DOT_CHECK(shared.bound()) == 50001u;
+    }
+
+    DOT_TEST_SUITE(sort_caps_threads)
+    {
+        // число потоков ограничено ядрами и размером массива, таблицы корзин не растут квадратично
+        std::vector<object> numbers;
+        for (long long i = 0; i < 20000; ++i)
+            numbers.emplace_back((i * 7919) % 20000);
+        DOT_CHECK_NO_EXCEPTION(sort(numbers, 1u << 20));
+        bool sorted = true;
+        for (std::size_t i = 0; i < numbers.size(); ++i)
+            sorted = sorted && numbers[i].get_as<long long>() == static_cast<long long>(i);
+        DOT_CHECK(sorted).is_true();
+    }
+}
+
+// Здесь должен быть Unicode
@@ -0,0 +1,485 @@
+// Тестирование стека трассировки и снимков бэктрейса
+
+#include <dot/test.h>
+#include <dot/fail.h>
+#include <dot/recorder.h>
+#include <dot/profile.h>
+#include <dot/sampler.h>
+#include <dot/watchdog.h>
+#include <dot/allocations.h>
+#include <dot/counters.h>
+#include <dot/box.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+
+namespace dot
+{
+    namespace
+    {
+        std::size_t count_of(const string& text, const string& pattern)
+        {
+            std::size_t count = 0;
+            for (std::size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + 1))
+                ++count;
+            return count;
+        }
+
+        string read_file(const char* path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        std::vector<string> frame_names(const trace::stack& backtrace)
+        {
+            std::vector<string> names;
+            for (const trace::stack::iterator& frame : backtrace)
+                names.push_back(frame.name());
+            return names;
+        }
+    }
+
+    DOT_TEST_SUITE(trace_iteration_does_not_change_stack)
+    {
+        trace::stack backtrace;
+        backtrace.push("outer", "file", 1);
+        backtrace.push("inner", "file", 2);
+        DOT_CHECK(backtrace.depth()) == 2u;
+        std::vector<string> names = frame_names(backtrace);
+        DOT_ENSURE(names.size()) == 2u;
+        DOT_CHECK(names[0]) == string("inner");
+        DOT_CHECK(names[1]) == string("outer");
+        DOT_CHECK(backtrace.depth()) == 2u;
+        DOT_CHECK(string(backtrace.top_name())) == string("inner");
+        DOT_CHECK(backtrace.begin().line()) == 2;
+        backtrace.pop();
+        backtrace.pop();
+        DOT_CHECK(backtrace.empty()).is_true();
+        DOT_CHECK(backtrace.begin() == backtrace.end()).is_true();
+        DOT_CHECK(string(backtrace.top_name())) == string("global");
+    }
+
+    DOT_TEST_SUITE(trace_snapshot_survives_scopes)
+    {
+        trace::stack snapshot;
+        {
+            trace::scope first("first", "file", 10);
+            {
+                trace::scope second("second", "file", 20);
+                snapshot = trace::stack::thread_stack();
+            }
+            // место кадра со снимком занимает новый кадр
+            trace::scope replaced("replaced", "file", 30);
+            const string top = trace::stack::thread_stack().top_name();
+            std::vector<string> names = frame_names(snapshot);
+            DOT_ENSURE(names.size()) >= 2u;
+            DOT_CHECK(names[0]) == string("second");
+            DOT_CHECK(names[1]) == string("first");
+            DOT_CHECK(top) == string("replaced");
+        }
+        std::vector<string> names = frame_names(snapshot);
+        DOT_ENSURE(names.size()) >= 2u;
+        DOT_CHECK(names[0]) == string("second");
+        DOT_CHECK(names[1]) == string("first");
+#if DOT_TRACE_LEVEL > DOT_TRACE_LEVEL_OFF
+        DOT_CHECK(names.back()) == string("trace_snapshot_survives_scopes");
+#endif
+
+        trace::stack copy = snapshot;
+        copy.pop();
+        DOT_CHECK(string(copy.top_name())) == string("first");
+        DOT_CHECK(string(snapshot.top_name())) == string("second");
+        DOT_CHECK(copy.depth() + 1) == snapshot.depth();
+    }
+
+    DOT_TEST_SUITE(trace_error_backtrace_printed)
+    {
+        std::ostringstream output;
+        try
+        {
+            trace::scope failing("failing", "file", 42);
+            throw fail::error("сбой");
+        }
+        catch (const fail::error& error)
+        {
+            DOT_CHECK(string(error.backtrace().top_name())) == string("failing");
+            output << error.backtrace();
+        }
+        const string printed = output.str();
+        DOT_CHECK(printed.find("сбой\n >>-> failing в file(42)\n") == 0).is_true();
+#if DOT_TRACE_LEVEL > DOT_TRACE_LEVEL_OFF
+        DOT_CHECK(printed.find("trace_error_backtrace_printed") != string::npos).is_true();
+#endif
+    }
+
+    DOT_TEST_SUITE(trace_snapshot_crosses_threads)
+    {
+        std::vector<trace::stack> snapshots;
+        std::thread worker([&snapshots]
+        {
+            trace::scope root("worker", "file", 1);
+            for (int i = 0; i < 100; ++i)
+            {
+                trace::scope nested("nested", "file", i);
+                snapshots.push_back(trace::stack::thread_stack());
+            }
+        });
+        worker.join();
+        DOT_ENSURE(snapshots.size()) == 100u;
+        DOT_CHECK(snapshots[57].begin().line()) == 57;
+        DOT_CHECK(frame_names(snapshots[57]).size()) == 2u;
+        DOT_CHECK(string(frame_names(snapshots[99]).back())) == string("worker");
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_sampling_of_root_scopes)
+    {
+        const std::size_t previous = trace::get_sampling();
+        trace::set_sampling(3);
+        std::vector<std::size_t> depths;
+        std::thread worker([&depths]
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                trace::sampled_scope root("root", "file", 1);
+                trace::sampled_scope nested("nested", "file", 2);
+                depths.push_back(trace::stack::thread_stack().depth());
+            }
+            trace::set_sampling(0);
+            trace::sampled_scope skipped("skipped", "file", 3);
+            depths.push_back(trace::stack::thread_stack().depth());
+        });
+        worker.join();
+        trace::set_sampling(previous);
+        DOT_ENSURE(depths.size()) == 7u;
+        DOT_CHECK(depths[0]) == 2u;
+        DOT_CHECK(depths[1]) == 0u;
+        DOT_CHECK(depths[2]) == 0u;
+        DOT_CHECK(depths[3]) == 2u;
+        DOT_CHECK(depths[4]) == 0u;
+        DOT_CHECK(depths[6]) == 0u;
+
+        // вложенный в записанный скоуп выборочный скоуп не корневой
+        trace::scope outer("outer", "file", 4);
+        const std::size_t depth = trace::stack::thread_stack().depth();
+        trace::sampled_scope inner("inner", "file", 5);
+        const std::size_t inner_depth = trace::stack::thread_stack().depth();
+        DOT_CHECK(inner_depth) == depth + 1;
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_recorder_chrome_events)
+    {
+        const char* path = "test_trace_recorder.json";
+        trace::recorder::start(path, 64);
+        const bool recording = trace::recorder::recording();
+        {
+            trace::scope outer("recorded_outer", "dir\\file", 1);
+            trace::scope inner("recorded \"inner\"", "file", 2);
+        }
+        std::thread worker([] { trace::scope scope("recorded_worker", "file", 3); });
+        worker.join();
+        trace::recorder::stop();
+        DOT_CHECK(recording).is_true();
+        DOT_CHECK(trace::recorder::recording()).is_false();
+        DOT_CHECK(trace::recorder::dropped()) == 0u;
+
+        const string events = read_file(path);
+        DOT_CHECK(events.find("{\"traceEvents\":[") == 0).is_true();
+        DOT_CHECK(events.find("\n],\"displayTimeUnit\":\"ns\"}\n") != string::npos).is_true();
+        DOT_CHECK(count_of(events, "\"name\":\"recorded_outer\",\"cat\":\"dot\",\"ph\":\"B\"")) == 1u;
+        DOT_CHECK(count_of(events, "\"file\":\"dir\\\\file\",\"line\":1")) == 1u;
+        DOT_CHECK(count_of(events, "\"name\":\"recorded \\\"inner\\\"\"")) == 1u;
+        DOT_CHECK(count_of(events, "\"name\":\"recorded_worker\"")) == 1u;
+        DOT_CHECK(count_of(events, "\"ph\":\"B\"")) == count_of(events, "\"ph\":\"E\"");
+
+        // переполненный буфер теряет события вместо ожидания выгрузки
+        trace::recorder::start(path, 16);
+        for (int i = 0; i < 100; ++i)
+            trace::scope scope("overflow", "file", i);
+        const std::size_t dropped = trace::recorder::dropped();
+        trace::recorder::stop();
+        DOT_CHECK(dropped) > 0u;
+        std::remove(path);
+    }
+
+    namespace
+    {
+        void profiled_leaf()
+        {
+            trace::scope scope("profiled_leaf", "file", 1);
+        }
+
+        void profiled_root()
+        {
+            trace::scope scope("profiled_root", "file", 2);
+            profiled_leaf();
+            profiled_leaf();
+        }
+
+        // занятое ожидание, чтобы длительность скоупа была не меньше заданной
+        void busy_wait(std::uint64_t nanoseconds)
+        {
+            const std::uint64_t until = trace::now() + nanoseconds;
+            while (trace::now() < until)
+                ;
+        }
+
+        string over_budget_scope;
+        std::uint64_t over_budget_elapsed = 0;
+
+        void remember_over_budget(const trace::stack& backtrace, std::uint64_t elapsed, std::uint64_t)
+        {
+            over_budget_scope = backtrace.top_name();
+            over_budget_elapsed = elapsed;
+        }
+
+        // строка профиля по имени скоупа либо пустая запись
+        record find_row(const array& rows, const char* name)
+        {
+            for (const object& row : rows)
+            {
+                record fields = row.get_as<record>();
+                if (fields.at("name").get_as<string>() == name)
+                    return fields;
+            }
+            return record();
+        }
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_profile_aggregates_scopes)
+    {
+        trace::profile::reset();
+        trace::profile::start();
+        for (int i = 0; i < 10; ++i)
+            profiled_root();
+        std::thread worker([] { profiled_leaf(); });
+        worker.join();
+        trace::profile::stop();
+        profiled_root();
+
+        const array rows = trace::profile::report();
+        const record root = find_row(rows, "profiled_root");
+        const record leaf = find_row(rows, "profiled_leaf");
+        DOT_ENSURE(root.empty()).is_false();
+        DOT_ENSURE(leaf.empty()).is_false();
+        DOT_CHECK(root.at("count").get_as<long long>()) == 10LL;
+        DOT_CHECK(leaf.at("count").get_as<long long>()) == 21LL;
+        DOT_CHECK(root.at("line").get_as<int>()) == 2;
+        DOT_CHECK(root.at("file").get_as<string>()) == string("file");
+
+        // у листового скоупа нет вложенных, его собственное время равно полному
+        DOT_CHECK(root.at("exclusive").get_as<long long>() <= root.at("inclusive").get_as<long long>()).is_true();
+        DOT_CHECK(leaf.at("inclusive").get_as<long long>()) == leaf.at("exclusive").get_as<long long>();
+
+        std::ostringstream table;
+        trace::profile::dump(table);
+        DOT_CHECK(table.str().find("profiled_root в file(2)") != string::npos).is_true();
+
+        trace::profile::reset();
+        DOT_CHECK(find_row(trace::profile::report(), "profiled_root").empty()).is_true();
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_profile_latency_percentiles)
+    {
+        const std::uint64_t slow = 2000000;
+        over_budget_scope.clear();
+        over_budget_elapsed = 0;
+        trace::profile::reset();
+        trace::profile::start();
+        for (int i = 0; i < 90; ++i)
+            trace::scope fast("latency_mixed", "file", 1);
+        for (int i = 0; i < 10; ++i)
+        {
+            trace::scope delayed("latency_mixed", "file", 2);
+            busy_wait(slow);
+        }
+        trace::profile::set_budget_handler(&remember_over_budget);
+        {
+            trace::scope within("latency_budget", "file", 3, std::chrono::seconds(10));
+        }
+        DOT_CHECK(over_budget_scope.empty()).is_true();
+        {
+            trace::scope exceeded("latency_budget", "file", 4, std::chrono::microseconds(100));
+            busy_wait(slow);
+        }
+        trace::profile::set_budget_handler(nullptr);
+        trace::profile::stop();
+
+        DOT_CHECK(over_budget_scope) == string("latency_budget");
+        DOT_CHECK(over_budget_elapsed >= slow).is_true();
+
+        // места с одним именем сводятся, перцентили не меньше истинных значений и точны до 3%;
+        // сверху время не ограничивается: под нагрузкой поток вытесняется посреди скоупа
+        const object mixed = trace::profile::latency("latency_mixed");
+        DOT_ENSURE(mixed.get_data()).is<rope<record>::cow>();
+        const record latency = mixed.get_as<record>();
+        DOT_CHECK(latency.at("count").get_as<long long>()) == 100LL;
+        DOT_CHECK(latency.at("p50").get_as<long long>() < static_cast<long long>(slow / 2)).is_true();
+        DOT_CHECK(latency.at("p90").get_as<long long>() < static_cast<long long>(slow / 2)).is_true();
+        DOT_CHECK(latency.at("p99").get_as<long long>() >= static_cast<long long>(slow)).is_true();
+        DOT_CHECK(latency.at("max").get_as<long long>() >= latency.at("p999").get_as<long long>()).is_true();
+
+        DOT_CHECK(trace::profile::latency("never_called")).is_null();
+        DOT_CHECK(find_row(trace::profile::report(), "latency_budget").at("p50").get_as<long long>() > 0).is_true();
+        trace::profile::reset();
+    }
+
+    namespace
+    {
+        std::mutex stalls_mutex;
+        std::vector<std::pair<string, std::uint64_t>> stalls;
+
+        void remember_stall(std::size_t, const trace::stack& backtrace, std::uint64_t elapsed)
+        {
+            std::lock_guard<std::mutex> lock(stalls_mutex);
+            stalls.emplace_back(backtrace.top_name(), elapsed);
+        }
+
+        std::size_t stalls_of(const string& name)
+        {
+            std::lock_guard<std::mutex> lock(stalls_mutex);
+            std::size_t count = 0;
+            for (const auto& stall : stalls)
+                count += stall.first == name;
+            return count;
+        }
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_watchdog_reports_stalled_scope)
+    {
+        {
+            std::lock_guard<std::mutex> lock(stalls_mutex);
+            stalls.clear();
+        }
+        trace::watchdog::start(std::chrono::milliseconds(40), &remember_stall);
+        DOT_CHECK(trace::watchdog::watching()).is_true();
+        std::thread worker([]
+        {
+            trace::scope outer("watchdog_outer", "file", 1);
+            for (int i = 0; i < 20; ++i)
+                trace::scope quick("watchdog_quick", "file", 2);
+            trace::scope stalled("watchdog_stalled", "file", 3);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        });
+        worker.join();
+        trace::watchdog::stop();
+        DOT_CHECK(trace::watchdog::watching()).is_false();
+
+        // о зависшем скоупе сообщается один раз, внешний покрыт тем же сообщением
+        DOT_CHECK(stalls_of("watchdog_stalled")) == 1u;
+        DOT_CHECK(stalls_of("watchdog_outer")) == 0u;
+        DOT_CHECK(stalls_of("watchdog_quick")) == 0u;
+        std::lock_guard<std::mutex> lock(stalls_mutex);
+        for (const auto& stall : stalls)
+            if (stall.first == "watchdog_stalled")
+                DOT_CHECK(stall.second >= 40000000u).is_true();
+    }
+
+#ifndef _WIN32
+    DOT_TEST_SUITE_EXCLUSIVE(trace_allocations_by_scope)
+    {
+        DOT_ENSURE(trace::allocations::hooked()).is_true();
+        std::vector<std::unique_ptr<int[]>> kept;
+        kept.reserve(10);
+        trace::allocations::reset();
+        trace::allocations::start();
+        {
+            trace::scope keeper("allocations_keeper", "file", 1);
+            for (int i = 0; i < 10; ++i)
+                kept.emplace_back(new int[16]);
+        }
+        {
+            trace::scope temporary("allocations_temporary", "file", 2);
+            // без барьера компилятор вправе убрать пару new и delete целиком
+            for (int i = 0; i < 5; ++i)
+            {
+                char* block = new char[100];
+                test::benchmark::keep(block);
+                delete[] block;
+            }
+        }
+        trace::allocations::stop();
+
+        const record keeper = find_row(trace::allocations::report(), "allocations_keeper");
+        const record temporary = find_row(trace::allocations::report(), "allocations_temporary");
+        DOT_ENSURE(keeper.empty()).is_false();
+        DOT_ENSURE(temporary.empty()).is_false();
+        DOT_CHECK(keeper.at("count").get_as<long long>()) == 10LL;
+        DOT_CHECK(keeper.at("bytes").get_as<long long>()) == static_cast<long long>(10 * 16 * sizeof(int));
+        DOT_CHECK(keeper.at("live").get_as<long long>()) == static_cast<long long>(10 * 16 * sizeof(int));
+        DOT_CHECK(keeper.at("per_second").get_as<double>() > 0.0).is_true();
+        DOT_CHECK(temporary.at("count").get_as<long long>()) == 5LL;
+        DOT_CHECK(temporary.at("bytes").get_as<long long>()) == 500LL;
+        DOT_CHECK(temporary.at("live").get_as<long long>()) == 0LL;
+
+        // освобождение после остановки учёта уменьшает живые байты выделившего скоупа
+        kept.clear();
+        DOT_CHECK(find_row(trace::allocations::report(), "allocations_keeper").at("live").get_as<long long>()) == 0LL;
+
+        std::ostringstream table;
+        trace::allocations::dump(table);
+        DOT_CHECK(table.str().find("allocations_temporary в file(2)") != string::npos).is_true();
+        trace::allocations::reset();
+    }
+
+    DOT_TEST_SUITE_EXCLUSIVE(trace_sampler_folded_stacks)
+    {
+        trace::sampler::reset();
+        trace::sampler::start(std::chrono::microseconds(500));
+        DOT_CHECK(trace::sampler::sampling()).is_true();
+        {
+            trace::scope outer("sampler_outer", "file", 1);
+            trace::scope inner("sampler_inner", "file", 2);
+            busy_wait(200000000);
+        }
+        trace::sampler::stop();
+        DOT_CHECK(trace::sampler::sampling()).is_false();
+
+        // строки свёрнутых стеков от корня к вершине с числом выборок в конце
+        std::ostringstream folded;
+        trace::sampler::dump(folded);
+        const string text = folded.str();
+        const std::size_t at = text.find("sampler_outer;sampler_inner ");
+        DOT_ENSURE(at != string::npos).is_true();
+        const std::size_t count = std::stoul(text.substr(text.find(' ', at) + 1));
+        DOT_CHECK(count > 0u).is_true();
+        DOT_CHECK(trace::sampler::samples() >= count).is_true();
+
+        trace::sampler::reset();
+        DOT_CHECK(trace::sampler::samples()) == 0u;
+    }
+#endif
+
+    // без доступа к счётчикам набор проверяет только отказ без ошибок
+    DOT_TEST_SUITE(trace_counters_around_code)
+    {
+        trace::counters group;
+        group.start();
+        busy_wait(1000000);
+        const trace::counters::values values = group.stop();
+        DOT_CHECK(group.available()) == trace::counters::supported();
+        if (!group.available())
+        {
+            DOT_CHECK(values.cycles) == -1;
+            DOT_CHECK(values.ipc() < 0).is_true();
+            return;
+        }
+        DOT_CHECK(values.cycles > 0).is_true();
+        DOT_CHECK(values.instructions > 0).is_true();
+        DOT_CHECK(values.ipc() > 0).is_true();
+
+        trace::counters::values total = values;
+        total += values;
+        DOT_CHECK(total.instructions) == 2 * values.instructions;
+    }
+}
+
+// Здесь должен быть Unicode